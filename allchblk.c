@@ -26,7 +26,10 @@ int GC_use_entire_heap = FALSE;
 /*
  * Free heap blocks are kept on one of several free lists, depending on
  * the size of the block.  Each free list is doubly linked.  Adjacent
- * free blocks are coalesced.
+ * free blocks are coalesced.  The lists for the larger sizes form
+ * a two-level segregated-fit index: the sizes between two adjacent powers
+ * of two are split evenly into a fixed number of classes.  A bitmap of the
+ * nonempty lists lets the allocator skip the empty ones in constant time.
  */
 
 /*
@@ -35,20 +38,31 @@ int GC_use_entire_heap = FALSE;
  */
 #define MAX_BLACK_LIST_ALLOC (2 * HBLKSIZE)
 
-/* Sizes up to this many `hblk` entities each have their own free list. */
-#define UNIQUE_THRESHOLD 32
+/*
+ * Sizes up to this many `hblk` entities each have their own free list.
+ * Should be a power of two.
+ */
+#define LOG_UNIQUE_THRESHOLD 5
+#define UNIQUE_THRESHOLD (1 << LOG_UNIQUE_THRESHOLD)
 
 /*
  * Sizes of at least this many heap blocks are mapped to a single free
  * list.
  */
-#define HUGE_THRESHOLD 256
+#define LOG_HUGE_THRESHOLD 16
+#define HUGE_THRESHOLD (1 << LOG_HUGE_THRESHOLD)
 
-/* In between sizes map this many distinct sizes to a single bin. */
-#define FL_COMPRESSION 8
+/*
+ * In between sizes, the ones of the same binary logarithm are mapped to
+ * this many bins (i.e., the sizes of a bin differ by not more than 1/8 of
+ * the smallest one).
+ */
+#define LOG_FL_SUBCLASSES 3
+#define FL_SUBCLASSES (1 << LOG_FL_SUBCLASSES)
 
-#define N_HBLK_FLS \
-  ((HUGE_THRESHOLD - UNIQUE_THRESHOLD) / FL_COMPRESSION + UNIQUE_THRESHOLD)
+#define N_HBLK_FLS                                             \
+  ((LOG_HUGE_THRESHOLD - LOG_UNIQUE_THRESHOLD) * FL_SUBCLASSES \
+   + UNIQUE_THRESHOLD + 1)
 
 /*
  * List of completely empty heap blocks.  Linked through `hb_next` field
@@ -80,15 +94,73 @@ STATIC
 #endif
 word GC_free_bytes[N_HBLK_FLS + 1] = { 0 };
 
+/*
+ * A bit per each element of `GC_hblkfreelist`, set if and only if the list
+ * is nonempty.
+ */
+#define HBLK_FLS_MAP_SZ ((N_HBLK_FLS + CPP_WORDSZ) / CPP_WORDSZ)
+STATIC word GC_hblk_fls_nonempty[HBLK_FLS_MAP_SZ] = { 0 };
+
+#define SET_HBLK_FL_NONEMPTY(index)                \
+  (void)(GC_hblk_fls_nonempty[(index) / CPP_WORDSZ] \
+         |= (word)1 << ((index) % CPP_WORDSZ))
+#define CLEAR_HBLK_FL_NONEMPTY(index)              \
+  (void)(GC_hblk_fls_nonempty[(index) / CPP_WORDSZ] \
+         &= ~((word)1 << ((index) % CPP_WORDSZ)))
+
 #ifndef GC_NO_DEINIT
 GC_INNER void
 GC_reset_freelist(void)
 {
   BZERO(GC_hblkfreelist, sizeof(GC_hblkfreelist));
   BZERO(GC_free_bytes, sizeof(GC_free_bytes));
+  BZERO(GC_hblk_fls_nonempty, sizeof(GC_hblk_fls_nonempty));
 }
 #endif
 
+/* Return the index of the lowest set bit of a nonzero word. */
+GC_INLINE size_t
+lowest_bit_index(word w)
+{
+  GC_ASSERT(w != 0);
+#if GC_GNUC_PREREQ(3, 4) || defined(__clang__)
+#  if CPP_WORDSZ > 32
+  return (size_t)__builtin_ctzll((unsigned long long)w);
+#  else
+  return (size_t)__builtin_ctz((unsigned)w);
+#  endif
+#else
+  {
+    size_t i = 0;
+
+    for (; (w & 1) == 0; w >>= 1)
+      i++;
+    return i;
+  }
+#endif
+}
+
+/*
+ * Return the lowest index (not less than `index`) of a nonempty free list,
+ * or a value greater than `N_HBLK_FLS` if there is no such list.
+ */
+STATIC size_t
+GC_next_nonempty_hblk_fl(size_t index)
+{
+  size_t i = index / CPP_WORDSZ;
+  word w;
+
+  if (UNLIKELY(index > N_HBLK_FLS))
+    return index;
+  w = GC_hblk_fls_nonempty[i] & (GC_WORD_MAX << (index % CPP_WORDSZ));
+  while (0 == w) {
+    if (++i == HBLK_FLS_MAP_SZ)
+      return N_HBLK_FLS + 1;
+    w = GC_hblk_fls_nonempty[i];
+  }
+  return i * CPP_WORDSZ + lowest_bit_index(w);
+}
+
 /*
  * Return the largest `n` such that the number of free bytes on lists
  * `n` .. `N_HBLK_FLS` is greater or equal to `GC_max_large_allocd_bytes`
@@ -113,12 +185,25 @@ GC_enough_large_bytes_left(void)
 STATIC size_t
 GC_hblk_fl_from_blocks(size_t blocks_needed)
 {
+  size_t log_sz;
+
   if (blocks_needed <= UNIQUE_THRESHOLD)
     return blocks_needed;
   if (blocks_needed >= HUGE_THRESHOLD)
     return N_HBLK_FLS;
-  return (blocks_needed - UNIQUE_THRESHOLD) / FL_COMPRESSION
-         + UNIQUE_THRESHOLD;
+
+  /* Compute the binary logarithm of `blocks_needed`. */
+#if GC_GNUC_PREREQ(3, 4) || defined(__clang__)
+  log_sz = sizeof(unsigned) * 8 - 1
+           - (size_t)__builtin_clz((unsigned)blocks_needed);
+#else
+  for (log_sz = LOG_UNIQUE_THRESHOLD; (blocks_needed >> (log_sz + 1)) != 0;)
+    log_sz++;
+#endif
+  GC_ASSERT(log_sz >= LOG_UNIQUE_THRESHOLD && log_sz < LOG_HUGE_THRESHOLD);
+  return UNIQUE_THRESHOLD + 1 + (log_sz - LOG_UNIQUE_THRESHOLD) * FL_SUBCLASSES
+         + ((blocks_needed >> (log_sz - LOG_FL_SUBCLASSES))
+            & (FL_SUBCLASSES - 1));
 }
 
 #define PHDR(hhdr) HDR((hhdr)->hb_prev)
@@ -437,6 +522,8 @@ GC_remove_from_fl_at(hdr *hhdr, size_t index)
   if (NULL == hhdr->hb_prev) {
     GC_ASSERT(HDR(GC_hblkfreelist[index]) == hhdr);
     GC_hblkfreelist[index] = hhdr->hb_next;
+    if (NULL == hhdr->hb_next)
+      CLEAR_HBLK_FL_NONEMPTY(index);
   } else {
     hdr *phdr;
     GET_HDR(hhdr->hb_prev, phdr);
@@ -527,6 +614,7 @@ GC_add_to_fl(struct hblk *h, hdr *hhdr)
 #endif
   GC_ASSERT(modHBLKSZ(hhdr->hb_sz) == 0);
   GC_hblkfreelist[index] = h;
+  SET_HBLK_FL_NONEMPTY(index);
   GC_free_bytes[index] += hhdr->hb_sz;
   GC_ASSERT(GC_free_bytes[index] <= GC_large_free_bytes);
   hhdr->hb_next = second;
@@ -615,6 +703,31 @@ GC_adjust_num_unmapped(struct hblk *h, const hdr *hhdr)
 #  endif
 }
 
+/*
+ * Unmap the free block `h` (which is mapped), unless this would create too
+ * many unmapped regions.  Returns `FALSE` in the latter case.
+ */
+static GC_bool
+unmap_free_hblk(struct hblk *h, hdr *hhdr)
+{
+#  ifdef COUNT_UNMAPPED_REGIONS
+  /*
+   * Continue with unmapping the block only if it will not create too many
+   * unmapped regions, or if unmapping reduces the number of regions.
+   */
+  int delta = calc_num_unmapped_regions_delta(h, hhdr);
+  GC_signed_word regions = GC_num_unmapped_regions + delta;
+
+  if (delta >= 0 && regions >= GC_UNMAPPED_REGIONS_SOFT_LIMIT)
+    return FALSE;
+  GC_num_unmapped_regions = regions;
+#  endif
+  GC_ASSERT(IS_MAPPED(hhdr));
+  GC_unmap((ptr_t)h, hhdr->hb_sz);
+  hhdr->hb_flags |= WAS_UNMAPPED;
+  return TRUE;
+}
+
 GC_INNER void
 GC_unmap_old(unsigned threshold)
 {
@@ -643,24 +756,10 @@ GC_unmap_old(unsigned threshold)
        * The truncated counter value wrapping is handled correctly.
        */
       if ((unsigned short)(GC_gc_no - hhdr->hb_last_reclaimed)
-          >= (unsigned short)threshold) {
-#  ifdef COUNT_UNMAPPED_REGIONS
-        /*
-         * Continue with unmapping the block only if it will not create
-         * too many unmapped regions, or if unmapping reduces the number
-         * of regions.
-         */
-        int delta = calc_num_unmapped_regions_delta(h, hhdr);
-        GC_signed_word regions = GC_num_unmapped_regions + delta;
-
-        if (delta >= 0 && regions >= GC_UNMAPPED_REGIONS_SOFT_LIMIT) {
-          GC_COND_LOG_PRINTF("Unmapped regions limit reached!\n");
-          return;
-        }
-        GC_num_unmapped_regions = regions;
-#  endif
-        GC_unmap((ptr_t)h, hhdr->hb_sz);
-        hhdr->hb_flags |= WAS_UNMAPPED;
+              >= (unsigned short)threshold
+          && !unmap_free_hblk(h, hhdr)) {
+        GC_COND_LOG_PRINTF("Unmapped regions limit reached!\n");
+        return;
       }
     }
   }
@@ -672,6 +771,7 @@ GC_merge_unmapped(void)
   size_t i;
   GC_bool merged = FALSE;
 
+  GC_hdr_update_begin();
   for (i = 0; i <= N_HBLK_FLS; ++i) {
     struct hblk *h = GC_hblkfreelist[i];
 
@@ -747,6 +847,7 @@ GC_merge_unmapped(void)
       h = GC_hblkfreelist[i];
     }
   }
+  GC_hdr_update_end();
   return merged;
 }
 
@@ -862,11 +963,12 @@ GC_allochblk(size_t lb_adjusted, int kind,
     return NULL; /* overflow */
 
   start_list = GC_hblk_fl_from_blocks(blocks);
+  GC_hdr_update_begin();
   /* Try for an exact match first. */
   result = GC_allochblk_nth(lb_adjusted, kind, flags, start_list, FALSE,
                             align_m1);
   if (result != NULL)
-    return result;
+    goto done;
 
   may_split = TRUE;
   if (GC_use_entire_heap || GC_dont_gc
@@ -900,12 +1002,16 @@ GC_allochblk(size_t lb_adjusted, int kind,
      */
     ++start_list;
   }
-  for (; start_list <= split_limit; ++start_list) {
+  for (start_list = GC_next_nonempty_hblk_fl(start_list);
+       start_list <= split_limit;
+       start_list = GC_next_nonempty_hblk_fl(start_list + 1)) {
     result = GC_allochblk_nth(lb_adjusted, kind, flags, start_list, may_split,
                               align_m1);
     if (result != NULL)
       break;
   }
+done:
+  GC_hdr_update_end();
   return result;
 }
 
@@ -1247,8 +1353,12 @@ GC_free_profiler_hook(void *p)
 }
 #endif /* VALGRIND_TRACKING */
 
-GC_INNER void
-GC_freehblk(struct hblk *hbp)
+/*
+ * Same as `GC_freehblk` but returns the free block (probably coalesced
+ * with its neighbors) containing `hbp`.
+ */
+static struct hblk *
+free_hblk_and_coalesce(struct hblk *hbp)
 {
   const struct hblk *next;
   struct hblk *prev;
@@ -1265,6 +1375,7 @@ GC_freehblk(struct hblk *hbp)
      */
     ABORT("Deallocating excessively large block.  Too large an allocation?");
   }
+  GC_hdr_update_begin();
   GC_remove_counts(hbp, size);
   hhdr->hb_sz = size;
 #ifdef USE_MUNMAP
@@ -1325,4 +1436,31 @@ GC_freehblk(struct hblk *hbp)
 
   GC_large_free_bytes += size;
   GC_add_to_fl(hbp, hhdr);
+  GC_hdr_update_end();
+  return hbp;
+}
+
+GC_INNER void
+GC_freehblk(struct hblk *hbp)
+{
+  (void)free_hblk_and_coalesce(hbp);
+}
+
+#ifdef USE_MUNMAP
+GC_INNER void
+GC_free_large_hblk(struct hblk *hbp)
+{
+  GC_bool is_huge = HDR(hbp)->hb_sz >= MUNMAP_HUGE_OBJ_BYTES;
+  struct hblk *h = free_hblk_and_coalesce(hbp);
+
+  if (is_huge && GC_unmap_threshold > 0 && !GC_collection_in_progress()) {
+    /*
+     * Return the memory to the OS right away instead of waiting for
+     * `GC_unmap_old()`; the block will be remapped on reuse.  Not done
+     * while the marking is in progress as the mark stack might still
+     * reference the block.
+     */
+    (void)unmap_free_hblk(h, HDR(h));
+  }
 }
+#endif
@@ -125,6 +125,29 @@ GC_get_avg_stopped_mark_time_ns(void)
   return total_time * (1000UL * 1000) / divisor;
 }
 
+#  ifdef THREADS
+/*
+ * Update the world-stop latency statistic given the time when the world
+ * stop has been started.
+ */
+STATIC void
+GC_update_world_stop_time(CLOCK_TYPE start_time)
+{
+  CLOCK_TYPE current_time;
+  word time_ns;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GET_TIME(current_time);
+  time_ns = (word)MS_TIME_DIFF(current_time, start_time) * (word)1000000
+            + NS_FRAC_TIME_DIFF(current_time, start_time);
+  GC_world_stop_total_ns += time_ns; /*< may wrap */
+  if (time_ns > GC_world_stop_max_ns)
+    GC_world_stop_max_ns = time_ns;
+  GC_COND_LOG_PRINTF("World stop took %lu us\n",
+                     (unsigned long)(time_ns / 1000));
+}
+#  endif
+
 #endif /* !NO_CLOCK */
 
 GC_API int GC_CALL
@@ -153,6 +176,73 @@ GC_INNER GC_bool GC_world_stopped = FALSE;
 
 STATIC GC_bool GC_disable_automatic_collection = FALSE;
 
+#ifdef CONCURRENT_MARK
+GC_INNER GC_bool GC_concurrent_mark = FALSE;
+GC_INNER volatile AO_t GC_concurrent_mark_credit = 0;
+#endif
+
+GC_API void GC_CALL
+GC_set_concurrent_mark(int value)
+{
+#ifdef CONCURRENT_MARK
+  if (value && GC_is_initialized) {
+    /* The marker thread acquires the allocator lock. */
+    set_need_to_lock();
+  }
+  LOCK();
+  GC_concurrent_mark = value != 0;
+  UNLOCK();
+#else
+  UNUSED_ARG(value);
+#endif
+}
+
+GC_API int GC_CALL
+GC_get_concurrent_mark(void)
+{
+#ifdef CONCURRENT_MARK
+  int value;
+
+  READER_LOCK();
+  value = (int)GC_concurrent_mark;
+  READER_UNLOCK();
+  return value;
+#else
+  return 0;
+#endif
+}
+
+GC_API void GC_CALL
+GC_set_background_sweep(int value)
+{
+#ifdef BACKGROUND_SWEEP
+  if (value && GC_is_initialized) {
+    /* The sweeper thread acquires the allocator lock. */
+    set_need_to_lock();
+  }
+  LOCK();
+  GC_background_sweep = value != 0;
+  UNLOCK();
+#else
+  UNUSED_ARG(value);
+#endif
+}
+
+GC_API int GC_CALL
+GC_get_background_sweep(void)
+{
+#ifdef BACKGROUND_SWEEP
+  int value;
+
+  READER_LOCK();
+  value = (int)GC_background_sweep;
+  READER_UNLOCK();
+  return value;
+#else
+  return 0;
+#endif
+}
+
 GC_API void GC_CALL
 GC_set_disable_automatic_collection(int value)
 {
@@ -331,6 +421,7 @@ GC_timeout_stop_func(void)
 
 #ifdef THREADS
 GC_INNER word GC_total_stacksize = 0;
+GC_INNER word GC_stack_skipped_bytes = 0;
 #endif
 
 /* The lowest value returned by `min_bytes_allocd()`. */
@@ -350,21 +441,18 @@ GC_get_min_bytes_allocd(void)
 }
 
 /*
- * Return the minimum number of bytes that must be allocated between
- * collections to amortize the cost of the latter.  Should be nonzero.
+ * Return an estimate of the amount of memory to be scanned during
+ * a normal collection.
  */
 static word
-min_bytes_allocd(void)
+scan_size_estimate(void)
 {
-  word result;
   word stack_size;
   /*
    * Total size of roots, it includes double stack size, since the stack
    * is expensive to scan.
    */
   word total_root_size;
-  /* Estimate of memory to be scanned during normal collection. */
-  word scan_size;
 
   GC_ASSERT(I_HOLD_LOCK());
 #ifdef THREADS
@@ -391,8 +479,18 @@ min_bytes_allocd(void)
   }
 
   total_root_size = 2 * stack_size + GC_root_size;
-  scan_size = 2 * GC_composite_in_use + GC_atomic_in_use / 4 + total_root_size;
-  result = scan_size / GC_free_space_divisor;
+  return 2 * GC_composite_in_use + GC_atomic_in_use / 4 + total_root_size;
+}
+
+/*
+ * Return the minimum number of bytes that must be allocated between
+ * collections to amortize the cost of the latter.  Should be nonzero.
+ */
+static word
+min_bytes_allocd(void)
+{
+  word result = scan_size_estimate() / GC_free_space_divisor;
+
   if (GC_incremental) {
     result /= 2;
   }
@@ -443,6 +541,235 @@ GC_adj_bytes_allocd(void)
   return (word)result;
 }
 
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+/*
+ * The target mutator utilization (in percent) of the incremental
+ * collection pacer.  Zero means the pacer is off.
+ */
+STATIC unsigned GC_mutator_utilization = 0;
+
+GC_API void GC_CALL
+GC_set_mutator_utilization(int value)
+{
+  /* Clamp the value to the valid range (`100 - u` should be nonzero). */
+  if (value <= 0) {
+    value = 0;
+  } else if (value > 99) {
+    value = 99;
+  }
+  GC_mutator_utilization = (unsigned)value;
+}
+
+GC_API int GC_CALL
+GC_get_mutator_utilization(void)
+{
+  return (int)GC_mutator_utilization;
+}
+
+/*
+ * Is the pacer in use?  The time limit is its target of the maximum
+ * pause.
+ */
+#  define PACER_ON()                                     \
+    (GC_mutator_utilization > 0 && GC_incremental       \
+     && GC_time_limit != GC_TIME_UNLIMITED)
+
+/* The number of microseconds elapsed from `b` to `a`. */
+#  define US_TIME_DIFF(a, b) \
+    ((word)MS_TIME_DIFF(a, b) * 1000 + NS_FRAC_TIME_DIFF(a, b) / 1000)
+
+/*
+ * The state of the pacer, all accessed holding the allocator lock.
+ * The rates are averaged over the recent collections; zero means the
+ * rate has not been measured yet.  The collector work includes
+ * everything done by `GC_collect_a_little_inner()`, i.e. marking,
+ * the world-stopped phases and the start of sweeping.
+ */
+
+/* Scanned bytes (see `scan_size_estimate`) per microsecond of work. */
+static word pacer_scan_rate;
+
+/* Allocated bytes per microsecond of the mutator (non-collector) time. */
+static word pacer_alloc_rate;
+
+/* The value of `GC_gc_no` at the start of the measured period. */
+static word pacer_gc_no;
+
+/* The time and the total allocated bytes at the start of the period. */
+static CLOCK_TYPE pacer_period_start;
+static word pacer_period_allocd;
+
+/* The collector work time spent since the start of the period. */
+static word pacer_gc_us;
+
+/* The time and the total allocated bytes at the end of the last step. */
+static CLOCK_TYPE pacer_step_end;
+static word pacer_step_allocd;
+
+/*
+ * The free space after the last collection, and the expected time of
+ * the collector work of the next collection (both set along with the
+ * trigger by `pacer_min_bytes_allocd`).
+ */
+static word pacer_runway;
+static word pacer_work_us;
+
+/* Return `v * num / den` saturated to `GC_WORD_MAX`. */
+static word
+mul_div_sat(word v, unsigned num, unsigned den)
+{
+  GC_ASSERT(num > 0 && den > 0);
+  if (v / den > GC_WORD_MAX / num)
+    return GC_WORD_MAX;
+  return v / den * num + v % den * num / den;
+}
+
+/*
+ * Return the amount of allocation (since the last collection) at which
+ * the next collection should start so that its marking completes,
+ * at the target mutator utilization, before the free space is used up
+ * (and the heap has to grow).  Returns `GC_WORD_MAX` if the rates are
+ * not measured yet, or if this is not achievable.
+ */
+static word
+pacer_min_bytes_allocd(void)
+{
+  unsigned u = GC_mutator_utilization;
+  word live = GC_composite_in_use + GC_atomic_in_use;
+  word mut_us;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(u > 0 && u < 100);
+  pacer_runway = GC_heapsize > live ? GC_heapsize - live : 0;
+  if (0 == pacer_scan_rate)
+    return GC_WORD_MAX;
+  pacer_work_us = scan_size_estimate() / pacer_scan_rate;
+  if (0 == pacer_alloc_rate)
+    return GC_WORD_MAX;
+
+  /*
+   * The mutator time during the collection, given the collector work
+   * takes `100 - u` percent of the time.
+   */
+  mut_us = mul_div_sat(pacer_work_us, u, 100 - u);
+  if (mut_us > 0 && pacer_alloc_rate >= pacer_runway / mut_us) {
+    /*
+     * The heap has to grow anyway, starting the collection immediately
+     * would just make the collections back-to-back.
+     */
+    return GC_WORD_MAX;
+  }
+  return pacer_runway - pacer_alloc_rate * mut_us;
+}
+
+/*
+ * Do the marking work of the collection in progress for the current
+ * allocation slow path as determined by the pacer.  The amount of work
+ * is the larger of the one needed to keep the target mutator utilization
+ * (based on the mutator time since the previous step) and the one needed
+ * to complete the marking before the free space is used up (based on the
+ * bytes allocated since the previous step), but it is limited by the
+ * target maximum pause.  `start` is the time the step started at.
+ * Returns `TRUE` if the marking is complete.
+ */
+static GC_bool
+pacer_mark_some(CLOCK_TYPE start)
+{
+  unsigned u = GC_mutator_utilization;
+  word limit_us = (word)GC_time_limit * 1000 + GC_time_lim_nsec / 1000;
+  word budget_us, mut_us, allocd, allocd_since_gc, work_left_us;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  mut_us = US_TIME_DIFF(start, pacer_step_end);
+  budget_us = mul_div_sat(mut_us, 100 - u, u);
+
+  allocd = GC_bytes_allocd + GC_bytes_allocd_before_gc - pacer_step_allocd;
+  allocd_since_gc = GC_adj_bytes_allocd();
+  work_left_us = pacer_work_us > pacer_gc_us ? pacer_work_us - pacer_gc_us
+                                             : pacer_work_us / 8;
+  if (allocd > 0 && budget_us < limit_us) {
+    word runway_left = pacer_runway > allocd_since_gc
+                           ? pacer_runway - allocd_since_gc
+                           : 0;
+    word assist_us = runway_left <= allocd
+                         ? limit_us
+                         : work_left_us / (runway_left / allocd);
+
+    if (assist_us > budget_us)
+      budget_us = assist_us;
+  }
+  if (budget_us > limit_us)
+    budget_us = limit_us;
+
+  for (;;) {
+    CLOCK_TYPE current_time;
+
+    if (GC_mark_some(NULL))
+      return TRUE;
+    GET_TIME(current_time);
+    if (US_TIME_DIFF(current_time, start) >= budget_us)
+      break;
+  }
+  return FALSE;
+}
+
+/*
+ * Account the collector work done from `start` till now, and update
+ * the measured rates if a collection has been completed since the
+ * previous call.
+ */
+static void
+pacer_update(CLOCK_TYPE start)
+{
+  CLOCK_TYPE current_time;
+  word total_allocd = GC_bytes_allocd + GC_bytes_allocd_before_gc;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GET_TIME(current_time);
+  pacer_gc_us += US_TIME_DIFF(current_time, start);
+  pacer_step_end = current_time;
+  pacer_step_allocd = total_allocd;
+  if (pacer_gc_no == GC_gc_no)
+    return;
+
+  if (pacer_gc_no != 0 && pacer_gc_us > 0) {
+    word period_us = US_TIME_DIFF(current_time, pacer_period_start);
+    word scan_rate = scan_size_estimate() / pacer_gc_us;
+
+    pacer_scan_rate = pacer_scan_rate != 0
+                          ? (pacer_scan_rate + scan_rate) / 2
+                          : scan_rate;
+    if (period_us > pacer_gc_us) {
+      word alloc_rate
+          = (total_allocd - pacer_period_allocd) / (period_us - pacer_gc_us);
+
+      pacer_alloc_rate = pacer_alloc_rate != 0
+                             ? (pacer_alloc_rate + alloc_rate) / 2
+                             : alloc_rate;
+    }
+    GC_COND_LOG_PRINTF("Pacer: scan rate %lu, alloc rate %lu bytes/us\n",
+                       (unsigned long)pacer_scan_rate,
+                       (unsigned long)pacer_alloc_rate);
+  }
+  pacer_gc_no = GC_gc_no;
+  pacer_period_start = current_time;
+  pacer_period_allocd = total_allocd;
+  pacer_gc_us = 0;
+}
+#else
+GC_API void GC_CALL
+GC_set_mutator_utilization(int value)
+{
+  UNUSED_ARG(value);
+}
+
+GC_API int GC_CALL
+GC_get_mutator_utilization(void)
+{
+  return 0;
+}
+#endif /* GC_DISABLE_INCREMENTAL || NO_CLOCK */
+
 /*
  * Clear up a few frames worth of garbage left at the top of the stack.
  * This is used to prevent us from accidentally treating garbage left
@@ -482,8 +809,23 @@ GC_should_collect(void)
   static word last_min_bytes_allocd, last_gc_no;
 
   GC_ASSERT(I_HOLD_LOCK());
+#ifdef SIZE_CLASS_LOCKS
+  GC_add_class_bytes();
+#endif
   if (last_gc_no != GC_gc_no) {
     last_min_bytes_allocd = min_bytes_allocd();
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+    if (PACER_ON()) {
+      word pacer_allocd = pacer_min_bytes_allocd();
+
+      /* The pacer may only start the collection earlier. */
+      if (pacer_allocd < last_min_bytes_allocd) {
+        last_min_bytes_allocd = pacer_allocd > min_bytes_allocd_minimum
+                                    ? pacer_allocd
+                                    : min_bytes_allocd_minimum;
+      }
+    }
+#endif
     last_gc_no = GC_gc_no;
   }
 #ifndef GC_DISABLE_INCREMENTAL
@@ -528,6 +870,19 @@ GC_get_start_callback(void)
   return fn;
 }
 
+#ifdef CONCURRENT_MARK
+/*
+ * The stop function used to start a collection in the mostly-concurrent
+ * marking mode: only the dirty bits are read with the world stopped,
+ * all the marking is left to the background marker.
+ */
+STATIC int GC_CALLBACK
+GC_concurrent_start_stop_func(void)
+{
+  return TRUE;
+}
+#endif
+
 GC_INLINE void
 GC_notify_full_gc(void)
 {
@@ -559,7 +914,7 @@ GC_maybe_gc(void)
   GC_ASSERT(!GC_collection_in_progress());
 #ifdef PARALLEL_MARK
   if (GC_parallel)
-    GC_wait_for_reclaim();
+    GC_finish_parallel_sweep();
 #endif
   if (GC_need_full_gc || GC_n_partial_gcs >= GC_full_freq) {
     GC_COND_LOG_PRINTF(
@@ -581,6 +936,18 @@ GC_maybe_gc(void)
    * Try to mark with the world stopped.  If we run out of time, then this
    * turns into an incremental marking.
    */
+#ifdef CONCURRENT_MARK
+  if (GC_concurrent_mark && GC_parallel) {
+    if (!GC_stopped_mark(GC_concurrent_start_stop_func)) {
+      /* Count this as the first attempt as usual. */
+      if (!GC_is_full_gc)
+        GC_n_attempts++;
+      AO_store(&GC_concurrent_mark_credit, 0);
+      (void)GC_request_concurrent_mark();
+    }
+    return;
+  }
+#endif
 #ifndef NO_CLOCK
   if (GC_time_limit != GC_TIME_UNLIMITED)
     GET_TIME(GC_start_time);
@@ -662,7 +1029,7 @@ GC_try_to_collect_inner(GC_stop_func stop_func)
    */
 #ifdef PARALLEL_MARK
   if (GC_parallel)
-    GC_wait_for_reclaim();
+    GC_finish_parallel_sweep();
 #endif
   ENTER_GC();
   if ((GC_find_leak_inner || stop_func != GC_never_stop_func)
@@ -779,35 +1146,56 @@ GC_INNER void
 GC_collect_a_little_inner(size_t n_blocks)
 {
   IF_CANCEL(int cancel_state;)
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+  GC_bool pacer_on;
+  CLOCK_TYPE start_time = CLOCK_TYPE_INITIALIZER;
+#endif
 
   GC_ASSERT(I_HOLD_LOCK());
   GC_ASSERT(GC_is_initialized);
   DISABLE_CANCEL(cancel_state);
+  GC_stop_concurrent_drain();
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+  pacer_on = PACER_ON();
+  if (pacer_on)
+    GET_TIME(start_time);
+#endif
   if (GC_incremental && GC_collection_in_progress()) {
     size_t i;
     size_t max_deficit = GC_rate * n_blocks;
+    GC_bool mark_done = FALSE;
 
     ENTER_GC();
 #ifdef PARALLEL_MARK
     if (GC_time_limit != GC_TIME_UNLIMITED)
       GC_parallel_mark_disabled = TRUE;
 #endif
-    for (i = GC_mark_deficit; i < max_deficit; i++) {
-      if (GC_mark_some(NULL))
-        break;
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+    if (pacer_on && pacer_scan_rate != 0) {
+      mark_done = pacer_mark_some(start_time);
+      GC_mark_deficit = 0;
+    } else
+#endif
+    /* else */ {
+      for (i = GC_mark_deficit; i < max_deficit; i++) {
+        if (GC_mark_some(NULL)) {
+          mark_done = TRUE;
+          break;
+        }
+      }
     }
 #ifdef PARALLEL_MARK
     GC_parallel_mark_disabled = FALSE;
 #endif
     EXIT_GC();
 
-    if (i < max_deficit && !GC_dont_gc) {
+    if (mark_done && !GC_dont_gc) {
       GC_ASSERT(!GC_collection_in_progress());
       /* Need to follow up with a full collection. */
       SAVE_CALLERS_TO_LAST_STACK();
 #ifdef PARALLEL_MARK
       if (GC_parallel)
-        GC_wait_for_reclaim();
+        GC_finish_parallel_sweep();
 #endif
 #ifndef NO_CLOCK
       if (GC_time_limit != GC_TIME_UNLIMITED
@@ -829,8 +1217,89 @@ GC_collect_a_little_inner(size_t n_blocks)
   } else if (!GC_dont_gc) {
     GC_maybe_gc();
   }
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_CLOCK)
+  if (pacer_on)
+    pacer_update(start_time);
+#endif
+  RESTORE_CANCEL(cancel_state);
+}
+
+GC_INNER void
+GC_collect_a_little_on_alloc(size_t n_blocks)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+#ifdef CONCURRENT_MARK
+  /*
+   * Let the background marker do the marking work of the collection in
+   * progress.  The mutator skips its own marking step only if the marker
+   * has already done at least as many steps since the previous skip;
+   * otherwise (the mutator allocates faster than the background marker
+   * marks) the mutator assists the marker as in the plain incremental
+   * mode, thus the heap does not grow more than in the latter mode.
+   */
+  if (GC_concurrent_mark && GC_incremental && GC_collection_in_progress()
+      && GC_request_concurrent_mark()) {
+    AO_t steps = (AO_t)GC_rate * n_blocks;
+
+    /* The credit is consumed only with the allocator lock held. */
+    if (AO_load(&GC_concurrent_mark_credit) >= steps) {
+      (void)AO_fetch_and_add(&GC_concurrent_mark_credit, (AO_t)0 - steps);
+      return;
+    }
+  }
+#endif
+  GC_collect_a_little_inner(n_blocks);
+}
+
+#ifdef CONCURRENT_MARK
+GC_INNER void
+GC_concurrent_mark_steps(void)
+{
+  unsigned i = 0;
+  IF_CANCEL(int cancel_state;)
+
+  GC_ASSERT(I_DONT_HOLD_LOCK());
+  LOCK();
+  DISABLE_CANCEL(cancel_state);
+  while (GC_concurrent_mark && GC_incremental
+         && GC_concurrent_mark_can_step()) {
+    if (!GC_mark_stack_empty()) {
+      /* Trace the heap with the allocator lock released. */
+      if (!GC_drain_mark_stack_unlocked()) {
+        /* Stopped by a mutator, the allocator lock is not held. */
+        RESTORE_CANCEL(cancel_state);
+        return;
+      }
+      continue;
+    }
+
+    /*
+     * Push the next portion of the roots (or of the objects to rescan),
+     * this needs the allocator lock.
+     */
+    ENTER_GC();
+    /* This thread is one of the markers. */
+    GC_parallel_mark_disabled = TRUE;
+    GC_mark_in_background = TRUE;
+    /* Never completes the marking (as checked by the loop condition). */
+    (void)GC_mark_some(NULL);
+    GC_mark_in_background = FALSE;
+    GC_parallel_mark_disabled = FALSE;
+    EXIT_GC();
+    AO_fetch_and_add1(&GC_concurrent_mark_credit);
+
+    if (++i >= GC_rate) {
+      /* Give the mutators a chance to acquire the allocator lock. */
+      i = 0;
+      UNLOCK();
+      sched_yield();
+      LOCK();
+    }
+  }
   RESTORE_CANCEL(cancel_state);
+  UNLOCK();
 }
+#endif /* CONCURRENT_MARK */
 
 #if !defined(NO_FIND_LEAK) || !defined(SHORT_DBG_HDRS)
 GC_INNER void (*GC_check_heap)(void) = 0;
@@ -865,6 +1334,16 @@ GC_stop_world_external(void)
   LOCK();
 #  ifdef THREAD_LOCAL_ALLOC
   GC_ASSERT(!GC_world_stopped);
+#  endif
+#  ifdef PARALLEL_SWEEP
+  if (GC_parallel) {
+    IF_CANCEL(int cancel_state;)
+
+    /* `GC_wait_for_reclaim()` requires the cancellation to be off. */
+    DISABLE_CANCEL(cancel_state);
+    GC_finish_parallel_sweep();
+    RESTORE_CANCEL(cancel_state);
+  }
 #  endif
   ENTER_GC();
   STOP_WORLD();
@@ -914,10 +1393,14 @@ GC_stopped_mark(GC_stop_func stop_func)
 #ifndef NO_CLOCK
   CLOCK_TYPE start_time = CLOCK_TYPE_INITIALIZER;
   GC_bool start_time_valid = FALSE;
+#  ifdef THREADS
+  CLOCK_TYPE stop_world_time;
+#  endif
 #endif
 
   GC_ASSERT(I_HOLD_LOCK());
   GC_ASSERT(GC_is_initialized);
+  GC_stop_concurrent_drain();
   ENTER_GC();
 #if !defined(REDIRECT_MALLOC) && defined(USE_WINALLOC)
   GC_add_current_malloc_heap();
@@ -943,9 +1426,15 @@ GC_stopped_mark(GC_stop_func stop_func)
 #ifdef THREADS
   if (GC_on_collection_event)
     GC_on_collection_event(GC_EVENT_PRE_STOP_WORLD);
+#  ifndef NO_CLOCK
+  GET_TIME(stop_world_time);
+#  endif
 #endif
   STOP_WORLD();
 #ifdef THREADS
+#  ifndef NO_CLOCK
+  GC_update_world_stop_time(stop_world_time);
+#  endif
   if (GC_on_collection_event)
     GC_on_collection_event(GC_EVENT_POST_STOP_WORLD);
 #  ifdef THREAD_LOCAL_ALLOC
@@ -1235,6 +1724,9 @@ set_all_fl_marks(void)
 {
   unsigned kind;
 
+#ifdef BUMP_ALLOC
+  GC_release_bump_regions();
+#endif
   for (kind = 0; kind < GC_n_kinds; kind++) {
     size_t lg;
 
@@ -1256,6 +1748,9 @@ clear_all_fl_marks(void)
 {
   unsigned kind;
 
+#ifdef BUMP_ALLOC
+  GC_release_bump_regions();
+#endif
   for (kind = 0; kind < GC_n_kinds; kind++) {
     size_t lg;
 
@@ -1292,6 +1787,44 @@ GC_compute_heap_usage_percent(void)
                    TO_KiB_UL(GC_composite_in_use),                           \
                    TO_KiB_UL(GC_atomic_in_use + GC_bytes_allocd))
 
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(GC_GET_HEAP_USAGE_NOT_NEEDED)
+/*
+ * Update the nursery statistics.  Should be called after
+ * `GC_start_reclaim()` (which recomputes the in-use counters) but before
+ * the allocation counters are reset.
+ */
+static void
+update_minor_gc_stats(void)
+{
+  word in_use = GC_composite_in_use + GC_atomic_in_use;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  if (!GC_is_full_gc && GC_incremental) {
+    /*
+     * The objects marked by the previous collection are still marked,
+     * so the growth of the accessible data is roughly the size of the
+     * objects allocated since then and which have survived.  This is
+     * approximate as the explicitly deallocated objects might be young.
+     */
+    word old_in_use = GC_in_use_after_gc > GC_bytes_freed
+                          ? GC_in_use_after_gc - GC_bytes_freed
+                          : 0;
+    word survived = in_use > old_in_use ? in_use - old_in_use : 0;
+
+    if (survived > GC_bytes_allocd)
+      survived = GC_bytes_allocd;
+    GC_minor_gc_no++;
+    GC_nursery_bytes = GC_bytes_allocd;
+    GC_nursery_survived_bytes = survived;
+    GC_promoted_bytes += survived; /*< may wrap */
+    GC_VERBOSE_LOG_PRINTF("Minor GC: %lu of %lu nursery bytes survived\n",
+                          (unsigned long)survived,
+                          (unsigned long)GC_bytes_allocd);
+  }
+  GC_in_use_after_gc = in_use;
+}
+#endif
+
 /*
  * Finish up a collection.  Assumes mark bits are consistent, but the
  * world is otherwise running.
@@ -1319,6 +1852,9 @@ GC_finish_collection(void)
   if (GC_on_collection_event)
     GC_on_collection_event(GC_EVENT_RECLAIM_START);
 
+#ifdef SIZE_CLASS_LOCKS
+  GC_add_class_bytes();
+#endif
 #ifndef GC_GET_HEAP_USAGE_NOT_NEEDED
   if (GC_bytes_found > 0)
     GC_reclaimed_bytes_before_gc += (word)GC_bytes_found;
@@ -1373,6 +1909,9 @@ GC_finish_collection(void)
   GC_ASSERT(GC_heapsize >= GC_unmapped_bytes);
 #endif
   GC_ASSERT(GC_our_mem_bytes >= GC_heapsize);
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(GC_GET_HEAP_USAGE_NOT_NEEDED)
+  update_minor_gc_stats();
+#endif
   GC_DBGLOG_PRINTF(
       "GC #%lu freed %ld bytes, heap %lu KiB (" IF_USE_MUNMAP(
           "+ %lu KiB unmapped ") "+ %lu KiB internal)\n",
@@ -1498,6 +2037,44 @@ GC_gcollect_and_unmap(void)
   (void)GC_try_to_collect_general(GC_never_stop_func, TRUE);
 }
 
+GC_API void GC_CALL
+GC_gcollect_minor(void)
+{
+#ifndef GC_DISABLE_INCREMENTAL
+  IF_CANCEL(int cancel_state;)
+
+  if (UNLIKELY(!GC_is_initialized))
+    GC_init();
+  LOCK();
+  if (GC_incremental) {
+    DISABLE_CANCEL(cancel_state);
+    if (!GC_dont_gc) {
+      /* Finish the collection in progress (if any) first. */
+      while (GC_collection_in_progress())
+        GC_collect_a_little_inner(1);
+
+      /*
+       * `GC_maybe_gc()` decides whether the collection is a minor one.
+       * Note: the time limit, if any, is respected, thus the collection
+       * might take several steps.
+       */
+      GC_should_start_incremental_collection = TRUE;
+      do {
+        GC_collect_a_little_inner(1);
+      } while (GC_collection_in_progress());
+    }
+    RESTORE_CANCEL(cancel_state);
+    UNLOCK();
+    if (GC_debugging_started)
+      GC_print_all_smashed();
+    GC_notify_or_invoke_finalizers();
+    return;
+  }
+  UNLOCK();
+#endif
+  GC_gcollect();
+}
+
 STATIC GC_on_os_get_mem_proc GC_on_os_get_mem = 0;
 
 GC_API void GC_CALL
@@ -1563,7 +2140,9 @@ GC_add_to_heap(struct hblk *h, size_t sz)
   GC_ASSERT(ADDR(h) % HBLKSIZE == 0);
   GC_ASSERT(sz % HBLKSIZE == 0);
   GC_ASSERT(sz > 0);
+#ifndef FLAT_HDR_MAP
   GC_ASSERT(GC_all_nils != NULL);
+#endif
 
   if (UNLIKELY(GC_n_heap_sects == GC_capacity_heap_sects)) {
     /* Allocate new `GC_heap_sects` with sufficient capacity. */
@@ -1610,6 +2189,7 @@ GC_add_to_heap(struct hblk *h, size_t sz)
   }
   endp = (ptr_t)h + sz;
 
+  GC_hdr_update_begin();
   hhdr = GC_install_header(h);
   if (UNLIKELY(NULL == hhdr)) {
     /*
@@ -1617,6 +2197,7 @@ GC_add_to_heap(struct hblk *h, size_t sz)
      * certainly result in a `NULL` returned from the allocator, which
      * is entirely appropriate.
      */
+    GC_hdr_update_end();
     return;
   }
 #ifdef GC_ASSERTIONS
@@ -1637,6 +2218,7 @@ GC_add_to_heap(struct hblk *h, size_t sz)
   hhdr->hb_sz = sz;
   hhdr->hb_flags = 0;
   GC_freehblk(h);
+  GC_hdr_update_end();
   GC_heapsize += sz;
 
   if (ADDR_GE((ptr_t)GC_least_plausible_heap_addr, (ptr_t)h)
@@ -1758,6 +2340,15 @@ GC_expand_hp_inner(word n)
   if (0 == n)
     n = 1;
   sz = ROUNDUP_PAGESIZE((size_t)n * HBLKSIZE);
+#ifdef HUGE_PAGES_SUPPORTED
+  if (GC_huge_pages) {
+    /*
+     * Expand the heap by whole huge pages, so that the section could be
+     * aligned and backed by huge pages entirely.
+     */
+    sz = SIZET_SAT_ADD(sz, HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  }
+#endif
   GC_DBGLOG_PRINT_HEAP_IN_USE();
   if (GC_max_heapsize != 0
       && (GC_max_heapsize < (word)sz
@@ -1877,6 +2468,20 @@ GC_collect_or_expand(word needed_blocks, unsigned flags, GC_bool retry)
   GC_ASSERT(I_HOLD_LOCK());
   GC_ASSERT(GC_is_initialized);
   DISABLE_CANCEL(cancel_state);
+#ifdef CONCURRENT_MARK
+  if (GC_concurrent_mark && GC_incremental && !GC_dont_gc
+      && GC_collection_in_progress() && !retry) {
+    /*
+     * The background marker has not kept up with the allocations.
+     * Rather than expand the heap, finish the collection in progress.
+     */
+    do {
+      GC_collect_a_little_inner(1);
+    } while (GC_collection_in_progress());
+    RESTORE_CANCEL(cancel_state);
+    return TRUE;
+  }
+#endif
   if (!GC_incremental && !GC_dont_gc
       && ((GC_dont_expand && GC_bytes_allocd > 0)
           || (GC_fo_entries > last_fo_entries
@@ -2009,6 +2614,7 @@ GC_allocobj(size_t lg, int kind)
   if (UNLIKELY(0 == lg))
     return NULL;
 
+  NOTE_SWEEP_DEMAND(lg, kind);
   while (NULL == *flh) {
     /*
      * Only a few iterations are expected at most, otherwise something
@@ -2022,7 +2628,7 @@ GC_allocobj(size_t lg, int kind)
        * True incremental mode, not just generational.
        * Do our share of marking work.
        */
-      GC_collect_a_little_inner(1);
+      GC_collect_a_little_on_alloc(1);
     }
 #endif
     /* Sweep blocks for objects of this size. */
@@ -2045,7 +2651,7 @@ GC_allocobj(size_t lg, int kind)
 #ifndef GC_DISABLE_INCREMENTAL
     if (GC_incremental && GC_time_limit == GC_TIME_UNLIMITED && !tried_minor
         && !GC_dont_gc) {
-      GC_collect_a_little_inner(1);
+      GC_collect_a_little_on_alloc(1);
       tried_minor = TRUE;
       continue;
     }
@@ -406,7 +406,11 @@ GC_push_all_stacks(void)
 #  endif
   mach_port_deallocate(my_task, my_thread);
   GC_VERBOSE_LOG_PRINTF("Pushed %d thread stacks\n", nthreads);
-  if (!found_me && !GC_in_thread_creation)
+  if (!found_me && !GC_in_thread_creation
+#  ifdef CONCURRENT_MARK
+      && !GC_mark_in_background
+#  endif
+  )
     ABORT("Collecting from unknown thread");
   GC_total_stacksize = total_size;
 }
@@ -26,13 +26,13 @@
  *   2. A map from addresses to heap block addresses to heap block headers.
  *
  * Access speed is crucial.  We implement an index structure based on
- * a two-level tree.
+ * a two-level tree (or a flat array if `FLAT_HDR_MAP` is defined).
  */
 
 GC_INNER hdr *
 GC_find_header(const void *h)
 {
-#ifdef HASH_TL
+#if defined(HASH_TL) || defined(FLAT_HDR_MAP)
   hdr *result;
   GET_HDR(h, result);
   return result;
@@ -186,6 +186,43 @@ free_hdr(hdr *hhdr)
   GC_hdr_free_list = hhdr;
 }
 
+#ifdef THREADS
+GC_INNER volatile AO_t GC_hdr_seq = 0;
+
+/*
+ * The nesting level of `GC_hdr_update_begin()` calls.  Protected by the
+ * allocator lock.
+ */
+STATIC unsigned GC_hdr_update_depth = 0;
+
+GC_INNER void
+GC_hdr_update_begin(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  if (0 == GC_hdr_update_depth++) {
+    AO_t seq;
+
+    /* The background marker reads the headers without the allocator lock. */
+    GC_stop_concurrent_drain();
+    seq = AO_load(&GC_hdr_seq);
+
+    GC_ASSERT((seq & 1) == 0);
+    AO_store(&GC_hdr_seq, seq + 1);
+    /* The updates of the headers should not be seen before this one. */
+    AO_nop_full();
+  }
+}
+
+GC_INNER void
+GC_hdr_update_end(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(GC_hdr_update_depth > 0);
+  if (0 == --GC_hdr_update_depth)
+    AO_store_release(&GC_hdr_seq, AO_load(&GC_hdr_seq) + 1);
+}
+#endif /* THREADS */
+
 #ifdef COUNT_HDR_CACHE_HITS
 /* Used for debugging/profiling (the symbols are externally visible). */
 word GC_hdr_cache_hits = 0;
@@ -195,6 +232,10 @@ word GC_hdr_cache_misses = 0;
 GC_INNER void
 GC_init_headers(void)
 {
+#ifdef FLAT_HDR_MAP
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_init_heap_reserve();
+#else
   unsigned i;
 
   GC_ASSERT(I_HOLD_LOCK());
@@ -208,8 +249,17 @@ GC_init_headers(void)
   for (i = 0; i < TOP_SZ; i++) {
     GC_top_index[i] = GC_all_nils;
   }
+#endif
 }
 
+#ifdef FLAT_HDR_MAP
+/*
+ * Every address of the memory returned by `GET_MEM()` is covered by
+ * `GC_flat_hdrs`, thus no index blocks are needed.
+ */
+#  define get_index(addr) ((void)(addr), TRUE)
+#else
+
 /*
  * Make sure that there is a bottom-level index block for address `addr`.
  * Returns `FALSE` on failure.
@@ -263,9 +313,15 @@ get_index(word addr)
   r->asc_link = p;
   *prev = r;
 
+#  ifdef THREADS
+  /* `GC_base()` could traverse the chain without the allocator lock. */
+  GC_cptr_store_release((volatile ptr_t *)&GC_top_index[i], (ptr_t)r);
+#  else
   GC_top_index[i] = r;
+#  endif
   return TRUE;
 }
+#endif /* !FLAT_HDR_MAP */
 
 GC_INNER hdr *
 GC_install_header(const struct hblk *h)
@@ -292,6 +348,7 @@ GC_install_counts(struct hblk *h, size_t sz /* bytes */)
 {
   struct hblk *hbp;
 
+#ifndef FLAT_HDR_MAP
   for (hbp = h; ADDR_LT((ptr_t)hbp, (ptr_t)h + sz); hbp += BOTTOM_SZ) {
     if (!get_index(ADDR(hbp)))
       return FALSE;
@@ -301,6 +358,7 @@ GC_install_counts(struct hblk *h, size_t sz /* bytes */)
   }
   if (!get_index(ADDR(h) + sz - 1))
     return FALSE;
+#endif
 
   GC_ASSERT(!IS_FORWARDING_ADDR_OR_NIL(HDR(h)));
   for (hbp = h + 1; ADDR_LT((ptr_t)hbp, (ptr_t)h + sz); hbp++) {
@@ -341,8 +399,89 @@ GC_remove_counts(const struct hblk *h, size_t sz /* bytes */)
   }
 }
 
-#define HBLK_ADDR(bi, j) \
-  ((((bi)->key << LOG_BOTTOM_SZ) + (word)(j)) << LOG_HBLKSIZE)
+#ifdef FLAT_HDR_MAP
+#  define FLAT_HBLK_ADDR(j) \
+    (GC_heap_reserve_addr + ((word)(j) << LOG_HBLKSIZE))
+
+GC_API void GC_CALL
+GC_apply_to_all_blocks(GC_walk_hblk_fn fn, void *client_data)
+{
+  GC_signed_word j;
+
+  for (j = (GC_signed_word)(GC_heap_reserve_used >> LOG_HBLKSIZE) - 1;
+       j >= 0;) {
+    const hdr *hhdr = GC_flat_hdrs[j];
+
+    if (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
+      j -= (GC_signed_word)(hhdr != NULL ? ADDR(hhdr) : 1);
+    } else {
+      if (!HBLK_IS_FREE(hhdr)) {
+        GC_ASSERT(FLAT_HBLK_ADDR(j) == ADDR(hhdr->hb_block));
+        fn(hhdr->hb_block, client_data);
+      }
+      j--;
+    }
+  }
+}
+
+GC_INNER struct hblk *
+GC_next_block(const struct hblk *h, GC_bool allow_free)
+{
+  size_t j, limit = (size_t)(GC_heap_reserve_used >> LOG_HBLKSIZE);
+
+  GC_ASSERT(I_HOLD_READER_LOCK());
+  if (ADDR(h) < GC_heap_reserve_addr) {
+    j = 0;
+  } else if (!FLAT_HDR_COVERS(h)) {
+    return NULL;
+  } else {
+    j = FLAT_HDR_INDEX(h);
+  }
+  while (j < limit) {
+    const hdr *hhdr = GC_flat_hdrs[j];
+
+    if (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
+      j++;
+    } else {
+      if (allow_free || !HBLK_IS_FREE(hhdr)) {
+        GC_ASSERT(FLAT_HBLK_ADDR(j) == ADDR(hhdr->hb_block));
+        return hhdr->hb_block;
+      }
+      j += divHBLKSZ(hhdr->hb_sz);
+    }
+  }
+  return NULL;
+}
+
+GC_INNER struct hblk *
+GC_prev_block(const struct hblk *h)
+{
+  GC_signed_word j;
+
+  GC_ASSERT(I_HOLD_READER_LOCK());
+  if (ADDR(h) < GC_heap_reserve_addr)
+    return NULL;
+  j = FLAT_HDR_COVERS(h)
+          ? (GC_signed_word)FLAT_HDR_INDEX(h)
+          : (GC_signed_word)(GC_heap_reserve_used >> LOG_HBLKSIZE) - 1;
+  while (j >= 0) {
+    const hdr *hhdr = GC_flat_hdrs[j];
+
+    if (NULL == hhdr) {
+      --j;
+    } else if (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
+      j -= (GC_signed_word)ADDR(hhdr);
+    } else {
+      GC_ASSERT(FLAT_HBLK_ADDR(j) == ADDR(hhdr->hb_block));
+      return hhdr->hb_block;
+    }
+  }
+  return NULL;
+}
+
+#else
+#  define HBLK_ADDR(bi, j) \
+    ((((bi)->key << LOG_BOTTOM_SZ) + (word)(j)) << LOG_HBLKSIZE)
 
 GC_API void GC_CALL
 GC_apply_to_all_blocks(GC_walk_hblk_fn fn, void *client_data)
@@ -437,3 +576,4 @@ GC_prev_block(const struct hblk *h)
   }
   return NULL;
 }
+#endif /* !FLAT_HDR_MAP */
@@ -563,6 +563,25 @@ GC_API void GC_CALL GC_set_pages_executable(int);
  */
 GC_API int GC_CALL GC_get_pages_executable(void);
 
+/**
+ * Set whether the garbage collector should back the heap by transparent
+ * huge pages.  A nonzero argument instructs the collector to get the
+ * heap sections from the OS aligned to the huge page size (and of size
+ * being a multiple of it), to advise the OS kernel to use huge pages for
+ * them, and to avoid unmapping parts of huge pages.  Must be called
+ * before the collector is initialized.  Has effect only on Linux (if
+ * the collector is built with `mmap` support).  The default is off;
+ * it could also be turned on by `GC_HUGE_PAGES` environment variable.
+ */
+GC_API void GC_CALL GC_set_huge_pages(int);
+
+/**
+ * Returns nonzero value if the garbage collector is set to back the heap
+ * by transparent huge pages.  Always returns zero if the mode is not
+ * supported.  Does not use or need synchronization.
+ */
+GC_API int GC_CALL GC_get_huge_pages(void);
+
 /**
  * The setter and the getter of the minimum value returned by the internal
  * `min_bytes_allocd()`.  The value should not be zero; the default value
@@ -578,6 +597,24 @@ GC_API size_t GC_CALL GC_get_min_bytes_allocd(void);
 GC_API void GC_CALL GC_set_rate(int);
 GC_API int GC_CALL GC_get_rate(void);
 
+/**
+ * Set/get the target mutator utilization (in percent) of the incremental
+ * collection pacer.  If nonzero (and the incremental mode is on, and the
+ * time limit is not `GC_TIME_UNLIMITED`), then the amount of marking work
+ * done on each allocation slow path is decided by the pacer (instead of
+ * using `GC_rate`) from the measured allocation and marking rates: it is
+ * enough to give the collector the rest of the time and to complete the
+ * marking before the free space in the heap is used up, but limited by
+ * the time limit (i.e. the target maximum pause).  The pacer also starts
+ * the next collection earlier if needed to complete its marking before
+ * the heap has to grow.  The value is clamped to the range of 0 to 99.
+ * Zero (the default) turns the pacer off.  Not synchronized.  The getter always
+ * returns 0 if the pacer is not supported by the collector (i.e. if it
+ * is built with `GC_DISABLE_INCREMENTAL` or `NO_CLOCK` macro defined).
+ */
+GC_API void GC_CALL GC_set_mutator_utilization(int);
+GC_API int GC_CALL GC_get_mutator_utilization(void);
+
 /**
  * Set/get the maximum number of prior attempts at the world-stop marking.
  * Not synchronized.
@@ -594,6 +631,33 @@ GC_API int GC_CALL GC_get_max_prior_attempts(void);
 GC_API void GC_CALL GC_set_disable_automatic_collection(int);
 GC_API int GC_CALL GC_get_disable_automatic_collection(void);
 
+/**
+ * Control whether to use the mostly-concurrent marking in the incremental
+ * mode.  If on, then the world is stopped at the start of a collection only
+ * to read the dirty bits, the marking is done by a parallel marker thread
+ * while the client threads are running, and the world is stopped again only
+ * to re-mark from the roots and the pages dirtied meanwhile.  Has no effect
+ * unless the incremental mode is on and the parallel marker threads are
+ * running.  Off by default.  Both the setter and the getter acquire the
+ * allocator lock (in the reader mode in case of the getter).  The getter
+ * always returns 0 if the feature is not supported by the collector.
+ */
+GC_API void GC_CALL GC_set_concurrent_mark(int);
+GC_API int GC_CALL GC_get_concurrent_mark(void);
+
+/**
+ * Control whether to use a dedicated thread which sweeps the heap blocks
+ * between collections, building the free lists ahead of the allocation
+ * demand (estimated per object size), instead of sweeping them lazily on
+ * the allocation slow path.  The thread is started at the end of the
+ * next collection.  Off by default.  Both the setter and the getter
+ * acquire the allocator lock (in the reader mode in case of the getter).
+ * The getter always returns 0 if the feature is not supported by the
+ * collector.
+ */
+GC_API void GC_CALL GC_set_background_sweep(int);
+GC_API int GC_CALL GC_get_background_sweep(void);
+
 /**
  * Overrides the default handle-fork mode.  A nonzero value means GC
  * should install proper `pthread_atfork` handlers.  Has effect only
@@ -801,7 +865,10 @@ GC_API void GC_CALL GC_debug_end_stubborn_change(const void *)
  * Return `NULL` if `displaced_pointer` does not point to within
  * a valid object.  Note that a deallocated object in the garbage
  * collected heap may be considered valid, even if it has been
- * deallocated with `GC_free()` or friends.
+ * deallocated with `GC_free()` or friends.  Normally, the function does
+ * not acquire the allocator lock (and does not write to any shared
+ * memory location), it acquires the lock in the reader mode only if
+ * the heap blocks have been updated by another thread during the call.
  */
 GC_API void *GC_CALL GC_base(void * /* `displaced_pointer` */);
 
@@ -823,6 +890,7 @@ GC_API void *GC_CALL GC_base(void * /* `displaced_pointer` */);
  * collected heap, 0 otherwise.  Primary use is as a fast alternative to
  * `GC_base_C()` to check whether the given object is allocated by the
  * collector or not.  It is assumed that the collector is already initialized.
+ * Does not acquire the allocator lock.
  */
 GC_API int GC_CALL GC_is_heap_ptr(const void *);
 
@@ -833,6 +901,7 @@ GC_API int GC_CALL GC_is_heap_ptr(const void *);
  * larger than the actual size of the object (the returned value may include
  * the size of the object debug header, an extra byte past end of the object,
  * etc.).  The argument may be `NULL` (causing 0 to be returned).
+ * Synchronized the same way as `GC_base()`.
  */
 GC_API size_t GC_CALL GC_size(const void * /* `obj` */);
 
@@ -1138,6 +1207,99 @@ struct GC_prof_stats_s {
 
   /** Total amount of memory obtained from OS, in bytes. */
   GC_word obtained_from_os_bytes;
+
+  /**
+   * Number of the (thread-local) free list refills by
+   * `GC_generic_malloc_many()` (each one acquires the allocator lock
+   * in the exclusive mode).  The value may wrap.
+   */
+  GC_word fl_refill_count;
+
+  /**
+   * Total size of the objects returned by the free list refills (in
+   * bytes).  The value may wrap.
+   */
+  GC_word fl_refill_bytes;
+
+  /**
+   * Number of the allocator lock acquisitions (in the exclusive mode).
+   * The lock statistics fields are supported only if the collector is
+   * built with the futex-based allocator lock (otherwise, -1 is stored).
+   * The value may wrap.
+   */
+  GC_word lock_acquisitions;
+
+  /**
+   * Number of the allocator lock acquisitions which found the lock held
+   * by another thread.  The value may wrap.
+   */
+  GC_word lock_contended_count;
+
+  /**
+   * Total time spent by threads waiting for the allocator lock (in
+   * nanoseconds).  The value may wrap.
+   */
+  GC_word lock_wait_ns;
+
+  /**
+   * Maximum time the allocator lock has been held at once (in
+   * nanoseconds), e.g. a world-stopped collection.  Measured only if
+   * the collector is built with `LOCK_STATS` macro defined (otherwise,
+   * -1 is stored).
+   */
+  GC_word lock_max_hold_ns;
+
+  /**
+   * Total time taken to stop the world, i.e. from the start of the world
+   * stop till all the mutator threads are suspended or parked (in
+   * nanoseconds).  Unlike `GC_get_stopped_mark_total_time()`, this does
+   * not include the marking itself.  Supported only in the multi-threaded
+   * collector built without `NO_CLOCK` macro defined.  The value may wrap.
+   */
+  GC_word world_stop_ns;
+
+  /** Maximum time taken to stop the world once (in nanoseconds). */
+  GC_word world_stop_max_ns;
+
+  /**
+   * Number of bytes of the thread stacks scanned during the recent
+   * collection.  Supported only in the multi-threaded collector.
+   */
+  GC_word stack_scanned_bytes;
+
+  /**
+   * Number of bytes of the thread stacks not rescanned during the recent
+   * collection because their contents had not changed since the previous
+   * scan (i.e. these parts are below the per-thread stack watermarks).
+   * Could be nonzero only in the generational mode.
+   */
+  GC_word stack_skipped_bytes;
+
+  /**
+   * Number of minor (i.e. not full) collections performed in the
+   * incremental or generational mode.
+   */
+  GC_word minor_gc_no;
+
+  /**
+   * Number of bytes allocated since the previous collection as of the
+   * latest minor collection, i.e. the size of the young generation.
+   */
+  GC_word nursery_bytes;
+
+  /**
+   * Approximate number of bytes of the objects in the young generation
+   * that survived the latest minor collection.  As the mark bits are not
+   * cleared by minor collections, such objects are promoted to the old
+   * generation.
+   */
+  GC_word nursery_survived_bytes;
+
+  /**
+   * Approximate total number of bytes promoted by minor collections.
+   * The value may wrap.
+   */
+  GC_word promoted_bytes;
 };
 
 /**
@@ -1280,6 +1442,20 @@ GC_API unsigned GC_CALL GC_get_supported_vdbs(void);
  */
 GC_API void GC_CALL GC_enable_incremental(void);
 
+/**
+ * Enable generational (but not incremental) collection.  Same as
+ * `GC_enable_incremental()` preceded by setting `GC_time_limit` to
+ * `GC_TIME_UNLIMITED`.  In this mode, every collection runs with the
+ * world stopped till the end, and only each `GC_full_freq`-th collection
+ * is a full one; the rest are minor ones, i.e. the mark bits of the
+ * objects survived the previous collections are kept, and the objects
+ * are traced from the roots and from the marked objects residing on the
+ * pages written since the previous collection (the dirty bits of which
+ * serve as the remembered set).  Setting of the time limit later turns
+ * the incremental marking on.
+ */
+GC_API void GC_CALL GC_enable_generational(void);
+
 /**
  * Return 1 (true) if the incremental mode is on, 0 otherwise.
  * Does not acquire the allocator lock.
@@ -1323,6 +1499,14 @@ GC_API int GC_CALL GC_incremental_protection_needs(void);
  */
 GC_API void GC_CALL GC_start_incremental_collection(void);
 
+/**
+ * Perform a minor collection (unless a full one is due) and wait for its
+ * completion.  Unlike `GC_gcollect()`, the objects survived the previous
+ * collections are not re-marked.  Same as `GC_gcollect()` unless the
+ * incremental or generational mode is on.
+ */
+GC_API void GC_CALL GC_gcollect_minor(void);
+
 /**
  * Perform some garbage collection work, if appropriate.
  * Return 0 if there is no more work to be done (including the
@@ -2145,6 +2329,18 @@ GC_API void GC_CALL GC_set_thr_restart_signal(int);
  */
 GC_API int GC_CALL GC_get_thr_restart_signal(void);
 
+/**
+ * Park the current (registered) thread until the end of the world-stop
+ * phase of the collection if the latter is in progress.  Effective only
+ * if the collector is built with `SAFEPOINT_STOP_WORLD` macro defined
+ * (otherwise it is a no-op); in that mode the threads poll for a pending
+ * world stop at the allocation calls, so this function is intended to
+ * be invoked periodically in long loops which do not allocate, thus
+ * avoiding the thread suspension by a signal.  Must not be called with
+ * the allocator lock held.
+ */
+GC_API void GC_CALL GC_safepoint(void);
+
 /**
  * Explicitly enable `GC_register_my_thread()` invocation.
  * Done implicitly if a GC thread-creation function is called
@@ -2694,6 +2890,46 @@ GC_API void GC_CALL GC_endthreadex(unsigned /* `retval` */);
 GC_API void GC_CALL GC_set_force_unmap_on_gcollect(int);
 GC_API int GC_CALL GC_get_force_unmap_on_gcollect(void);
 
+/* The policies of returning the unmapped heap memory to the OS. */
+#define GC_UNMAP_POLICY_DONTNEED 0 /*< `madvise(MADV_DONTNEED)` (default) */
+#define GC_UNMAP_POLICY_FREE 1 /*< `madvise(MADV_FREE)`, lazy reclaim */
+#define GC_UNMAP_POLICY_PROT_NONE 2 /*< also protect from any access */
+
+/**
+ * The setter and the getter of the policy of returning the unmapped heap
+ * memory to the OS (one of `GC_UNMAP_POLICY_` values).  `MADV_FREE` lets
+ * the OS kernel reclaim the pages lazily (thus reusing them soon is
+ * cheaper, but the process RSS does not drop until there is a memory
+ * pressure); the protection with `PROT_NONE` additionally catches the
+ * accesses to the unmapped blocks (but increases the number of memory
+ * mappings of the process, which is not limited by the collector unless
+ * it is built with `PREFER_MMAP_PROT_NONE` or
+ * `FORCE_MPROTECT_BEFORE_MADVISE` macro defined).  Has effect only on Linux
+ * (on other targets, the unmapping is done in the platform-specific way);
+ * `GC_UNMAP_POLICY_FREE` is treated as `GC_UNMAP_POLICY_DONTNEED` if
+ * `MADV_FREE` is not supported.  An unknown value passed to the setter is
+ * ignored.  The setter should be called before the collector
+ * initialization.  Initial value could also be set by
+ * `GC_UNMAP_POLICY` environment variable.  The setter and the getter are
+ * unsynchronized.
+ */
+GC_API void GC_CALL GC_set_unmap_policy(int);
+GC_API int GC_CALL GC_get_unmap_policy(void);
+
+/**
+ * Control whether the heap blocks are unmapped by a dedicated background
+ * thread (instead of the thread which holds the allocator lock, typically
+ * at the end of a collection).  The reuse of a block whose unmapping is
+ * still pending just cancels the latter.  The thread is started on the
+ * first unmapping request.  Off by default.  Both the setter and the getter
+ * acquire the allocator lock (in the reader mode in case of the getter).
+ * The getter always returns 0 if the feature is not supported by the
+ * collector (e.g. if memory unmapping is not compiled in or the collector
+ * is built without threads support).
+ */
+GC_API void GC_CALL GC_set_async_unmap(int);
+GC_API int GC_CALL GC_get_async_unmap(void);
+
 /*
  * Fully portable code should call `GC_INIT()` from the main program
  * before making any other `GC_` calls.  On most platforms this is
@@ -247,6 +247,69 @@ GC_API GC_ATTR_MALLOC GC_ATTR_ALLOC_SIZE(1) void *GC_CALL
     }                                                               \
   } while (0)
 
+/*
+ * The card marking write barrier for the manual VDB mode (see
+ * `GC_set_manual_vdb_allowed`).  The heap is logically split into cards
+ * of `1 << GC_LOG_CARD_BYTES` bytes, and a store to a heap object marks
+ * the card (instead of the whole page) containing the updated field as
+ * dirty, thus the collector rescans only the objects (or, for a large
+ * pointer-containing object, only the parts of it) which overlap the
+ * dirty cards.  The card table is hashed by address, i.e. it covers the
+ * whole address space, so the barrier never checks the address range.
+ * The card size and the number of the card table entries are fixed by
+ * the library (thus the client cannot redefine them).  The card table
+ * does not exist if the collector is built without the manual VDB support
+ * (e.g. with `GC_DISABLE_INCREMENTAL`, `NO_MANUAL_VDB` or `SMALL_CONFIG`
+ * macro defined); the client should be compiled with the same macro
+ * defined, then the barrier is the same as `GC_PTR_STORE_AND_DIRTY()`.
+ */
+#if defined(GC_LOG_CARD_BYTES) || defined(GC_LOG_CARD_TABLE_ENTRIES)
+#  error GC_LOG_CARD_BYTES and GC_LOG_CARD_TABLE_ENTRIES cannot be redefined
+#endif
+#define GC_LOG_CARD_BYTES 8
+#define GC_LOG_CARD_TABLE_ENTRIES 20
+
+#if defined(GC_DISABLE_INCREMENTAL) || defined(NO_MANUAL_VDB) \
+    || defined(SMALL_CONFIG)
+#  define GC_MARK_CARD(p) GC_end_stubborn_change(p)
+#  define GC_PTR_STORE_AND_MARK_CARD(p, q) GC_PTR_STORE_AND_DIRTY(p, q)
+#else
+#  define GC_CARD_INDEX(p)                                     \
+    ((size_t)((GC_uintptr_t)(p) >> GC_LOG_CARD_BYTES)          \
+     & (((size_t)1 << GC_LOG_CARD_TABLE_ENTRIES) - 1))
+
+/* The card table.  Any nonzero entry means the card is dirty. */
+GC_API unsigned char GC_card_table[(size_t)1 << GC_LOG_CARD_TABLE_ENTRIES];
+
+/*
+ * Set (along with an entry of `GC_card_table`) by the barrier, cleared
+ * by the collector when it reads the card table.  Allows the collector
+ * not to scan the card table if no card has been marked.
+ */
+GC_API unsigned char GC_cards_marked;
+
+/**
+ * `GC_PTR_STORE_AND_MARK_CARD(p, q)` is equivalent to `GC_PTR_STORE(p, q)`
+ * followed by marking the card of `p` as dirty and `GC_reachable_here(q)`
+ * (assuming `p` and `q` do not have side effects).  Unlike
+ * `GC_PTR_STORE_AND_DIRTY()`, this is inlined completely: it is a store
+ * and two unconditional byte stores.  The update of a field may also be
+ * reported by `GC_MARK_CARD(p)` after the store.
+ */
+#  define GC_MARK_CARD(p)                                          \
+    (void)(GC_card_table[GC_CARD_INDEX(p)] = (unsigned char)1,     \
+           GC_cards_marked = (unsigned char)1)
+
+#  define GC_PTR_STORE_AND_MARK_CARD(p, q) \
+    do {                                   \
+      void *gc_q_ = (void *)(q);           \
+                                           \
+      *(void **)(p) = gc_q_;               \
+      GC_MARK_CARD(p);                     \
+      GC_reachable_here(gc_q_);            \
+    } while (0)
+#endif
+
 /**
  * Print address of each object in the free list for the given `kind`
  * and size `lg` (in granules).  The caller should hold the allocator
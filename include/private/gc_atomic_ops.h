@@ -79,6 +79,12 @@ AO_nop_full(void)
 #    define AO_nop_full() __atomic_thread_fence(__ATOMIC_SEQ_CST)
 #  endif
 #  define AO_HAVE_nop_full
+#  if defined(THREAD_SANITIZER) && !defined(AO_USE_ATOMIC_THREAD_FENCE)
+#    define AO_nop_read() AO_nop_full()
+#  else
+#    define AO_nop_read() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#  endif
+#  define AO_HAVE_nop_read
 
 #  define AO_fetch_and_add(p, v) __atomic_fetch_add(p, v, __ATOMIC_RELAXED)
 #  define AO_HAVE_fetch_and_add
@@ -114,6 +120,15 @@ AO_nop_full(void)
 #  define AO_char_fetch_and_add1(p) __atomic_fetch_add(p, 1, __ATOMIC_RELAXED)
 #  define AO_HAVE_char_fetch_and_add1
 
+#  define AO_int_load(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#  define AO_HAVE_int_load
+#  define AO_int_load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#  define AO_HAVE_int_load_acquire
+#  define AO_int_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#  define AO_HAVE_int_store_release
+#  define AO_int_fetch_and_add1(p) __atomic_fetch_add(p, 1, __ATOMIC_RELAXED)
+#  define AO_HAVE_int_fetch_and_add1
+
 #  ifdef AO_REQUIRE_CAS
 AO_INLINE int
 AO_compare_and_swap_release(volatile AO_t *p, AO_t ov, AO_t nv)
@@ -122,6 +137,34 @@ AO_compare_and_swap_release(volatile AO_t *p, AO_t ov, AO_t nv)
                                           __ATOMIC_RELAXED /* on fail */);
 }
 #    define AO_HAVE_compare_and_swap_release
+
+AO_INLINE int
+AO_compare_and_swap_full(volatile AO_t *p, AO_t ov, AO_t nv)
+{
+  return (int)__atomic_compare_exchange_n(p, &ov, nv, 0, __ATOMIC_SEQ_CST,
+                                          __ATOMIC_SEQ_CST /* on fail */);
+}
+#    define AO_HAVE_compare_and_swap_full
+
+AO_INLINE unsigned
+AO_int_fetch_compare_and_swap_acquire(volatile unsigned *p, unsigned ov,
+                                      unsigned nv)
+{
+  (void)__atomic_compare_exchange_n(p, &ov, nv, 0, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_ACQUIRE /* on fail */);
+  return ov;
+}
+#    define AO_HAVE_int_fetch_compare_and_swap_acquire
+
+AO_INLINE unsigned
+AO_int_fetch_compare_and_swap_release(volatile unsigned *p, unsigned ov,
+                                      unsigned nv)
+{
+  (void)__atomic_compare_exchange_n(p, &ov, nv, 0, __ATOMIC_RELEASE,
+                                    __ATOMIC_RELAXED /* on fail */);
+  return ov;
+}
+#    define AO_HAVE_int_fetch_compare_and_swap_release
 #  endif
 
 #  ifdef __cplusplus
@@ -125,6 +125,34 @@ GC_INNER hdr *GC_header_cache_miss(ptr_t p, hdr_cache_entry *hce);
     }                                              \
   }
 
+#ifdef FLAT_HDR_MAP
+/*
+ * The heap (and the collector internal data allocated by `GET_MEM()`)
+ * resides in a single address range reserved at the collector
+ * initialization, thus the header of a block is just an element of
+ * a flat array (committed lazily) indexed by the block number in that
+ * range.  The elements are of the same kinds as those of `bottom_index`
+ * (see below).  Only the part of the range already obtained by
+ * `GET_MEM()` is covered (the addresses outside it have no header).
+ */
+#  define FLAT_HDR_INDEX(p) \
+    ((size_t)((ADDR(p) - GC_heap_reserve_addr) >> LOG_HBLKSIZE))
+#  define FLAT_HDR_COVERS(p) \
+    (ADDR(p) - GC_heap_reserve_addr < GC_heap_reserve_used)
+#  define HDR(p) \
+    (LIKELY(FLAT_HDR_COVERS(p)) ? GC_flat_hdrs[FLAT_HDR_INDEX(p)] : NULL)
+#  define GET_HDR(p, hhdr) (void)((hhdr) = HDR(p))
+#  define GET_HDR_ADDR(p, ha)                  \
+    do {                                       \
+      GC_ASSERT(FLAT_HDR_COVERS(p));           \
+      (ha) = &GC_flat_hdrs[FLAT_HDR_INDEX(p)]; \
+    } while (0)
+#  define SET_HDR(p, hhdr)                      \
+    do {                                        \
+      GC_ASSERT(FLAT_HDR_COVERS(p));            \
+      GC_flat_hdrs[FLAT_HDR_INDEX(p)] = (hhdr); \
+    } while (0)
+#else
 typedef struct bi {
   /*
    * The bottom-level index contains one of three kinds of values:
@@ -150,8 +178,6 @@ typedef struct bi {
 #endif
 } bottom_index;
 
-#define MAX_JUMP (HBLKSIZE - 1)
-
 #define HDR_FROM_BI(bi, p) \
   (bi)->index[(ADDR(p) >> LOG_HBLKSIZE) & (BOTTOM_SZ - 1)]
 #ifndef HASH_TL
@@ -199,6 +225,9 @@ typedef struct bi {
     } while (0)
 #  define HDR(p) GC_find_header(p)
 #endif
+#endif /* !FLAT_HDR_MAP */
+
+#define MAX_JUMP (HBLKSIZE - 1)
 
 /*
  * Is the result a forwarding address to someplace closer to the
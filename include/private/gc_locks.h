@@ -50,6 +50,7 @@ extern void GC_unlock(void);
       && defined(GC_PTHREADS)
 #    define USE_PTHREAD_LOCKS
 #    undef USE_SPIN_LOCK
+#    undef USE_FUTEX_LOCK
 #    if (defined(GC_WIN32_THREADS) || defined(LINT2) || defined(USE_RWLOCK)) \
         && !defined(NO_PTHREAD_TRYLOCK)
 /*
@@ -199,6 +200,32 @@ GC_EXTERN WapiMutex GC_allocate_ml_PSP2;
           (void)res;                                    \
         }
 
+#    elif defined(USE_FUTEX_LOCK)
+/*
+ * The allocator lock is implemented on top of Linux futex with
+ * adaptive spinning before sleeping in the kernel; the lock collects
+ * the contention statistics (see `GC_prof_stats_s`).
+ */
+#      undef USE_SPIN_LOCK
+GC_INNER void GC_lock(void);
+GC_INNER void GC_unlock(void);
+#      ifdef GC_ASSERTIONS
+#        define UNCOND_LOCK()              \
+          {                                \
+            GC_ASSERT(I_DONT_HOLD_LOCK()); \
+            GC_lock();                     \
+            SET_LOCK_HOLDER();             \
+          }
+#        define UNCOND_UNLOCK()       \
+          {                           \
+            GC_ASSERT(I_HOLD_LOCK()); \
+            UNSET_LOCK_HOLDER();      \
+            GC_unlock();              \
+          }
+#      else
+#        define UNCOND_LOCK() GC_lock()
+#        define UNCOND_UNLOCK() GC_unlock()
+#      endif
 #    elif (!defined(THREAD_LOCAL_ALLOC) || defined(USE_SPIN_LOCK))   \
         && !defined(USE_PTHREAD_LOCKS) && !defined(THREAD_SANITIZER) \
         && !defined(USE_RWLOCK)
@@ -338,8 +365,9 @@ GC_EXTERN volatile unsigned char GC_collecting;
 #    endif
 #  endif /* GC_PTHREADS */
 
-#  if defined(GC_ALWAYS_MULTITHREADED) \
-      && (defined(USE_PTHREAD_LOCKS) || defined(USE_SPIN_LOCK))
+#  if defined(GC_ALWAYS_MULTITHREADED)                         \
+      && (defined(USE_PTHREAD_LOCKS) || defined(USE_SPIN_LOCK) \
+          || defined(USE_FUTEX_LOCK))
 #    define GC_need_to_lock TRUE
 #  else
 #    if defined(GC_ALWAYS_MULTITHREADED) && !defined(CPPCHECK)
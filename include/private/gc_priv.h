@@ -72,7 +72,8 @@
 #  include <sys/time.h>
 #endif
 
-#ifdef PARALLEL_MARK
+#if defined(PARALLEL_MARK) || defined(USE_FUTEX_LOCK) \
+    || defined(SAFEPOINT_STOP_WORLD)
 #  define AO_REQUIRE_CAS
 #  if !defined(__GNUC__) && !defined(AO_ASSUME_WINDOWS98)
 #    define AO_ASSUME_WINDOWS98
@@ -323,6 +324,136 @@ EXTERN_C_END
 #  endif
 #endif
 
+#if defined(PARALLEL_MARK) && !defined(NO_MARK_DEQUES)                   \
+    && defined(AO_HAVE_compare_and_swap_full) && defined(AO_HAVE_nop_full) \
+    && defined(AO_HAVE_fetch_and_add1) && defined(AO_HAVE_fetch_and_sub1) \
+    && defined(AO_HAVE_load_acquire) && defined(AO_HAVE_store_release)
+/*
+ * Distribute the marking work among the markers using per-marker
+ * lock-free work-stealing deques instead of the global mark stack.
+ */
+#  define USE_MARK_DEQUES
+#endif
+
+#if defined(PARALLEL_MARK) && defined(GC_PTHREADS_PARAMARK)           \
+    && !defined(GC_WIN32_THREADS) && !defined(GC_DISABLE_INCREMENTAL) \
+    && !defined(NO_CONCURRENT_MARK)
+/*
+ * Support the mostly-concurrent marking, i.e. let one of the marker
+ * threads do the incremental marking work while the mutator threads
+ * are running.
+ */
+#  define CONCURRENT_MARK
+#endif
+
+#if defined(PARALLEL_MARK) && !defined(NO_PARALLEL_SWEEP) \
+    && !defined(EAGER_SWEEP)
+/*
+ * Let the idle marker threads sweep the reclaim lists right after
+ * the marking phase.
+ */
+#  define PARALLEL_SWEEP
+#endif
+
+#if defined(PARALLEL_MARK) && defined(PTHREAD_STOP_WORLD_IMPL)            \
+    && !defined(NEED_FIXUP_POINTER) && !defined(NO_ALL_INTERIOR_POINTERS) \
+    && defined(AO_HAVE_fetch_and_add1) && !defined(NO_PARALLEL_STACK_SCAN)
+/*
+ * Let the markers scan the stacks of the stopped threads in parallel
+ * (instead of the collecting thread only).
+ */
+#  define PARALLEL_STACK_SCAN
+#endif
+
+#if defined(PTHREAD_STOP_WORLD_IMPL) && !defined(STACK_GROWS_UP) \
+    && !defined(NACL) && !defined(GC_DISABLE_INCREMENTAL)          \
+    && !defined(NO_STACK_WATERMARKS)
+/*
+ * Do not rescan the cold part of a thread stack which has not been
+ * changed since the previous scan of it during the collections which
+ * keep the mark bits (i.e. the generational ones).
+ */
+#  define STACK_WATERMARKS
+#endif
+
+#if defined(GC_PTHREADS) && !defined(GC_WIN32_THREADS)      \
+    && !defined(SN_TARGET_PSP2) && !defined(REDIRECT_MALLOC) \
+    && !defined(EAGER_SWEEP) && !defined(NO_BACKGROUND_SWEEP)
+/*
+ * Support a dedicated thread which sweeps the reclaim lists between
+ * collections to build the free lists ahead of the allocation demand.
+ */
+#  define BACKGROUND_SWEEP
+#endif
+
+/*
+ * If `SIZE_CLASS_LOCKS` is defined, then refill the free lists of small
+ * objects from the global free list, or by sweeping the blocks on the
+ * reclaim list, while holding the allocator lock in the reader mode
+ * together with a lock of the size class (i.e. the pair of the object
+ * kind and size), thus the refills of different size classes do not
+ * serialize.  This requires the allocator lock to be a reader-writer one.
+ */
+#if defined(SIZE_CLASS_LOCKS)                         \
+    && (!defined(USE_RWLOCK) || !defined(GC_PTHREADS) \
+        || defined(GC_WIN32_THREADS))
+#  undef SIZE_CLASS_LOCKS
+#endif
+
+#if defined(USE_MUNMAP) && defined(GC_PTHREADS)               \
+    && !defined(GC_WIN32_THREADS) && !defined(SN_TARGET_PSP2) \
+    && !defined(SN_TARGET_PS3) && !defined(USE_WINALLOC)      \
+    && !defined(NO_ASYNC_UNMAP)
+/*
+ * Support a dedicated thread which returns the unmapped heap blocks to
+ * the OS instead of the thread holding the allocator lock.
+ */
+#  define ASYNC_UNMAP
+#endif
+
+#ifndef MEDIUM_MAX_HBLKS
+/*
+ * The large objects of up to this number of heap blocks are considered
+ * "medium" ones: `GC_generic_malloc_many` returns them in batches, and
+ * the thread-local allocator caches them.
+ */
+#  define MEDIUM_MAX_HBLKS 2
+#endif
+
+#ifndef MEDIUM_BATCH_HBLKS
+/*
+ * The number of heap blocks `GC_generic_malloc_many` allocates at most
+ * (while holding the allocator lock) for a batch of medium objects.
+ */
+#  define MEDIUM_BATCH_HBLKS 8
+#endif
+
+#ifndef MAX_REFILL_HBLKS
+/*
+ * The maximum size (in heap blocks) of a batch of small objects which
+ * `GC_generic_malloc_many_batch` returns (to a thread whose allocation
+ * rate of the objects of the size is high).
+ */
+#  define MAX_REFILL_HBLKS 8
+#endif
+
+#ifndef MIN_REFILL_BYTES
+/*
+ * The minimum size (in bytes) of a batch of small objects which the
+ * thread-local allocator requests (for a rarely allocated size).
+ */
+#  define MIN_REFILL_BYTES (HBLKSIZE / 8)
+#endif
+
+#ifndef NO_BUMP_ALLOC
+/*
+ * Allocate the small atomic and normal objects out of the fresh (empty)
+ * heap blocks by advancing a cursor instead of threading a free list
+ * through the whole block first.
+ */
+#  define BUMP_ALLOC
+#endif
+
 #ifdef ANY_MSWIN
 #  ifndef WIN32_LEAN_AND_MEAN
 #    define WIN32_LEAN_AND_MEAN 1
@@ -743,6 +874,40 @@ GC_INNER void GC_start_world(void);
 #  define START_WORLD()
 #endif
 
+#ifdef SAFEPOINT_STOP_WORLD
+/*
+ * The low 32 bits of the world-stop counter as published by
+ * `GC_stop_world()` (an even value, while the world is being stopped)
+ * and `GC_start_world()` (an odd value).  Parked threads wait on it.
+ */
+GC_EXTERN volatile unsigned GC_safepoint_epoch;
+
+/*
+ * Park the current thread (if registered) until the world is restarted.
+ * Called without the allocator lock held.
+ */
+GC_INNER void GC_safepoint_park(void);
+
+/*
+ * The actual implementation of `GC_safepoint_park()`; `tlfs` points to
+ * the thread-local free lists of the current thread.  Invoked via
+ * `GC_with_callee_saves_pushed()`.
+ */
+GC_INNER void GC_safepoint_park_self(ptr_t tlfs, void *context);
+
+/*
+ * Park the current thread if a world stop is pending.  Used at the
+ * allocation entry points; the allocator lock should not be held.
+ */
+#  define GC_SAFEPOINT_POLL()                                    \
+    do {                                                         \
+      if (UNLIKELY((AO_int_load(&GC_safepoint_epoch) & 1) == 0)) \
+        GC_safepoint_park();                                     \
+    } while (0)
+#else
+#  define GC_SAFEPOINT_POLL() (void)0
+#endif
+
 #if defined(HAS_WIN32_THREADS_DISCOVERY) && !defined(SMALL_CONFIG) \
     && defined(GC_BUILD)
 /*
@@ -1183,6 +1348,9 @@ typedef word page_hash_table[PHT_SIZE];
 
 #define PHT_HASH(p) ((size_t)((ADDR(p) >> LOG_HBLKSIZE) & (PHT_ENTRIES - 1)))
 
+#define CARD_BYTES ((size_t)1 << GC_LOG_CARD_BYTES)
+#define CARD_TABLE_ENTRIES ((size_t)1 << GC_LOG_CARD_TABLE_ENTRIES)
+
 #define get_pht_entry_from_index(bl, index) \
   (((bl)[divWORDSZ(index)] >> modWORDSZ(index)) & 1)
 #define set_pht_entry_from_index(bl, index) \
@@ -1557,6 +1725,18 @@ struct HeapSect {
   size_t hs_bytes;
 };
 
+#ifdef BUMP_ALLOC
+/*
+ * A part of a fresh heap block which objects of a single size are
+ * allocated from by advancing `cur` while it is less than `limit`.
+ * Both are `NULL` if there is no such block.
+ */
+struct bump_region {
+  ptr_t cur;
+  ptr_t limit;
+};
+#endif
+
 #if defined(USE_WINALLOC) && !defined(REDIRECT_MALLOC)
 /* In the long run, a better data structure would also be nice... */
 struct GC_malloc_heap_list {
@@ -1703,19 +1883,45 @@ struct _GC_arrays {
 #define GC_finalizer_bytes_freed GC_arrays._finalizer_bytes_freed
   word _finalizer_bytes_freed;
 
+#ifdef FLAT_HDR_MAP
+  /*
+   * The start of the reserved address space range all the heap (and
+   * scratch) memory is carved from.  Set once at the collector
+   * initialization.
+   */
+#  define GC_heap_reserve_addr GC_arrays._heap_reserve_addr
+  word _heap_reserve_addr;
+
+  /*
+   * The number of bytes (from the start of the reserved range) already
+   * handed out by `GET_MEM`; the corresponding part of `GC_flat_hdrs` is
+   * committed.  Only grows; updated with the allocator lock held.
+   */
+#  define GC_heap_reserve_used GC_arrays._heap_reserve_used
+  word _heap_reserve_used;
+
+  /*
+   * The flat header map: one entry per heap block of the reserved range.
+   * The entries are interpreted the same way as `hdr_ptrs` of
+   * a `bottom_index` entity.
+   */
+#  define GC_flat_hdrs GC_arrays._flat_hdrs
+  hdr **_flat_hdrs;
+#else
   /*
    * Pointer to the first (lowest address) `bottom_index` entity;
    * assumes the allocator lock is held.
    */
-#define GC_all_bottom_indices GC_arrays._all_bottom_indices
+#  define GC_all_bottom_indices GC_arrays._all_bottom_indices
   bottom_index *_all_bottom_indices;
 
   /*
    * Pointer to the last (highest address) `bottom_index` entity;
    * assumes the allocator lock is held.
    */
-#define GC_all_bottom_indices_end GC_arrays._all_bottom_indices_end
+#  define GC_all_bottom_indices_end GC_arrays._all_bottom_indices_end
   bottom_index *_all_bottom_indices_end;
+#endif
 
 #define GC_scratch_free_ptr GC_arrays._scratch_free_ptr
   ptr_t _scratch_free_ptr;
@@ -1900,6 +2106,31 @@ struct _GC_arrays {
 #    define GC_allocate_lock GC_arrays._allocate_lock
   volatile AO_TS_t _allocate_lock;
 #  endif
+#  ifdef USE_FUTEX_LOCK
+  /*
+   * The futex word of the allocator lock: 0 means unlocked, 1 means
+   * locked, 2 means locked and there might be waiters.
+   */
+#    define GC_allocate_futex GC_arrays._allocate_futex
+  volatile unsigned _allocate_futex;
+  /*
+   * The allocator lock statistics.  Updated only by the lock holder;
+   * see `GC_prof_stats_s` for the description.
+   */
+#    define GC_lock_acquisitions GC_arrays._lock_acquisitions
+  word _lock_acquisitions;
+#    define GC_lock_contended_count GC_arrays._lock_contended_count
+  word _lock_contended_count;
+#    define GC_lock_wait_ns GC_arrays._lock_wait_ns
+  word _lock_wait_ns;
+#    ifdef LOCK_STATS
+#      define GC_lock_max_hold_ns GC_arrays._lock_max_hold_ns
+  word _lock_max_hold_ns;
+  /* The time when the allocator lock was acquired last. */
+#      define GC_lock_acquired_at GC_arrays._lock_acquired_at
+  CLOCK_TYPE _lock_acquired_at;
+#    endif
+#  endif
 #  if !defined(HAVE_LOCKFREE_AO_OR) && defined(AO_HAVE_test_and_set_acquire) \
       && (!defined(NO_MANUAL_VDB) || defined(MPROTECT_VDB)                   \
           || defined(UFFDWP_VDB))
@@ -2060,6 +2291,18 @@ struct _GC_arrays {
 #  define GC_world_stopped_total_divisor GC_arrays._world_stopped_total_divisor
   unsigned _world_stopped_total_time;
   unsigned _world_stopped_total_divisor;
+
+#  ifdef THREADS
+  /*
+   * The total and maximum time taken to stop the world, i.e. from the
+   * beginning of `STOP_WORLD()` till all the threads are stopped.
+   * In nanoseconds; the total value may wrap.
+   */
+#    define GC_world_stop_total_ns GC_arrays._world_stop_total_ns
+#    define GC_world_stop_max_ns GC_arrays._world_stop_max_ns
+  word _world_stop_total_ns;
+  word _world_stop_max_ns;
+#  endif
 #endif
 
 #ifndef NO_FIND_LEAK
@@ -2097,6 +2340,54 @@ struct _GC_arrays {
    */
 #  define GC_reclaimed_bytes_before_gc GC_arrays._reclaimed_bytes_before_gc
   word _reclaimed_bytes_before_gc;
+
+  /*
+   * Number of the free lists refilled (while holding the allocator lock)
+   * by `GC_generic_malloc_many` and the total size of the objects those
+   * were refilled with; used for statistics only.
+   */
+#  define GC_fl_refill_count GC_arrays._fl_refill_count
+  word _fl_refill_count;
+#  define GC_fl_refill_bytes GC_arrays._fl_refill_bytes
+  word _fl_refill_bytes;
+
+#  ifndef GC_DISABLE_INCREMENTAL
+  /*
+   * Statistics of the minor (partial) collections: the number of such
+   * collections; the number of bytes allocated since the previous
+   * collection (i.e. the nursery) and the number of those which survived
+   * (thus promoted since the mark bits are kept), as of the latest minor
+   * collection; the total number of promoted bytes (may wrap).  Used for
+   * statistics only.
+   */
+#    define GC_minor_gc_no GC_arrays._minor_gc_no
+  word _minor_gc_no;
+#    define GC_nursery_bytes GC_arrays._nursery_bytes
+  word _nursery_bytes;
+#    define GC_nursery_survived_bytes GC_arrays._nursery_survived_bytes
+  word _nursery_survived_bytes;
+#    define GC_promoted_bytes GC_arrays._promoted_bytes
+  word _promoted_bytes;
+
+  /*
+   * Number of bytes in the accessible objects as of the end of the mark
+   * phase of the latest collection.
+   */
+#    define GC_in_use_after_gc GC_arrays._in_use_after_gc
+  word _in_use_after_gc;
+#  endif
+#endif
+
+#ifdef SIZE_CLASS_LOCKS
+  /*
+   * Number of bytes allocated (and reclaimed, respectively) by the refills
+   * done while holding the allocator lock in the reader mode, not added
+   * yet to `GC_bytes_allocd` (and `GC_bytes_found`).  Updated atomically.
+   */
+#  define GC_class_bytes_allocd GC_arrays._class_bytes_allocd
+  volatile AO_t _class_bytes_allocd;
+#  define GC_class_bytes_found GC_arrays._class_bytes_found
+  volatile AO_t _class_bytes_found;
 #endif
 
 #ifdef USE_MUNMAP
@@ -2113,8 +2404,10 @@ struct _GC_arrays {
 #  define GC_num_unmapped_regions 0
 #endif
 
-#define GC_all_nils GC_arrays._all_nils
+#ifndef FLAT_HDR_MAP
+#  define GC_all_nils GC_arrays._all_nils
   bottom_index *_all_nils;
+#endif
 
 #define GC_scan_ptr GC_arrays._scan_ptr
   struct hblk *_scan_ptr;
@@ -2129,6 +2422,32 @@ struct _GC_arrays {
    */
 #  define GC_first_nonempty GC_arrays._first_nonempty
   volatile ptr_t _first_nonempty;
+
+#  ifdef USE_MARK_DEQUES
+  /*
+   * The work-stealing deques of the markers, indexed by the marker id
+   * (zero for the initiating thread).  The number of allocated deques
+   * is `GC_n_mark_deques`.
+   */
+#    define GC_mark_deques GC_arrays._mark_deques
+  struct mark_deque_s *_mark_deques;
+#    define GC_n_mark_deques GC_arrays._n_mark_deques
+  unsigned _n_mark_deques;
+#  endif
+
+#  ifdef PARALLEL_STACK_SCAN
+  /*
+   * The stack sections collected by `GC_push_all_stack` to be scanned
+   * by the markers, the number of the collected ones and the capacity
+   * of the array.
+   */
+#    define GC_stack_ranges GC_arrays._stack_ranges
+  struct stack_range_s *_stack_ranges;
+#    define GC_n_stack_ranges GC_arrays._n_stack_ranges
+  size_t _n_stack_ranges;
+#    define GC_stack_ranges_size GC_arrays._stack_ranges_size
+  size_t _stack_ranges_size;
+#  endif
 #endif
 
 #ifndef THREADS
@@ -2490,6 +2809,18 @@ struct _GC_arrays {
 #define GC_aobjfreelist GC_arrays._aobjfreelist
   void *_aobjfreelist[MAXOBJGRANULES + 1];
 
+#ifdef BUMP_ALLOC
+  /*
+   * The not yet allocated part of the fresh block, per kind (`PTRFREE` or
+   * `NORMAL`) and size in granules, which is used after the free list of
+   * the same kind and size becomes empty.  The regions are released (i.e.
+   * their objects are put to the free lists) before the free lists are
+   * rebuilt by the collector.
+   */
+#  define GC_bump_regions GC_arrays._bump_regions
+  struct bump_region _bump_regions[GC_I_NORMAL + 1][MAXOBJGRANULES + 1];
+#endif
+
   /*
    * Uncollectible but traced objects.  Objects on this and `_auobjfreelist`
    * are always marked, except during garbage collections.
@@ -2545,6 +2876,15 @@ struct _GC_arrays {
       page_hash_table _dirty_pages;
 #endif
 
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_MANUAL_VDB)
+  /*
+   * Cards that were dirty at last `GC_read_dirty()` call, one bit per
+   * entry of `GC_card_table`.  Unused unless the manual VDB is on.
+   */
+#  define GC_grungy_cards GC_arrays._grungy_cards
+  word _grungy_cards[CARD_TABLE_ENTRIES / CPP_WORDSZ];
+#endif
+
 #if (defined(CHECKSUMS) && (defined(GWW_VDB) || defined(SOFT_VDB))) \
     || defined(PROC_VDB)
   /* A table to indicate the pages ever dirtied. */
@@ -2588,8 +2928,10 @@ struct _GC_arrays {
    * bits to compute the index in `GC_top_index`, and each entry points to
    * a hash chain.  The last entry in each chain is `GC_all_nils`.
    */
-#define GC_top_index GC_arrays._top_index
+#ifndef FLAT_HDR_MAP
+#  define GC_top_index GC_arrays._top_index
   bottom_index *_top_index[TOP_SZ];
+#endif
 
 #if defined(DYNAMIC_LOADING) && !defined(ANY_MSWIN) \
     && !defined(USE_PROC_FOR_LIBRARIES) && defined(HAVE_DL_ITERATE_PHDR)
@@ -2801,6 +3143,12 @@ GC_push_all_stack_sections(ptr_t lo, ptr_t hi,
  * Updated on every `GC_push_all_stacks()` call.
  */
 GC_EXTERN word GC_total_stacksize;
+
+/*
+ * The part of `GC_total_stacksize` which has not been rescanned because
+ * unchanged since the previous scan.
+ */
+GC_EXTERN word GC_stack_skipped_bytes;
 #endif
 
 #ifdef IA64
@@ -2973,6 +3321,22 @@ GC_INNER void GC_push_all_stack(void *b, void *t);
 #  define GC_push_all_stack(b, t) GC_push_all_eager(b, t)
 #endif
 
+#ifdef PARALLEL_STACK_SCAN
+/*
+ * Make `GC_push_all_stack` just collect the given stack sections (instead
+ * of pushing them) if there are parallel markers to scan the sections.
+ * Returns `FALSE` if the sections are pushed by the caller as usual.
+ */
+GC_INNER GC_bool GC_begin_parallel_stack_scan(void);
+
+/*
+ * Scan the stack sections collected since `GC_begin_parallel_stack_scan`
+ * by all the markers, each one pushing the referenced objects to its
+ * local mark stack before returning them to the global one.
+ */
+GC_INNER void GC_end_parallel_stack_scan(void);
+#endif
+
 #if !defined(NO_VDB_FOR_STATIC_ROOTS) || defined(USE_PROC_FOR_LIBRARIES)
 /*
  * Same as `GC_push_conditional` (does either of `GC_push_all` or
@@ -3408,10 +3772,96 @@ GC_INNER void GC_register_displacement_inner(size_t offset);
  * Allocate a new heap block for small objects of size `lg` (in granules)
  * and `kind`.  Add all of the block's objects to the free list for objects
  * of that size.  Set all mark bits if objects are uncollectible.
- * Will fail to do anything if out of memory.
+ * Will fail to do anything if out of memory.  If `BUMP_ALLOC`, then only
+ * one object is added to the free list for `PTRFREE` and `NORMAL` kinds,
+ * the rest of the block becomes the bump region of the size.
  */
 GC_INNER void GC_new_hblk(size_t lg, int kind);
 
+#ifdef BUMP_ALLOC
+/*
+ * Allocate an object of size `lg` (in granules) and `kind` (`PTRFREE` or
+ * `NORMAL`) from the bump region of the size.  The object is cleared
+ * if the kind requires.  Returns `NULL` if the region is exhausted.
+ * The caller should hold the allocator lock and account the allocated
+ * bytes.
+ */
+GC_INNER ptr_t GC_bump_alloc_inner(size_t lg, int kind);
+
+/*
+ * Put the remaining objects of all the bump regions to the corresponding
+ * free lists.  Called by the collector before the free lists are marked
+ * or cleared.
+ */
+GC_INNER void GC_release_bump_regions(void);
+
+#  ifdef THREAD_LOCAL_ALLOC
+/*
+ * Same as `GC_generic_malloc_many_batch` but, if a fresh block is needed
+ * (and `batch_bytes` is not less than `HBLKSIZE`), install it to `*region`
+ * instead of building a free list through it (`*result` is set only if
+ * the batch has more fresh blocks, otherwise it is left intact).
+ * `*region` should be exhausted on entry.  Used by the thread-local
+ * allocator.
+ */
+GC_INNER void GC_generic_malloc_many_bump(size_t lb_adjusted, int kind,
+                                          void **result, size_t batch_bytes,
+                                          struct bump_region *region);
+#  endif
+#endif
+
+#ifdef SIZE_CLASS_LOCKS
+/*
+ * Acquire (release) the lock of the size class of the small objects of
+ * the given `kind` and size `lg` (in granules).  A lock might be shared
+ * by a few size classes.  The caller should hold the allocator lock in
+ * the reader mode, and should not hold any other size class lock.
+ */
+GC_INNER void GC_lock_size_class(int kind, size_t lg);
+GC_INNER void GC_unlock_size_class(int kind, size_t lg);
+
+#  define LOCK_SIZE_CLASS(kind, lg)   \
+    do {                              \
+      if (GC_need_to_lock)            \
+        GC_lock_size_class(kind, lg); \
+    } while (0)
+#  define UNLOCK_SIZE_CLASS(kind, lg)   \
+    do {                                \
+      if (GC_need_to_lock)              \
+        GC_unlock_size_class(kind, lg); \
+    } while (0)
+
+/*
+ * Try to get a batch of about `batch_bytes` bytes (at least one object)
+ * of the small objects of `kind` and `lb_adjusted` bytes from the global
+ * free list, or by sweeping the blocks on the reclaim list, holding the
+ * allocator lock only in the reader mode (and the size class lock).
+ * On success, the list of objects is stored to `*result` (before the
+ * locks are released) and `TRUE` is returned.  Fails if a fresh block
+ * is needed, or a work should be done while holding the allocator lock
+ * exclusively (e.g. in the incremental mode).
+ */
+GC_INNER GC_bool GC_class_locked_refill(size_t lb_adjusted, int kind,
+                                        void **result, size_t batch_bytes);
+
+/*
+ * Add `GC_class_bytes_allocd` and `GC_class_bytes_found` to
+ * `GC_bytes_allocd` and `GC_bytes_found`, respectively.  The caller
+ * should hold the allocator lock (exclusively).
+ */
+GC_INNER void GC_add_class_bytes(void);
+#endif
+
+/*
+ * Same as `GC_generic_malloc_many` but the objects of a small size are
+ * returned in a batch of about `batch_bytes` bytes (at least one object,
+ * up to `MAX_REFILL_HBLKS` heap blocks) instead of roughly a heap block
+ * worth.  The objects of a reclaimed or fresh block exceeding the batch
+ * are put to the global free list.  Used by the thread-local allocator.
+ */
+GC_INNER void GC_generic_malloc_many_batch(size_t lb_adjusted, int kind,
+                                           void **result, size_t batch_bytes);
+
 /*
  * Build a free list for objects of size `lg` (in granules) inside heap
  * block `h`.  Clear objects inside `h` if `clear` argument is set.
@@ -3443,6 +3893,25 @@ GC_INNER struct hblk *GC_allochblk(size_t lb_adjusted, int kind,
  */
 GC_INNER void GC_freehblk(struct hblk *p);
 
+#ifdef USE_MUNMAP
+#  ifndef MUNMAP_HUGE_OBJ_BYTES
+/*
+ * The blocks of the deallocated objects not smaller than this are
+ * unmapped immediately.
+ */
+#    define MUNMAP_HUGE_OBJ_BYTES ((size_t)4 << 20) /*< 4 MiB */
+#  endif
+
+/*
+ * Same as `GC_freehblk` but intended for the blocks of large objects.
+ * If the object is huge (see `MUNMAP_HUGE_OBJ_BYTES`) and the memory
+ * unmapping is enabled, then the resulting free block is unmapped at once.
+ */
+GC_INNER void GC_free_large_hblk(struct hblk *p);
+#else
+#  define GC_free_large_hblk GC_freehblk
+#endif
+
 /*  Miscellaneous GC routines. */
 
 /*
@@ -3477,6 +3946,73 @@ GC_INNER void GC_continue_reclaim(size_t lg, int kind);
  */
 GC_INNER GC_bool GC_reclaim_all(GC_stop_func stop_func, GC_bool ignore_old);
 
+#ifdef PARALLEL_SWEEP
+/*
+ * Is the sweeping of the reclaim lists by the marker threads started
+ * by the last `GC_start_reclaim()` still in progress?  While this is set,
+ * the reclaim lists are accessed with the mark lock held.  Protected by
+ * the allocator lock.
+ */
+GC_EXTERN GC_bool GC_parallel_sweep_in_progress;
+
+/*
+ * Stop distributing the reclaim lists among the marker threads, wait
+ * for the blocks being swept by them, and move the resulting objects to
+ * the regular free lists.  Also waits for the free-list builders just as
+ * `GC_wait_for_reclaim()`.  Must be called before the mark bits are
+ * cleared.  Called with the allocator lock held.
+ */
+GC_INNER void GC_finish_parallel_sweep(void);
+#elif defined(PARALLEL_MARK)
+#  define GC_finish_parallel_sweep() GC_wait_for_reclaim()
+#endif
+
+#ifdef BACKGROUND_SWEEP
+/*
+ * Is the background sweeper requested?  Set by `GC_set_background_sweep()`
+ * or `GC_BACKGROUND_SWEEP` environment variable.
+ */
+GC_EXTERN GC_bool GC_background_sweep;
+
+/*
+ * Record that the free list of the given kind and size (in granules) has
+ * been found empty by the allocator.  The background sweeper sweeps the
+ * size classes in proportion to such events.  Called with the allocator
+ * lock held.
+ */
+GC_INNER void GC_note_sweep_demand(size_t lg, int kind);
+
+#  define NOTE_SWEEP_DEMAND(lg, kind)   \
+    do {                                \
+      if (GC_background_sweep)          \
+        GC_note_sweep_demand(lg, kind); \
+    } while (0)
+
+/*
+ * Do one pass of the background sweeper: sweep the blocks of the size
+ * classes in demand, limited by the recent allocation rate.  The allocator
+ * lock is acquired only if it is free, and is released periodically.
+ * Called from the sweeper thread holding no locks.  Returns `FALSE` if
+ * there is nothing to sweep until the next collection.
+ */
+GC_INNER GC_bool GC_sweep_in_background(void);
+
+/*
+ * Wake up the background sweeper thread (starting it if needed) after
+ * the reclaim lists are filled in by a collection.  Called with the
+ * allocator lock held.
+ */
+GC_INNER void GC_notify_sweeper(void);
+
+/*
+ * Acquire the allocator lock only if it is not held by another thread.
+ * Returns `TRUE` on success.
+ */
+GC_INNER GC_bool GC_try_lock(void);
+#else
+#  define NOTE_SWEEP_DEMAND(lg, kind) (void)0
+#endif
+
 /*
  * Generic procedure to rebuild a free list in `hbp` with header `hhdr`,
  * with objects of size `sz` bytes.  Add `list` to the end of the free list.
@@ -3520,6 +4056,14 @@ GC_EXTERN GC_bool GC_in_thread_creation;
  */
 GC_INNER void GC_collect_a_little_inner(size_t n_blocks);
 
+/*
+ * Same as `GC_collect_a_little_inner` but called from the allocation
+ * slow path (or while waiting for the collection completion) to do the
+ * share of the current thread.  The marking work is passed to the
+ * background marker if the mostly-concurrent marking mode is on.
+ */
+GC_INNER void GC_collect_a_little_on_alloc(size_t n_blocks);
+
 GC_INNER void *GC_malloc_kind_aligned_global(size_t lb, int kind,
                                              size_t align_m1);
 
@@ -3536,6 +4080,14 @@ GC_INNER void *GC_generic_malloc_aligned(size_t lb, int kind, unsigned flags,
  */
 GC_INNER void *GC_generic_malloc_inner(size_t lb, int kind, unsigned flags);
 
+/*
+ * Same as `GC_generic_malloc_inner` for a large object of `lb_adjusted`
+ * bytes (including `EXTRA_BYTES`) but never triggers a collection or
+ * the heap expansion, returns `NULL` instead.  The allocator lock
+ * should be held.
+ */
+GC_INNER void *GC_try_alloc_large_and_clear(size_t lb_adjusted, int kind);
+
 /*
  * Collect or expand heap in an attempt make the indicated number of
  * free blocks available.  Should be called until the blocks are
@@ -3617,6 +4169,40 @@ GC_INNER void GC_remove_counts(const struct hblk *h, size_t sz);
 /* A non-macro variant of the header location routine. */
 GC_INNER hdr *GC_find_header(const void *h);
 
+#ifdef THREADS
+/*
+ * The sequence number of the block headers state.  It is odd while the
+ * headers (or the header index) are being updated.  This lets `GC_base`
+ * and `GC_size` read the headers without acquiring the allocator lock:
+ * the result is discarded if the number has changed meanwhile.
+ */
+GC_EXTERN volatile AO_t GC_hdr_seq;
+
+/*
+ * Enclose an update of the block headers which could be observed by
+ * `GC_base` or `GC_size` (i.e. of `hb_sz` or `hb_flags`, or of the
+ * header index).  The allocator lock should be held.  May be nested.
+ */
+GC_INNER void GC_hdr_update_begin(void);
+GC_INNER void GC_hdr_update_end(void);
+
+/*
+ * Start the unsynchronized read of the block headers.  Returns the
+ * sequence number to be passed to `HDR_READ_VALID()`.
+ */
+#  define HDR_READ_BEGIN() AO_load_acquire(&GC_hdr_seq)
+
+/*
+ * Check that the headers have not been updated since `HDR_READ_BEGIN()`
+ * returned `seq`, i.e. the values read are consistent.
+ */
+#  define HDR_READ_VALID(seq) \
+    (((seq) & 1) == 0 && (AO_nop_read(), AO_load(&GC_hdr_seq) == (seq)))
+#else
+#  define GC_hdr_update_begin() (void)0
+#  define GC_hdr_update_end() (void)0
+#endif
+
 /*
  * Get `HBLKSIZE`-aligned heap memory chunk from the OS and add the
  * chunk to `GC_our_memory`.  Return `NULL` if out of memory.
@@ -3792,7 +4378,8 @@ GC_INNER void GC_debug_free_inner(void *p);
 
 /*
  * Unmap blocks that have not been recently touched.  This is the only
- * way blocks are ever unmapped.
+ * way blocks are ever unmapped (except for the blocks of the huge objects
+ * unmapped by `GC_free_large_hblk`).
  */
 GC_INNER void GC_unmap_old(unsigned threshold);
 
@@ -3806,6 +4393,44 @@ GC_INNER GC_bool GC_merge_unmapped(void);
 GC_INNER void GC_unmap(ptr_t start, size_t bytes);
 GC_INNER void GC_remap(ptr_t start, size_t bytes);
 
+/*
+ * The policy of returning the unmapped memory to the OS (one of
+ * `GC_UNMAP_POLICY_` values).  Should not be changed after the collector
+ * initialization.  Defined in `os_dep.c` file.
+ */
+GC_EXTERN int GC_unmap_policy;
+
+#  ifdef ASYNC_UNMAP
+/*
+ * Is the unmapping done by the dedicated thread?  Set by
+ * `GC_set_async_unmap()` or `GC_ASYNC_UNMAP` environment variable.
+ */
+GC_EXTERN GC_bool GC_async_unmap;
+
+/*
+ * Return the given page-aligned range to the OS according to
+ * `GC_unmap_policy`.  `GC_unmapped_bytes` is not updated.  No lock is
+ * required to be held.
+ */
+GC_INNER void GC_unmap_pages(ptr_t start_addr, size_t len);
+
+/*
+ * Put the given page-aligned range to the queue of the unmapper thread
+ * (starting the thread if needed).  Returns `FALSE` if the queue is full
+ * or the thread could not be started, the caller should unmap the range
+ * itself in this case.  Called with the allocator lock held.
+ */
+GC_INNER GC_bool GC_enqueue_unmap(ptr_t start_addr, size_t len);
+
+/*
+ * Remove the given range from the queue of the unmapper thread (if any
+ * part of it is still there), and wait for the completion of the unmapping
+ * of the range if it is in progress.  Called with the allocator lock held
+ * before the range is remapped.
+ */
+GC_INNER void GC_cancel_unmap(ptr_t start_addr, size_t len);
+#  endif
+
 /*
  * Two adjacent blocks have already been unmapped and are about to be merged.
  * Unmap the whole block.  This typically requires that we unmap a small
@@ -3896,6 +4521,16 @@ GC_INNER void GC_read_dirty(GC_bool output_unneeded);
  */
 GC_INNER GC_bool GC_page_was_dirty(const struct hblk *h);
 
+#  ifndef NO_MANUAL_VDB
+/*
+ * Is any card (see `GC_card_table`) overlapping [`start`, `limit`) marked
+ * dirty in the local buffer?  Always `FALSE` unless the manual VDB is on.
+ * Like `GC_page_was_dirty`, this may err on the side of labeling cards as
+ * dirty (as the card table is hashed by address).
+ */
+GC_INNER GC_bool GC_cards_were_dirty(ptr_t start, ptr_t limit);
+#  endif
+
 /*
  * Block `h` is about to be written or allocated shortly.  Ensure that
  * all pages containing any part of the `nblocks` `hblk` entities starting
@@ -4095,6 +4730,45 @@ GC_EXTERN unsigned GC_unmap_threshold; /*< defined in `alloc.c` file */
 GC_EXTERN GC_bool GC_force_unmap_on_gcollect;
 #endif
 
+#ifdef HUGE_PAGES_SUPPORTED
+#  ifndef HUGE_PAGE_SIZE
+/*
+ * The size (in bytes) of a transparent huge page.  Should be a power
+ * of two and a multiple of `GC_page_size`.
+ */
+#    define HUGE_PAGE_SIZE ((size_t)2 << 20) /*< 2 MiB */
+#  endif
+
+/*
+ * Back the heap sections by transparent huge pages.  Should not be
+ * changed after the collector initialization.  Defined in `os_dep.c`.
+ */
+GC_EXTERN GC_bool GC_huge_pages;
+#endif
+
+#ifdef FLAT_HDR_MAP
+#  ifndef GC_HEAP_RESERVE_SIZE
+/*
+ * The default size (in bytes) of the address space range reserved
+ * for the heap.  The heap cannot grow beyond it.
+ */
+#    define GC_HEAP_RESERVE_SIZE ((size_t)1 << 38) /*< 256 GiB */
+#  endif
+
+/*
+ * The size of the address space range to reserve for the heap.
+ * Could be set (by `GC_init`) before the collector initialization
+ * only.  Defined in `os_dep.c`.
+ */
+GC_EXTERN size_t GC_heap_reserve_size;
+
+/*
+ * Reserve the address space range for the heap and for the flat header
+ * map (if not yet).  Aborts on failure.  Called by `GC_init_headers`.
+ */
+GC_INNER void GC_init_heap_reserve(void);
+#endif
+
 #ifdef MSWIN32
 #  ifdef GC_WINNT
 #    define GC_no_win32_dlls FALSE
@@ -4414,6 +5088,16 @@ GC_INNER void GC_do_blocking_inner(ptr_t data, void *context);
  */
 GC_INNER void GC_push_all_stacks(void);
 
+#  ifdef STACK_WATERMARKS
+/*
+ * Find the cold part (unchanged since the recent scan) of each thread
+ * stack, which `GC_push_all_stacks` may skip, provided `marks_kept` (i.e.
+ * the mark bits set by that scan are not cleared).  Called with the world
+ * stopped at the beginning of the marking.
+ */
+GC_INNER void GC_update_stack_watermarks(GC_bool marks_kept);
+#  endif
+
 #  if defined(USE_PROC_FOR_LIBRARIES) && defined(LINUX)
 GC_INNER GC_bool GC_segment_is_thread_stack(ptr_t lo, ptr_t hi);
 #  endif
@@ -4610,12 +5294,100 @@ GC_INNER void GC_help_marker(word my_mark_no);
 
 GC_INNER void GC_start_mark_threads_inner(void);
 
+#  ifdef CONCURRENT_MARK
+/*
+ * Is the mostly-concurrent marking mode on?  Set by
+ * `GC_set_concurrent_mark()`; meaningful only in the incremental mode.
+ */
+GC_EXTERN GC_bool GC_concurrent_mark;
+
+/*
+ * `TRUE` while the background marker thread performs the marking steps
+ * which need the allocator lock (e.g. pushes the roots).  Used to skip
+ * the check that the collecting thread is registered.
+ */
+GC_EXTERN GC_bool GC_mark_in_background;
+
+/*
+ * Nonzero while the background marker thread traces the heap from the
+ * mark stack without holding the allocator lock.  Set only while the
+ * allocator lock is held.
+ */
+GC_EXTERN volatile AO_t GC_concurrent_drain_active;
+
+/*
+ * The number of the marking steps done by the background marker thread
+ * in the collection in progress and not yet claimed by the allocating
+ * threads instead of their own incremental marking steps.
+ */
+GC_EXTERN volatile AO_t GC_concurrent_mark_credit;
+
+/*
+ * Could the marking of the collection in progress make a step without
+ * the world stopped (and not completing the marking)?  The last step of
+ * marking (which is followed by the world-stopped one) is left to the
+ * mutator.  Called with the allocator lock held (and the mark stack not
+ * being drained).
+ */
+GC_INNER GC_bool GC_concurrent_mark_can_step(void);
+
+/*
+ * Wake up a marker thread to do the marking work of the collection in
+ * progress, unless it is already running.  Called with the allocator
+ * lock held.  Returns `FALSE` if there is nothing to do in the background.
+ */
+GC_INNER GC_bool GC_request_concurrent_mark(void);
+
+/*
+ * Do the marking work of the collection in progress until only the last
+ * step remains, or until a mutator needs the mark stack.  Called from
+ * a marker thread, holding no locks.
+ */
+GC_INNER void GC_concurrent_mark_steps(void);
+
+/*
+ * Release the allocator lock and trace the heap from the (nonempty) mark
+ * stack till it is empty, unless stopped by `GC_stop_concurrent_drain()`.
+ * Returns `TRUE` (with the allocator lock re-acquired) if the mark stack
+ * is drained, `FALSE` (with the allocator lock not held) if stopped.
+ * Called from the background marker thread holding the allocator lock.
+ */
+GC_INNER GC_bool GC_drain_mark_stack_unlocked(void);
+
+/*
+ * Wait for the background marker thread to stop tracing the heap without
+ * the allocator lock (if it does).  Should be called, with the allocator
+ * lock held, before the mark state, the mark stack or the block headers
+ * are updated, or the mark bits are cleared.  The marker cannot resume
+ * the tracing until the allocator lock is released.
+ */
+GC_INNER void GC_stop_concurrent_drain_inner(void);
+#    define GC_stop_concurrent_drain()             \
+      (AO_load(&GC_concurrent_drain_active) != 0 \
+           ? GC_stop_concurrent_drain_inner()     \
+           : (void)0)
+#  endif
+
+#  ifdef PARALLEL_SWEEP
+/*
+ * Sweep a portion of the reclaim lists on behalf of the collector if
+ * the parallel sweeping is in progress.  Called from a marker thread
+ * holding the mark lock only; the latter is released while sweeping.
+ * Returns `FALSE` if there is nothing to sweep.
+ */
+GC_INNER GC_bool GC_sweep_some_blocks(void);
+#  endif
+
 #  define INCR_MARKS(hhdr) \
     AO_store(&(hhdr)->hb_n_marks, AO_load(&(hhdr)->hb_n_marks) + 1)
 #else
 #  define INCR_MARKS(hhdr) (void)(++(hhdr)->hb_n_marks)
 #endif /* !PARALLEL_MARK */
 
+#ifndef CONCURRENT_MARK
+#  define GC_stop_concurrent_drain() (void)0
+#endif
+
 #if defined(SIGNAL_BASED_STOP_WORLD) && !defined(SIG_SUSPEND)
 /*
  * We define the thread suspension signal here, so that we can refer
@@ -2691,6 +2691,59 @@ extern char __global_base, __heap_base;
 #  define USE_MMAP_ANON
 #endif
 
+#if defined(LINUX) && defined(USE_MMAP) && !defined(NO_HUGE_PAGES) \
+    && !defined(CHERI_PURECAP) && !defined(HUGE_PAGES_SUPPORTED)
+/*
+ * Heap sections could be backed by transparent huge pages (the mode is
+ * turned on at run time).
+ */
+#  define HUGE_PAGES_SUPPORTED
+#endif
+
+#if defined(FLAT_HDR_MAP)                                    \
+    && (!defined(USE_MMAP_ANON) || CPP_WORDSZ != 64          \
+        || defined(CHERI_PURECAP) || defined(USE_MMAP_FIXED) \
+        || defined(NACL) || defined(SN_TARGET_PS3))
+/*
+ * The flat header map requires a large contiguous address space range
+ * to be reserved by an anonymous `mmap()` call.
+ */
+#  undef FLAT_HDR_MAP
+#endif
+
+#if defined(PERCPU_ALLOC)                                            \
+    && (!defined(THREAD_LOCAL_ALLOC) || !defined(GC_PTHREADS)        \
+        || !defined(LINUX) || !defined(X86_64) || !defined(__GNUC__) \
+        || !GC_GLIBC_PREREQ(2, 35))
+/*
+ * The per-CPU free lists rely on the restartable sequences registered
+ * by `glibc` (v2.35+), and the critical sections are implemented for
+ * x86_64 only.
+ */
+#  undef PERCPU_ALLOC
+#endif
+
+#if defined(USE_FUTEX_LOCK)                                             \
+    && (!defined(LINUX) || !defined(GC_PTHREADS) || defined(USE_RWLOCK) \
+        || defined(NO_CLOCK))
+/*
+ * The futex-based allocator lock is Linux-specific, it has no reader
+ * mode, and its statistics need a clock.
+ */
+#  undef USE_FUTEX_LOCK
+#endif
+
+#if defined(SAFEPOINT_STOP_WORLD)                                 \
+    && (!defined(LINUX) || !defined(GC_PTHREADS) || defined(NACL) \
+        || !defined(THREAD_LOCAL_ALLOC) || defined(E2K))
+/*
+ * The cooperative world stop parks threads on a futex; a parked thread
+ * is found by its thread-local free lists, and the register stack of E2K
+ * is saved only by the suspend signal handler.
+ */
+#  undef SAFEPOINT_STOP_WORLD
+#endif
+
 #if defined(CHERI_PURECAP) && defined(USE_MMAP)
 /* TODO: Currently turned off to avoid downgrading permissions on CHERI. */
 #  undef USE_MUNMAP
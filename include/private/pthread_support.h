@@ -85,6 +85,22 @@ struct GC_StackContext_Rep {
   /* Valid only in some platform-specific states. */
   ptr_t stack_ptr;
 
+#  ifdef STACK_WATERMARKS
+  /*
+   * The stack range covered by the recent scan of the stack (`NULL`
+   * `scanned_lo` means none), and the start of the part of the range
+   * unchanged since that scan (`NULL` means the whole stack should be
+   * scanned).  `stack_copy` holds a copy of the cold part of the scanned
+   * range (placed at the end of the buffer of `stack_copy_size` bytes).
+   * Protected by the allocator lock.
+   */
+  ptr_t scanned_lo;
+  ptr_t scanned_hi;
+  ptr_t stack_watermark;
+  ptr_t stack_copy;
+  size_t stack_copy_size;
+#  endif
+
 #  ifdef GC_WIN32_THREADS
 #    define ADDR_LIMIT ((ptr_t)GC_WORD_MAX)
   /*
@@ -270,6 +286,15 @@ struct GC_Thread_Rep {
    * handled a suspend signal.
    */
   volatile AO_t last_stop_count;
+#    ifdef SAFEPOINT_STOP_WORLD
+  /*
+   * The value of `GC_stop_count` when the thread parked itself at
+   * a safepoint, or that value with `THREAD_RESTARTED` bit set if the
+   * world stopper has decided to send the thread a suspend signal
+   * instead.  Updated by compare-and-swap from both sides.
+   */
+  volatile AO_t safepoint_state;
+#    endif
 #    ifdef GC_ENABLE_SUSPEND_THREAD
   /*
    * Note: an odd value means thread was suspended externally;
@@ -43,6 +43,17 @@ EXTERN_C_BEGIN
 #    endif
 #  endif /* !THREAD_FREELISTS_KINDS */
 
+#  ifdef MEDIUM_TL_ALLOC
+/*
+ * The number of the medium thread-local free lists per kind: one per
+ * each small object size (in granules) not covered by the tiny free
+ * lists (only the entries corresponding to `GC_size_map` values are in
+ * use), then one per each number of heap blocks of a large object.
+ */
+#    define MEDIUM_TL_FREELISTS \
+      ((int)(MAXOBJGRANULES + 1 - GC_TINY_FREELISTS + MEDIUM_MAX_HBLKS))
+#  endif /* MEDIUM_TL_ALLOC */
+
 /*
  * The first `GC_TINY_FREELISTS` free lists correspond to the first
  * `GC_TINY_FREELISTS` multiples of `GC_GRANULE_BYTES`, i.e. we keep
@@ -75,6 +86,37 @@ struct thread_local_freelists {
 #    define ERROR_FL GC_WORD_MAX
 #  endif
 
+#  ifdef BUMP_ALLOC
+  /*
+   * The fresh blocks the thread allocates `PTRFREE` and `NORMAL` objects
+   * from (by bumping) once the corresponding free list is exhausted.
+   * The not yet allocated objects are marked by the collector like the
+   * free lists.
+   */
+  struct bump_region bump_regions[NORMAL + 1][GC_TINY_FREELISTS];
+#  endif
+
+  /*
+   * The size (in bytes) of the next batch of objects to refill the tiny
+   * `PTRFREE` and `NORMAL` free lists (or bump regions) with, and the
+   * collection number (truncated) at the previous refill.  Zero size
+   * means no refill has happened yet.
+   */
+  unsigned refill_bytes[NORMAL + 1][GC_TINY_FREELISTS];
+  unsigned short refill_gc_no[NORMAL + 1][GC_TINY_FREELISTS];
+
+#  ifdef MEDIUM_TL_ALLOC
+  /*
+   * The free lists for medium objects (`NORMAL + 1` rows, indexed as
+   * described for `MEDIUM_TL_FREELISTS`), or `NULL` if the thread has
+   * not allocated any medium object yet.  The entries have the same
+   * meaning as those of `_freelists`.  The array is allocated separately
+   * to keep the thread descriptor a small object, as the allocation of
+   * a large one may cause some collection work in the incremental mode.
+   */
+  void *(*medium_freelists)[MEDIUM_TL_FREELISTS];
+#  endif
+
   /* Do not use local free lists for up to this much allocation. */
 #  define DIRECT_GRANULES (HBLKSIZE / GC_GRANULE_BYTES)
 };
@@ -178,9 +220,20 @@ GC_INNER void GC_destroy_thread_local(GC_tlfs p);
  */
 GC_INNER void GC_mark_thread_local_fls_for(GC_tlfs p);
 
+#  ifdef PERCPU_ALLOC
+/*
+ * Mark all the objects on the per-CPU free lists.  Called (with the
+ * world stopped) along with `GC_mark_thread_local_fls_for`.
+ */
+GC_INNER void GC_mark_percpu_freelists(void);
+#  endif
+
 #  ifdef GC_ASSERTIONS
 GC_bool GC_is_thread_tsd_valid(void *tsd);
 void GC_check_tls_for(GC_tlfs p);
+#    ifdef PERCPU_ALLOC
+void GC_check_percpu_freelists(void);
+#    endif
 #    if defined(USE_CUSTOM_SPECIFIC)
 void GC_check_tsd_marks(tsd *key);
 #    endif
@@ -35,6 +35,23 @@ GC_alloc_reclaim_list(struct obj_kind *ok)
   return TRUE;
 }
 
+/*
+ * Do the accounting for a large object of `lb_adjusted` bytes just
+ * allocated in block `h`.  Returns the object.
+ */
+static ptr_t
+note_large_allocd(struct hblk *h, size_t lb_adjusted)
+{
+  GC_bytes_allocd += lb_adjusted;
+  if (lb_adjusted > HBLKSIZE) {
+    GC_large_allocd_bytes += HBLKSIZE * OBJ_SZ_TO_BLOCKS(lb_adjusted);
+    if (GC_large_allocd_bytes > GC_max_large_allocd_bytes)
+      GC_max_large_allocd_bytes = GC_large_allocd_bytes;
+  }
+  /* FIXME: Do we need some way to reset `GC_max_large_allocd_bytes`? */
+  return h->hb_body;
+}
+
 /*
  * Allocate a large block of size `lb_adjusted` bytes with the requested
  * alignment (`align_m1 + 1`).  The block is not cleared.  We assume that
@@ -70,7 +87,7 @@ GC_alloc_large(size_t lb_adjusted, int kind, unsigned flags, size_t align_m1)
 
   /* Do our share of marking work. */
   if (GC_incremental && !GC_dont_gc) {
-    GC_collect_a_little_inner(n_blocks);
+    GC_collect_a_little_on_alloc(n_blocks);
   }
 
   h = GC_allochblk(lb_adjusted, kind, flags, align_m1);
@@ -91,14 +108,7 @@ GC_alloc_large(size_t lb_adjusted, int kind, unsigned flags, size_t align_m1)
     h = GC_allochblk(lb_adjusted, kind, flags, align_m1);
   }
 
-  GC_bytes_allocd += lb_adjusted;
-  if (lb_adjusted > HBLKSIZE) {
-    GC_large_allocd_bytes += HBLKSIZE * OBJ_SZ_TO_BLOCKS(lb_adjusted);
-    if (GC_large_allocd_bytes > GC_max_large_allocd_bytes)
-      GC_max_large_allocd_bytes = GC_large_allocd_bytes;
-  }
-  /* FIXME: Do we need some way to reset `GC_max_large_allocd_bytes`? */
-  result = h->hb_body;
+  result = note_large_allocd(h, lb_adjusted);
   GC_ASSERT((ADDR(result) & align_m1) == 0);
   return result;
 }
@@ -124,6 +134,24 @@ GC_alloc_large_and_clear(size_t lb_adjusted, int kind, unsigned flags)
   return result;
 }
 
+GC_INNER void *
+GC_try_alloc_large_and_clear(size_t lb_adjusted, int kind)
+{
+  struct hblk *h;
+  ptr_t result;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(lb_adjusted > MAXOBJBYTES
+            && (lb_adjusted & (GC_GRANULE_BYTES - 1)) == 0);
+  h = GC_allochblk(lb_adjusted, kind, 0 /* `flags` */, 0 /* `align_m1` */);
+  if (NULL == h)
+    return NULL;
+  result = note_large_allocd(h, lb_adjusted);
+  if (GC_debugging_started || GC_obj_kinds[kind].ok_init)
+    BZERO(result, HBLKSIZE * OBJ_SZ_TO_BLOCKS(lb_adjusted));
+  return result;
+}
+
 /*
  * Fill in additional entries in `GC_size_map`, including the `i`-th one.
  * Note that a filled in section of the array ending at `n` always has
@@ -214,6 +242,15 @@ GC_generic_malloc_inner_small(size_t lb, int kind)
       op = *opp;
     }
     if (NULL == op) {
+#ifdef BUMP_ALLOC
+      if (kind <= NORMAL) {
+        op = GC_bump_alloc_inner(lg, kind);
+        if (op != NULL) {
+          GC_bytes_allocd += GRANULES_TO_BYTES((word)lg);
+          return op;
+        }
+      }
+#endif
       if (NULL == ok->ok_reclaim_list && !GC_alloc_reclaim_list(ok))
         return NULL;
       op = GC_allocobj(lg, kind);
@@ -261,6 +298,7 @@ GC_generic_malloc_aligned(size_t lb, int kind, unsigned flags, size_t align_m1)
   void *result;
 
   GC_ASSERT(kind < MAXOBJKINDS);
+  GC_SAFEPOINT_POLL();
   if (UNLIKELY(get_have_errors()))
     GC_print_all_errors();
   GC_notify_or_invoke_finalizers();
@@ -358,6 +396,19 @@ GC_malloc_kind_aligned_global(size_t lb, int kind, size_t align_m1)
     size_t lg;
 
     GC_DBG_COLLECT_AT_MALLOC(lb);
+    GC_SAFEPOINT_POLL();
+#ifdef SIZE_CLASS_LOCKS
+    if (align_m1 < GC_GRANULE_BYTES) {
+      /* A racy read of the size map entry is fine here. */
+      lg = GC_size_map[lb];
+      if (LIKELY(lg != 0)
+          && GC_class_locked_refill(GRANULES_TO_BYTES(lg), kind, &op,
+                                    GRANULES_TO_BYTES(lg))) {
+        GC_ASSERT(NULL == obj_link(op));
+        return op;
+      }
+    }
+#endif
     LOCK();
     lg = GC_size_map[lb];
     opp = &GC_obj_kinds[kind].ok_freelist[lg];
@@ -380,6 +431,16 @@ GC_malloc_kind_aligned_global(size_t lb, int kind, size_t align_m1)
       GC_ASSERT((ADDR(op) & align_m1) == 0);
       return op;
     }
+#ifdef BUMP_ALLOC
+    if (kind <= NORMAL && align_m1 < GC_GRANULE_BYTES) {
+      op = GC_bump_alloc_inner(lg, kind);
+      if (LIKELY(op != NULL)) {
+        GC_bytes_allocd += GRANULES_TO_BYTES((word)lg);
+        UNLOCK();
+        return op;
+      }
+    }
+#endif
     UNLOCK();
   }
 
@@ -815,7 +876,7 @@ GC_free_internal(void *base, const hdr *hhdr, size_t clear_ofs,
       GC_large_allocd_bytes -= HBLKSIZE * OBJ_SZ_TO_BLOCKS(lb);
     }
     GC_ASSERT(ADDR(HBLKPTR(base)) == ADDR(hhdr->hb_block));
-    GC_freehblk(hhdr->hb_block);
+    GC_free_large_hblk(hhdr->hb_block);
   }
   FREE_PROFILER_HOOK(base);
 }
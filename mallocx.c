@@ -308,8 +308,148 @@ acquire_mark_lock_notify_builders(void)
 }
 #endif
 
-GC_API void GC_CALL
-GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
+#ifndef GC_GET_HEAP_USAGE_NOT_NEEDED
+#  define NOTE_FL_REFILL(bytes) \
+    (void)(GC_fl_refill_count++, GC_fl_refill_bytes += (word)(bytes))
+#else
+#  define NOTE_FL_REFILL(bytes) (void)0
+#endif
+
+/*
+ * Cut the free list `op` (of `*pbytes` bytes in total, each object is
+ * of `lb_adjusted` bytes) after `batch_bytes` bytes, and put the rest
+ * of it to the global free list pointed to by `gfl`.  `*pbytes` is
+ * updated accordingly.
+ */
+static void
+trim_fl_to_batch(void *op, size_t lb_adjusted, size_t batch_bytes,
+                 void **gfl, word *pbytes)
+{
+  void *p = op;
+  void *rest;
+  word bytes;
+
+  GC_ASSERT(I_HOLD_READER_LOCK());
+  GC_ASSERT(batch_bytes >= lb_adjusted);
+  if (*pbytes <= batch_bytes)
+    return;
+  for (bytes = lb_adjusted; bytes + lb_adjusted <= batch_bytes;
+       bytes += lb_adjusted) {
+    p = obj_link(p);
+  }
+  rest = obj_link(p);
+  obj_link(p) = NULL;
+  *pbytes = bytes;
+  if (*gfl != NULL) {
+    for (p = rest; obj_link(p) != NULL; p = obj_link(p)) {
+      /* Empty. */
+    }
+    obj_link(p) = *gfl;
+  }
+  *gfl = rest;
+}
+
+#ifdef SIZE_CLASS_LOCKS
+GC_INNER GC_bool
+GC_class_locked_refill(size_t lb_adjusted, int kind, void **result,
+                       size_t batch_bytes)
+{
+  struct obj_kind *ok = &GC_obj_kinds[kind];
+  size_t lg = BYTES_TO_GRANULES(lb_adjusted);
+  void **opp = &ok->ok_freelist[lg];
+  void *op;
+  word my_bytes_allocd = 0;
+  word my_bytes_found = 0;
+
+  GC_ASSERT(lb_adjusted <= MAXOBJBYTES && batch_bytes >= lb_adjusted);
+  READER_LOCK();
+  if (GC_incremental
+#  ifdef PARALLEL_SWEEP
+      || GC_parallel_sweep_in_progress
+#  endif
+#  ifdef ENABLE_DISCLAIM
+      || ok->ok_disclaim_proc != 0
+#  endif
+  ) {
+    READER_UNLOCK();
+    return FALSE;
+  }
+
+  LOCK_SIZE_CLASS(kind, lg);
+  op = *opp;
+  if (op != NULL) {
+    void *p;
+
+    /* Take a prefix of the global free list. */
+    for (p = op;; p = obj_link(p)) {
+      my_bytes_allocd += lb_adjusted;
+      if (my_bytes_allocd >= batch_bytes || NULL == obj_link(p)) {
+        *opp = obj_link(p);
+        obj_link(p) = NULL;
+        break;
+      }
+    }
+  } else if (ok->ok_reclaim_list != NULL) {
+    struct hblk **rlh = ok->ok_reclaim_list;
+    struct hblk *hbp;
+
+    while ((hbp = rlh[lg]) != NULL) {
+      hdr *hhdr = HDR(hbp);
+
+      rlh[lg] = hhdr->hb_next;
+      GC_ASSERT(hhdr->hb_sz == lb_adjusted);
+      hhdr->hb_last_reclaimed = (unsigned short)GC_gc_no;
+      op = GC_reclaim_generic(hbp, hhdr, lb_adjusted, ok->ok_init, (ptr_t)op,
+                              &my_bytes_allocd);
+      if (op != NULL && my_bytes_allocd >= batch_bytes)
+        break;
+    }
+    if (op != NULL) {
+      my_bytes_found = my_bytes_allocd;
+      trim_fl_to_batch(op, lb_adjusted, batch_bytes, opp, &my_bytes_allocd);
+    }
+  }
+  if (op != NULL)
+    *result = op;
+  UNLOCK_SIZE_CLASS(kind, lg);
+  READER_UNLOCK();
+
+  if (NULL == op)
+    return FALSE;
+  (void)AO_fetch_and_add(&GC_class_bytes_allocd, (AO_t)my_bytes_allocd);
+  if (my_bytes_found != 0)
+    (void)AO_fetch_and_add(&GC_class_bytes_found, (AO_t)my_bytes_found);
+  return TRUE;
+}
+
+GC_INNER void
+GC_add_class_bytes(void)
+{
+  AO_t bytes;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  bytes = AO_load(&GC_class_bytes_allocd);
+  if (bytes != 0) {
+    (void)AO_fetch_and_add(&GC_class_bytes_allocd, (AO_t)0 - bytes);
+    GC_bytes_allocd += (word)bytes;
+  }
+  bytes = AO_load(&GC_class_bytes_found);
+  if (bytes != 0) {
+    (void)AO_fetch_and_add(&GC_class_bytes_found, (AO_t)0 - bytes);
+    GC_bytes_found += (GC_signed_word)bytes;
+  }
+}
+#endif /* SIZE_CLASS_LOCKS */
+
+#ifdef BUMP_ALLOC
+STATIC void
+GC_generic_malloc_many_region(size_t lb_adjusted, int kind, void **result,
+                              size_t batch_bytes, struct bump_region *region)
+#else
+GC_INNER void
+GC_generic_malloc_many_batch(size_t lb_adjusted, int kind, void **result,
+                             size_t batch_bytes)
+#endif
 {
   void *op;
   void *p;
@@ -329,7 +469,7 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
    * TODO: `GC_dirty` should be called for each linked object (but the
    * last one) to support multiple objects allocation.
    */
-  if (UNLIKELY(lb_adjusted > MAXOBJBYTES) || GC_manual_vdb) {
+  if (UNLIKELY(lb_adjusted > MEDIUM_MAX_HBLKS * HBLKSIZE) || GC_manual_vdb) {
     op = GC_generic_malloc_aligned(lb_adjusted - EXTRA_BYTES, kind,
                                    0 /* `flags` */, 0 /* `align_m1` */);
     if (LIKELY(op != NULL))
@@ -346,33 +486,103 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
 
   GC_ASSERT(kind < MAXOBJKINDS);
   lg = BYTES_TO_GRANULES(lb_adjusted);
+  if (batch_bytes < lb_adjusted) {
+    batch_bytes = lb_adjusted;
+  } else if (batch_bytes > MAX_REFILL_HBLKS * HBLKSIZE) {
+    batch_bytes = MAX_REFILL_HBLKS * HBLKSIZE;
+  }
   if (UNLIKELY(get_have_errors()))
     GC_print_all_errors();
   GC_notify_or_invoke_finalizers();
   GC_DBG_COLLECT_AT_MALLOC(lb_adjusted - EXTRA_BYTES);
 
+#ifdef SIZE_CLASS_LOCKS
+  if (lb_adjusted <= MAXOBJBYTES
+      && GC_class_locked_refill(lb_adjusted, kind, result, batch_bytes)) {
+    (void)GC_clear_stack(NULL);
+    return;
+  }
+#endif
   LOCK();
   /* Do our share of marking work. */
   if (GC_incremental && !GC_dont_gc) {
-    GC_collect_a_little_inner(1);
+    GC_collect_a_little_on_alloc(1);
   }
 
-  /* First see if we can reclaim a page of objects waiting to be reclaimed. */
+  if (UNLIKELY(lb_adjusted > MAXOBJBYTES)) {
+    /*
+     * A batch of medium objects, each occupies its own heap block(s).
+     * Only the first allocation may collect garbage (or expand the heap),
+     * as a collection might reclaim the objects already linked (the links
+     * are not traced in case of pointer-free objects).
+     */
+    size_t i;
+    size_t n = MEDIUM_BATCH_HBLKS / OBJ_SZ_TO_BLOCKS(lb_adjusted);
+
+    op = GC_generic_malloc_inner(lb_adjusted - EXTRA_BYTES, kind,
+                                 0 /* `flags` */);
+    if (LIKELY(op != NULL)) {
+      obj_link(op) = NULL;
+      for (i = 1; i < n; i++) {
+        p = GC_try_alloc_large_and_clear(lb_adjusted, kind);
+        if (NULL == p)
+          break;
+        obj_link(p) = op;
+        op = p;
+      }
+      NOTE_FL_REFILL(i * lb_adjusted);
+    }
+    *result = op;
+    UNLOCK();
+    (void)GC_clear_stack(NULL);
+    return;
+  }
+
+  /*
+   * First see if we can reclaim a page (or a few) of objects waiting to
+   * be reclaimed.
+   */
   ok = &GC_obj_kinds[kind];
   rlh = ok->ok_reclaim_list;
+#ifdef BACKGROUND_SWEEP
+  if (GC_background_sweep) {
+    GC_note_sweep_demand(lg, kind);
+    /* Use up the free list built by the sweeper first. */
+    if (ok->ok_freelist[lg] != NULL)
+      rlh = NULL;
+  }
+#endif
+#ifdef PARALLEL_SWEEP
+  if (GC_parallel_sweep_in_progress) {
+    /* The reclaim lists are shared with the marker threads. */
+    if (NULL == ok->ok_freelist[lg])
+      GC_continue_reclaim(lg, kind);
+    rlh = NULL;
+  }
+#endif
   if (rlh != NULL) {
     struct hblk *hbp;
     hdr *hhdr;
 
+    op = NULL;
     while ((hbp = rlh[lg]) != NULL) {
       hhdr = HDR(hbp);
       rlh[lg] = hhdr->hb_next;
       GC_ASSERT(hhdr->hb_sz == lb_adjusted);
       hhdr->hb_last_reclaimed = (unsigned short)GC_gc_no;
 #ifdef PARALLEL_MARK
-      if (GC_parallel) {
+      /*
+       * A batch smaller than a block is reclaimed while holding the
+       * allocator lock, so that the rest of the block could be put to
+       * the global free list.
+       */
+      if (GC_parallel && batch_bytes >= HBLKSIZE) {
+        struct hblk *hbps[MAX_REFILL_HBLKS];
+        hdr *hhdrs[MAX_REFILL_HBLKS];
+        size_t i, n = 1;
         GC_signed_word my_bytes_allocd_tmp
             = (GC_signed_word)AO_load(&GC_bytes_allocd_tmp);
+
         GC_ASSERT(my_bytes_allocd_tmp >= 0);
         /*
          * We only decrement it while holding the allocator lock.
@@ -384,13 +594,27 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
                                  (AO_t)(-my_bytes_allocd_tmp));
           GC_bytes_allocd += (word)my_bytes_allocd_tmp;
         }
+
+        /* Take more blocks (if any) to reclaim for a bigger batch. */
+        hbps[0] = hbp;
+        hhdrs[0] = hhdr;
+        for (; n < batch_bytes / HBLKSIZE && (hbp = rlh[lg]) != NULL; n++) {
+          hhdr = HDR(hbp);
+          rlh[lg] = hhdr->hb_next;
+          GC_ASSERT(hhdr->hb_sz == lb_adjusted);
+          hhdr->hb_last_reclaimed = (unsigned short)GC_gc_no;
+          hbps[n] = hbp;
+          hhdrs[n] = hhdr;
+        }
         GC_acquire_mark_lock();
         ++GC_fl_builder_count;
         UNLOCK();
         GC_release_mark_lock();
 
-        op = GC_reclaim_generic(hbp, hhdr, lb_adjusted, ok->ok_init, NULL,
-                                &my_bytes_allocd);
+        for (i = 0; i < n; i++) {
+          op = GC_reclaim_generic(hbps[i], hhdrs[i], lb_adjusted, ok->ok_init,
+                                  (ptr_t)op, &my_bytes_allocd);
+        }
         if (op != NULL) {
           *result = op;
           (void)AO_fetch_and_add(&GC_bytes_allocd_tmp, (AO_t)my_bytes_allocd);
@@ -402,10 +626,15 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
           GC_release_mark_lock();
           LOCK();
           GC_bytes_found += (GC_signed_word)my_bytes_allocd;
+          NOTE_FL_REFILL(my_bytes_allocd);
           UNLOCK();
 #  else
-          /* The resulting `GC_bytes_found` may be inaccurate. */
+          /*
+           * The resulting `GC_bytes_found` (and the refill statistics)
+           * may be inaccurate.
+           */
           GC_bytes_found += (GC_signed_word)my_bytes_allocd;
+          NOTE_FL_REFILL(my_bytes_allocd);
           GC_release_mark_lock();
 #  endif
           (void)GC_clear_stack(NULL);
@@ -423,21 +652,30 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
         rlh = ok->ok_reclaim_list; /*< reload `rlh` after locking */
         if (UNLIKELY(NULL == rlh))
           break;
+#  ifdef PARALLEL_SWEEP
+        if (GC_parallel_sweep_in_progress)
+          break;
+#  endif
         continue;
       }
 #endif
 
-      op = GC_reclaim_generic(hbp, hhdr, lb_adjusted, ok->ok_init, NULL,
+      op = GC_reclaim_generic(hbp, hhdr, lb_adjusted, ok->ok_init, (ptr_t)op,
                               &my_bytes_allocd);
-      if (op != NULL) {
-        /* We also reclaimed memory, so we need to adjust that count. */
-        GC_bytes_found += (GC_signed_word)my_bytes_allocd;
-        GC_bytes_allocd += my_bytes_allocd;
-        *result = op;
-        UNLOCK();
-        (void)GC_clear_stack(NULL);
-        return;
-      }
+      if (op != NULL && my_bytes_allocd >= batch_bytes)
+        break;
+    }
+    if (op != NULL) {
+      /* We also reclaimed memory, so we need to adjust that count. */
+      GC_bytes_found += (GC_signed_word)my_bytes_allocd;
+      trim_fl_to_batch(op, lb_adjusted, batch_bytes, &ok->ok_freelist[lg],
+                       &my_bytes_allocd);
+      GC_bytes_allocd += my_bytes_allocd;
+      NOTE_FL_REFILL(my_bytes_allocd);
+      *result = op;
+      UNLOCK();
+      (void)GC_clear_stack(NULL);
+      return;
     }
   }
 
@@ -453,13 +691,14 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
     my_bytes_allocd = 0;
     for (p = op; p != NULL; p = obj_link(p)) {
       my_bytes_allocd += lb_adjusted;
-      if ((word)my_bytes_allocd >= HBLKSIZE) {
+      if ((word)my_bytes_allocd >= batch_bytes) {
         *opp = obj_link(p);
         obj_link(p) = NULL;
         break;
       }
     }
     GC_bytes_allocd += my_bytes_allocd;
+    NOTE_FL_REFILL(my_bytes_allocd);
 
   } else {
     /* Next try to allocate a new block worth of objects of this size. */
@@ -467,17 +706,65 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
         = GC_allochblk(lb_adjusted, kind, 0 /* `flags` */, 0 /* `align_m1` */);
 
     if (h != NULL) {
+      struct hblk *hbps[MAX_REFILL_HBLKS];
+      size_t i, n = 0;
+      size_t n_hblks = 1;
+      size_t hblk_bytes = HBLKSIZE - HBLKSIZE % lb_adjusted;
+
       if (IS_UNCOLLECTABLE(kind))
         GC_set_hdr_marks(HDR(h));
-      GC_bytes_allocd += HBLKSIZE - (HBLKSIZE % lb_adjusted);
+#ifdef BUMP_ALLOC
+      if (region != NULL && !GC_debugging_started
+          && batch_bytes >= HBLKSIZE) {
+        /*
+         * The objects are cleared by the thread-local allocator on
+         * demand.  The region is installed while holding the allocator
+         * lock, thus the collector never sees it half-updated.
+         */
+        GC_ASSERT(kind <= NORMAL);
+        region->limit = h->hb_body + hblk_bytes;
+        region->cur = h->hb_body;
+      } else
+#endif
+      /* else */ {
+        hbps[n++] = h;
+      }
+
+      /*
+       * Allocate more fresh blocks (if available without a collection
+       * or the heap growth) for a bigger batch.
+       */
+      for (; n_hblks < batch_bytes / HBLKSIZE; n_hblks++) {
+        h = GC_allochblk(lb_adjusted, kind, 0 /* `flags` */,
+                         0 /* `align_m1` */);
+        if (NULL == h)
+          break;
+        if (IS_UNCOLLECTABLE(kind))
+          GC_set_hdr_marks(HDR(h));
+        hbps[n++] = h;
+      }
+      my_bytes_allocd = n_hblks * hblk_bytes;
+      if (0 == n) {
+        /* Only the region is installed, `*result` is left intact. */
+        GC_bytes_allocd += my_bytes_allocd;
+        NOTE_FL_REFILL(my_bytes_allocd);
+        UNLOCK();
+        return;
+      }
 #ifdef PARALLEL_MARK
-      if (GC_parallel) {
+      if (GC_parallel && batch_bytes >= HBLKSIZE) {
+        GC_bytes_allocd += my_bytes_allocd;
+        NOTE_FL_REFILL(my_bytes_allocd);
         GC_acquire_mark_lock();
         ++GC_fl_builder_count;
         UNLOCK();
         GC_release_mark_lock();
 
-        op = GC_build_fl(h, NULL, lg, ok->ok_init || GC_debugging_started);
+        op = NULL;
+        for (i = 0; i < n; i++) {
+          op = GC_build_fl(hbps[i], (ptr_t)op, lg,
+                           ok->ok_init || GC_debugging_started);
+        }
         *result = op;
 
         acquire_mark_lock_notify_builders();
@@ -486,7 +773,14 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
       }
 #endif
 
-      op = GC_build_fl(h, NULL, lg, ok->ok_init || GC_debugging_started);
+      op = NULL;
+      for (i = 0; i < n; i++) {
+        op = GC_build_fl(hbps[i], (ptr_t)op, lg,
+                         ok->ok_init || GC_debugging_started);
+      }
+      trim_fl_to_batch(op, lb_adjusted, batch_bytes, opp, &my_bytes_allocd);
+      GC_bytes_allocd += my_bytes_allocd;
+      NOTE_FL_REFILL(my_bytes_allocd);
     } else {
       /*
        * As a last attempt, try allocating a single object.
@@ -494,8 +788,10 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
        */
       op = GC_generic_malloc_inner(lb_adjusted - EXTRA_BYTES, kind,
                                    0 /* `flags` */);
-      if (op != NULL)
+      if (op != NULL) {
         obj_link(op) = NULL;
+        NOTE_FL_REFILL(lb_adjusted);
+      }
     }
   }
 
@@ -504,6 +800,32 @@ GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
   (void)GC_clear_stack(NULL);
 }
 
+#ifdef BUMP_ALLOC
+GC_INNER void
+GC_generic_malloc_many_batch(size_t lb_adjusted, int kind, void **result,
+                             size_t batch_bytes)
+{
+  GC_generic_malloc_many_region(lb_adjusted, kind, result, batch_bytes, NULL);
+}
+
+#  ifdef THREAD_LOCAL_ALLOC
+GC_INNER void
+GC_generic_malloc_many_bump(size_t lb_adjusted, int kind, void **result,
+                            size_t batch_bytes, struct bump_region *region)
+{
+  GC_ASSERT(ADDR(region->cur) + lb_adjusted > ADDR(region->limit));
+  GC_generic_malloc_many_region(lb_adjusted, kind, result, batch_bytes,
+                                region);
+}
+#  endif
+#endif
+
+GC_API void GC_CALL
+GC_generic_malloc_many(size_t lb_adjusted, int kind, void **result)
+{
+  GC_generic_malloc_many_batch(lb_adjusted, kind, result, HBLKSIZE);
+}
+
 GC_API GC_ATTR_MALLOC void *GC_CALL
 GC_malloc_many(size_t lb)
 {
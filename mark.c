@@ -336,6 +336,7 @@ GC_clear_marks(void)
 {
   /* The initialization is needed for `GC_push_roots()`. */
   GC_ASSERT(GC_is_initialized);
+  GC_stop_concurrent_drain();
 
   GC_apply_to_all_blocks(clear_marks_for_block, NULL);
   GC_objects_are_marked = FALSE;
@@ -348,6 +349,9 @@ GC_initiate_gc(void)
 {
   GC_ASSERT(I_HOLD_LOCK());
   GC_ASSERT(GC_is_initialized);
+#ifdef STACK_WATERMARKS
+  GC_update_stack_watermarks(GC_incremental && GC_mark_state == MS_NONE);
+#endif
 #ifndef GC_DISABLE_INCREMENTAL
   if (GC_incremental) {
 #  ifdef CHECKSUMS
@@ -669,9 +673,30 @@ GC_invalidate_mark_state(void)
   GC_mark_stack_top = GC_mark_stack - 1;
 }
 
+#ifdef CONCURRENT_MARK
+/*
+ * Set by the background marker when the mark stack overflows while it
+ * traces the heap without the allocator lock.  Owned by the marker while
+ * `GC_concurrent_drain_active`; otherwise, accessed only with the
+ * allocator lock held.
+ */
+STATIC GC_bool GC_concurrent_drain_overflow = FALSE;
+#endif
+
 STATIC mse *
 GC_signal_mark_stack_overflow(mse *msp)
 {
+#ifdef CONCURRENT_MARK
+  if (AO_load(&GC_concurrent_drain_active)) {
+    /*
+     * The mark state cannot be updated without the allocator lock;
+     * the drain stops and the overflow is handled by
+     * `GC_handle_drain_overflow()`.
+     */
+    GC_concurrent_drain_overflow = TRUE;
+    return msp - GC_MARK_STACK_DISCARDS;
+  }
+#endif
   GC_mark_state = MS_INVALID;
 #ifdef PARALLEL_MARK
   /*
@@ -692,6 +717,180 @@ GC_signal_mark_stack_overflow(mse *msp)
   return msp - GC_MARK_STACK_DISCARDS;
 }
 
+#if !defined(NO_SIMD_PTRS_FILTER) && !defined(SMALL_CONFIG)          \
+    && !defined(CHERI_PURECAP) && !defined(NEED_FIXUP_POINTER)       \
+    && !defined(ENABLE_TRACE) && !(defined(E2K) && defined(USE_PTR_HWTAG)) \
+    && ALIGNMENT == (CPP_PTRSZ >> 3) && CPP_PTRSZ == CPP_WORDSZ      \
+    && (defined(__GNUC__) || defined(__clang__))                     \
+    && ((defined(X86_64) && defined(__SSE2__))                       \
+        || (defined(I386) && defined(__SSE2__))                      \
+        || (defined(AARCH64) && defined(__ARM_NEON)))
+/*
+ * Range-check several candidate pointers at once (using SIMD instructions)
+ * when scanning a region conservatively.
+ */
+#  define USE_SIMD_PTRS_FILTER
+#endif
+
+#ifdef USE_SIMD_PTRS_FILTER
+#  if defined(X86_64) || defined(I386)
+#    include <immintrin.h>
+#  else
+#    include <arm_neon.h>
+#  endif
+
+/* The number of pointers checked by a single call of a filter function. */
+#  define PTRS_FILTER_CHUNK 8
+
+/*
+ * A filter function loads `PTRS_FILTER_CHUNK` pointers starting at `p`
+ * (which is pointer-aligned), and returns a bit mask with the bit `i`
+ * set iff `p[i]` is a candidate pointer, i.e. `p[i] - lo1 < span`
+ * (the comparison is unsigned).  `lo1` is the least plausible heap address
+ * plus one, `span` is the greatest plausible heap address minus `lo1`.
+ * Thus the check is equivalent to the one done by the scalar code.
+ */
+typedef unsigned (*GC_ptrs_filter_proc)(const ptr_t *p, word lo1, word span);
+
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static unsigned
+ptrs_filter_scalar(const ptr_t *p, word lo1, word span)
+{
+  unsigned i;
+  unsigned mask = 0;
+
+  for (i = 0; i < PTRS_FILTER_CHUNK; i++) {
+    if (ADDR(p[i]) - lo1 < span)
+      mask |= 1U << i;
+  }
+  return mask;
+}
+
+#  if defined(X86_64)
+/*
+ * SSE2 has no 64-bit comparison, thus the unsigned `d < span` one is
+ * composed of the 32-bit signed comparisons of the halves (with the sign
+ * bits flipped).
+ */
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static unsigned
+ptrs_filter_sse2(const ptr_t *p, word lo1, word span)
+{
+  const __m128i vlo = _mm_set1_epi64x((long long)lo1);
+  const __m128i vsign = _mm_set1_epi32((int)0x80000000UL);
+  const __m128i vspan = _mm_xor_si128(_mm_set1_epi64x((long long)span), vsign);
+  unsigned i;
+  unsigned mask = 0;
+
+  for (i = 0; i < PTRS_FILTER_CHUNK; i += 2) {
+    __m128i d = _mm_xor_si128(
+        _mm_sub_epi64(_mm_loadu_si128((const __m128i *)(p + i)), vlo), vsign);
+    __m128i gt = _mm_cmpgt_epi32(vspan, d);
+    __m128i eq = _mm_cmpeq_epi32(vspan, d);
+    __m128i lt64 = _mm_or_si128(
+        gt, _mm_and_si128(eq, _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0))));
+
+    lt64 = _mm_shuffle_epi32(lt64, _MM_SHUFFLE(3, 3, 1, 1));
+    mask |= (unsigned)_mm_movemask_pd(_mm_castsi128_pd(lt64)) << i;
+  }
+  return mask;
+}
+
+#    if GC_GNUC_PREREQ(4, 9) || GC_CLANG_PREREQ(3, 8)
+#      define HAVE_PTRS_FILTER_AVX2
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+__attribute__((__target__("avx2"))) static unsigned
+ptrs_filter_avx2(const ptr_t *p, word lo1, word span)
+{
+  const __m256i vlo = _mm256_set1_epi64x((long long)lo1);
+  const __m256i vsign = _mm256_set1_epi64x((long long)SIGNB);
+  const __m256i vspan
+      = _mm256_xor_si256(_mm256_set1_epi64x((long long)span), vsign);
+  __m256i d0 = _mm256_xor_si256(
+      _mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)p), vlo), vsign);
+  __m256i d1 = _mm256_xor_si256(
+      _mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(p + 4)), vlo),
+      vsign);
+
+  return (unsigned)_mm256_movemask_pd(
+             _mm256_castsi256_pd(_mm256_cmpgt_epi64(vspan, d0)))
+         | ((unsigned)_mm256_movemask_pd(
+                _mm256_castsi256_pd(_mm256_cmpgt_epi64(vspan, d1)))
+            << 4);
+}
+#    endif
+#    define ptrs_filter_simd ptrs_filter_sse2
+
+#  elif defined(I386)
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static unsigned
+ptrs_filter_sse2(const ptr_t *p, word lo1, word span)
+{
+  const __m128i vlo = _mm_set1_epi32((int)lo1);
+  const __m128i vsign = _mm_set1_epi32((int)0x80000000UL);
+  const __m128i vspan = _mm_xor_si128(_mm_set1_epi32((int)span), vsign);
+  __m128i d0 = _mm_xor_si128(
+      _mm_sub_epi32(_mm_loadu_si128((const __m128i *)p), vlo), vsign);
+  __m128i d1 = _mm_xor_si128(
+      _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(p + 4)), vlo), vsign);
+
+  return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vspan, d0)))
+         | ((unsigned)_mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpgt_epi32(vspan, d1)))
+            << 4);
+}
+#    define ptrs_filter_simd ptrs_filter_sse2
+
+#  else /* AARCH64 */
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static unsigned
+ptrs_filter_neon(const ptr_t *p, word lo1, word span)
+{
+  const uint64x2_t vlo = vdupq_n_u64((uint64_t)lo1);
+  const uint64x2_t vspan = vdupq_n_u64((uint64_t)span);
+  unsigned i;
+  unsigned mask = 0;
+
+  for (i = 0; i < PTRS_FILTER_CHUNK; i += 2) {
+    uint64x2_t m = vcltq_u64(
+        vsubq_u64(vld1q_u64((const uint64_t *)(p + i)), vlo), vspan);
+
+    mask |= (((unsigned)vgetq_lane_u64(m, 0) & 1)
+             | (((unsigned)vgetq_lane_u64(m, 1) & 1) << 1))
+            << i;
+  }
+  return mask;
+}
+#    define ptrs_filter_simd ptrs_filter_neon
+#  endif
+
+/* The filter function chosen by `GC_init_ptrs_filter()`. */
+STATIC GC_ptrs_filter_proc GC_ptrs_filter = ptrs_filter_scalar;
+
+/*
+ * Choose the filter function depending on the CPU features available
+ * at run time.
+ */
+static void
+GC_init_ptrs_filter(void)
+{
+  if (NULL == GETENV("GC_DISABLE_SIMD")) {
+    GC_ptrs_filter = ptrs_filter_simd;
+#  ifdef HAVE_PTRS_FILTER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      GC_ptrs_filter = ptrs_filter_avx2;
+#  endif
+  }
+  GC_COND_LOG_PRINTF("Using %s candidate pointers filter\n",
+                     GC_ptrs_filter == ptrs_filter_scalar  ? "scalar"
+#  ifdef HAVE_PTRS_FILTER_AVX2
+                     : GC_ptrs_filter == ptrs_filter_avx2 ? "AVX2"
+#  endif
+                                                          : "SIMD");
+}
+#endif /* USE_SIMD_PTRS_FILTER */
+
 GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
 GC_INNER mse *
 GC_mark_from(mse *mark_stack_top, const mse *mark_stack, mse *mark_stack_limit)
@@ -703,6 +902,13 @@ GC_mark_from(mse *mark_stack_top, const mse *mark_stack, mse *mark_stack_limit)
   ptr_t limit = NULL; /*< the limit (incl.) of the current candidate range */
   ptr_t greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
   ptr_t least_ha = (ptr_t)GC_least_plausible_heap_addr;
+#ifdef USE_SIMD_PTRS_FILTER
+  GC_ptrs_filter_proc ptrs_filter = GC_ptrs_filter;
+  word filter_lo1 = ADDR(least_ha) + 1;
+  word filter_span = ADDR_LT(least_ha, greatest_ha)
+                         ? ADDR(greatest_ha) - filter_lo1
+                         : 0;
+#endif
   DECLARE_HDR_CACHE;
 
 #define SPLIT_RANGE_PTRS 128 /*< must be power of 2 */
@@ -971,6 +1177,32 @@ GC_mark_from(mse *mark_stack_top, const mse *mark_stack, mse *mark_stack_limit)
       }
 #endif
 
+#ifdef USE_SIMD_PTRS_FILTER
+      /*
+       * Range-check the candidate pointers by chunks, most of the words
+       * are expected to fail the check.  The candidate is reloaded and
+       * checked again as the object could be updated meanwhile by a client
+       * thread (e.g., in the mostly-concurrent marking mode).
+       */
+      for (;
+           ADDR_GE(limit, current_p + PTRS_TO_BYTES(PTRS_FILTER_CHUNK - 1));
+           current_p += PTRS_TO_BYTES(PTRS_FILTER_CHUNK)) {
+        unsigned mask
+            = ptrs_filter((const ptr_t *)current_p, filter_lo1, filter_span);
+
+        PREFETCH(current_p + PREF_DIST * CACHE_LINE_SIZE);
+        while (mask != 0) {
+          ptr_t *pq = (ptr_t *)current_p + __builtin_ctz(mask);
+
+          mask &= mask - 1;
+          q = *pq;
+          if (ADDR_LT(least_ha, q) && ADDR_LT(q, greatest_ha)) {
+            PREFETCH(q);
+            PUSH_CONTENTS(q, mark_stack_top, mark_stack_limit, (ptr_t)pq);
+          }
+        }
+      }
+#endif
       for (; ADDR_GE(limit, current_p); current_p += ALIGNMENT) {
         /*
          * Empirically, unrolling this loop does not help a lot.
@@ -1027,9 +1259,26 @@ STATIC unsigned GC_helper_count = 0;
 /*
  * Number of active helpers.  May increase and decrease within each
  * mark cycle; but once it returns to zero, it stays for the cycle.
- * Protected by the mark lock.
  */
+#  ifdef USE_MARK_DEQUES
+/* Updated atomically, without holding the mark lock. */
+STATIC volatile AO_t GC_active_count = 0;
+
+/*
+ * Number of helpers which have run out of work and look for something
+ * to steal.  This is a hint for the active helpers to share their work.
+ */
+STATIC volatile AO_t GC_idle_count = 0;
+
+/*
+ * Number of helpers blocked in `GC_wait_marker()` waiting for more work.
+ * Updated with the mark lock held, but read asynchronously.
+ */
+STATIC volatile AO_t GC_sleeping_count = 0;
+#  else
+/* Protected by the mark lock. */
 STATIC unsigned GC_active_count = 0;
+#  endif
 
 GC_INNER GC_signed_word GC_fl_builder_count = 0;
 
@@ -1043,6 +1292,189 @@ GC_INNER GC_signed_word GC_fl_builder_count = 0;
 #    define LOCAL_MARK_STACK_SIZE HBLKSIZE
 #  endif
 
+#  ifdef USE_MARK_DEQUES
+#    ifndef MARK_DEQUE_SIZE
+/* The capacity of each deque (in entries).  Should be a power of two. */
+#      define MARK_DEQUE_SIZE LOCAL_MARK_STACK_SIZE
+#    endif
+
+/*
+ * A Chase-Lev work-stealing deque of mark stack entries.  Only the owner
+ * of the deque pushes and pops entries at its `bottom` end, while the
+ * other markers steal the entries at its `top` end.  The entries are in
+ * a circular buffer; `top` never decreases during a mark phase.
+ * The indices are placed in separate cache lines to avoid false sharing
+ * between the owner and the thieves.
+ */
+struct mark_deque_s {
+  volatile AO_t top;
+  char pad1[CACHE_LINE_SIZE - sizeof(AO_t)];
+  volatile AO_t bottom;
+  char pad2[CACHE_LINE_SIZE - sizeof(AO_t)];
+  mse entries[MARK_DEQUE_SIZE];
+};
+
+#    define MARK_DEQUE_ENTRY(d, i) \
+      (&(d)->entries[(size_t)(i) & (MARK_DEQUE_SIZE - 1)])
+
+/*
+ * Empty all the deques.  Called by the initiating thread before the
+ * helpers are woken up.
+ */
+static void
+reset_mark_deques(void)
+{
+  unsigned i;
+
+  GC_STATIC_ASSERT((MARK_DEQUE_SIZE & (MARK_DEQUE_SIZE - 1)) == 0);
+  for (i = 0; i < GC_n_mark_deques; ++i) {
+    AO_store(&GC_mark_deques[i].top, 0);
+    AO_store(&GC_mark_deques[i].bottom, 0);
+  }
+}
+
+/*
+ * Push up to `n` entries starting at `src` (the oldest one first) to
+ * the deque `d` owned by the caller.  Returns the number of entries
+ * pushed, it is less than `n` if the deque is full.
+ */
+static size_t
+mark_deque_push(struct mark_deque_s *d, const mse *src, size_t n)
+{
+  AO_t b = AO_load(&d->bottom); /*< only the owner modifies it */
+  size_t i;
+  size_t room = MARK_DEQUE_SIZE - (size_t)(b - AO_load_acquire(&d->top));
+
+  if (n > room)
+    n = room;
+  for (i = 0; i < n; ++i) {
+    mse *e = MARK_DEQUE_ENTRY(d, b + i);
+
+    GC_cptr_store(&e->mse_start, src[i].mse_start);
+    AO_store(&e->mse_descr, src[i].mse_descr);
+  }
+  /* Publish the entries to the thieves. */
+  AO_store_release(&d->bottom, b + n);
+  return n;
+}
+
+/*
+ * Pop the most recently pushed entry from the deque `d` owned by the
+ * caller, and store it to `*dst`.  Returns `FALSE` if the deque is
+ * empty (or its last entry has been stolen concurrently).
+ */
+static GC_bool
+mark_deque_pop(struct mark_deque_s *d, mse *dst)
+{
+  AO_t b = AO_load(&d->bottom);
+  AO_t t;
+  mse *e;
+  GC_bool res = TRUE;
+
+  if (AO_load(&d->top) == b)
+    return FALSE;
+  AO_store(&d->bottom, --b);
+  /* The store of `bottom` should be ordered before the load of `top`. */
+  AO_nop_full();
+  t = AO_load(&d->top);
+  if ((GC_signed_word)(b - t) < 0) {
+    /* The deque has been emptied by the thieves. */
+    AO_store(&d->bottom, t);
+    return FALSE;
+  }
+  e = MARK_DEQUE_ENTRY(d, b);
+  dst->mse_start = e->mse_start;
+  dst->mse_descr = AO_load(&e->mse_descr);
+  if (b == t) {
+    /* This is the last entry, compete for it with the thieves. */
+    res = (GC_bool)AO_compare_and_swap_full(&d->top, t, t + 1);
+    AO_store(&d->bottom, t + 1);
+  }
+  return res;
+}
+
+/*
+ * Steal the oldest entry from the deque `d` of another marker, and store
+ * it to `*dst`.  Returns `FALSE` if the deque is empty or we lost a race
+ * with the owner or another thief.
+ */
+static GC_bool
+mark_deque_steal(struct mark_deque_s *d, mse *dst)
+{
+  AO_t t = AO_load_acquire(&d->top);
+  AO_t b;
+  mse *e;
+  ptr_t start;
+  word descr;
+
+  /* The load of `top` should be ordered before the load of `bottom`. */
+  AO_nop_full();
+  b = AO_load_acquire(&d->bottom);
+  if ((GC_signed_word)(b - t) <= 0)
+    return FALSE;
+
+  /*
+   * The entry cannot be overwritten by the owner until `top` is advanced,
+   * thus the values read are valid if the CAS below succeeds.
+   */
+  e = MARK_DEQUE_ENTRY(d, t);
+  start = GC_cptr_load(&e->mse_start);
+  descr = AO_load(&e->mse_descr);
+  if (!AO_compare_and_swap_full(&d->top, t, t + 1))
+    return FALSE;
+  dst->mse_start = start;
+  dst->mse_descr = descr;
+  return TRUE;
+}
+
+/*
+ * Steal about half of the entries of the deque `d` (but not more than
+ * `max_n` ones) to the local mark stack `local`.  Returns the new top of
+ * the local mark stack (`local - 1` if nothing is stolen).
+ */
+static mse *
+mark_deque_steal_half(struct mark_deque_s *d, mse *local, size_t max_n)
+{
+  mse *top = local - 1;
+  GC_signed_word n_on_deque
+      = (GC_signed_word)(AO_load(&d->bottom) - AO_load(&d->top));
+  size_t n_to_get;
+
+  if (n_on_deque <= 0)
+    return top;
+  n_to_get = ((size_t)n_on_deque + 1) / 2;
+  if (n_to_get > max_n)
+    n_to_get = max_n;
+  for (; n_to_get > 0; --n_to_get) {
+    if (!mark_deque_steal(d, top + 1))
+      break;
+    ++top;
+  }
+  return top;
+}
+
+/*
+ * Check whether there is an entry in the global mark stack or in any
+ * deque.  The result is just a hint.
+ */
+static GC_bool
+has_mark_work(void)
+{
+  unsigned i;
+
+  if (ADDR_GE(GC_cptr_load((volatile ptr_t *)&GC_mark_stack_top),
+              GC_cptr_load(&GC_first_nonempty)))
+    return TRUE;
+  for (i = 0; i < GC_n_mark_deques; ++i) {
+    struct mark_deque_s *d = &GC_mark_deques[i];
+
+    if ((GC_signed_word)(AO_load(&d->bottom) - AO_load(&d->top)) > 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+#  endif /* USE_MARK_DEQUES */
+
 GC_INNER void
 GC_wait_for_markers_init(void)
 {
@@ -1070,6 +1502,18 @@ GC_wait_for_markers_init(void)
     if (NULL == GC_main_local_mark_stack)
       ABORT("Insufficient memory for main local_mark_stack");
   }
+#  ifdef USE_MARK_DEQUES
+  if (GC_n_mark_deques < (unsigned)GC_markers_m1 + 1) {
+    size_t bytes_to_get = ROUNDUP_PAGESIZE_IF_MMAP(
+        ((size_t)GC_markers_m1 + 1) * sizeof(struct mark_deque_s));
+
+    /* Note: the old deques (if any) are leaked. */
+    GC_mark_deques = (struct mark_deque_s *)GC_os_get_mem(bytes_to_get);
+    if (NULL == GC_mark_deques)
+      ABORT("Insufficient memory for marker deques");
+    GC_n_mark_deques = (unsigned)GC_markers_m1 + 1;
+  }
+#  endif
 
   /*
    * Reuse the mark lock and builders count to synchronize marker threads
@@ -1162,10 +1606,262 @@ GC_return_mark_stack(mse *low, mse *high)
   GC_notify_all_marker();
 }
 
-#  ifndef N_LOCAL_ITERS
-#    define N_LOCAL_ITERS 1
+#  ifndef ENTRIES_TO_GET
+#    define ENTRIES_TO_GET 5
 #  endif
 
+#  ifdef USE_MARK_DEQUES
+#    ifndef MARK_IDLE_SPIN_MAX
+/*
+ * Number of attempts to find some work before an idle helper blocks
+ * waiting for it.
+ */
+#      define MARK_IDLE_SPIN_MAX 256
+#    endif
+
+/*
+ * Move `n` oldest entries of the local mark stack to the deque owned by
+ * the caller (or to the global mark stack if the deque is full), and
+ * wake up the helpers sleeping because of lack of work, if any.
+ * Returns the new top of the local mark stack.
+ */
+static mse *
+share_local_mark_stack(struct mark_deque_s *my_deque, mse *local_mark_stack,
+                       mse *local_top, size_t n)
+{
+  size_t n_pushed = mark_deque_push(my_deque, local_mark_stack, n);
+
+  if (n_pushed < n) {
+    /* The deque is full; use the global mark stack for the overflow. */
+    GC_return_mark_stack(local_mark_stack + n_pushed,
+                         local_mark_stack + n - 1);
+  }
+  memmove(local_mark_stack, local_mark_stack + n,
+          (local_top - local_mark_stack + 1 - n) * sizeof(mse));
+
+  /*
+   * The store of `bottom` of the deque should be ordered before the load
+   * of `GC_sleeping_count`, this pairs with the fence in `wait_for_work`.
+   */
+  AO_nop_full();
+  if (AO_load(&GC_sleeping_count) > 0) {
+    GC_acquire_mark_lock();
+    GC_notify_all_marker();
+    GC_release_mark_lock();
+  }
+  return local_top - n;
+}
+
+/*
+ * Mark from the local mark stack.  On return, the local mark stack
+ * is empty.  Part of the local mark stack is moved to the deque of the
+ * marker if the local stack is in danger of overflowing, or if another
+ * helper is looking for work and the deque is empty.  We do not hold
+ * the mark lock.
+ */
+STATIC void
+GC_do_local_mark(mse *local_mark_stack, mse *local_top,
+                 struct mark_deque_s *my_deque)
+{
+  for (;;) {
+    size_t n_on_stack;
+
+    local_top = GC_mark_from(local_top, local_mark_stack,
+                             local_mark_stack + LOCAL_MARK_STACK_SIZE);
+    if (ADDR_LT((ptr_t)local_top, (ptr_t)local_mark_stack))
+      return;
+    n_on_stack = (size_t)(local_top - local_mark_stack) + 1;
+    if (n_on_stack >= LOCAL_MARK_STACK_SIZE / 2
+        || (n_on_stack > 1 && AO_load(&GC_idle_count) > 0
+            && AO_load(&my_deque->top) == AO_load(&my_deque->bottom))) {
+      /*
+       * The entries near the bottom of the stack are likely to require
+       * more work.  Thus we share those.
+       */
+      local_top = share_local_mark_stack(my_deque, local_mark_stack,
+                                         local_top, n_on_stack / 2);
+    }
+  }
+}
+
+/*
+ * Steal some entries from the global mark stack (starting at
+ * `*pmy_first_nonempty`) to `local_mark_stack`.  Returns the new top
+ * of the local mark stack.  `*pmy_first_nonempty` and `GC_first_nonempty`
+ * are updated to reflect the progress.
+ */
+static mse *
+steal_global_mark_stack(mse *local_mark_stack, mse **pmy_first_nonempty)
+{
+  mse *my_first_nonempty = *pmy_first_nonempty;
+  mse *global_first_nonempty = (mse *)GC_cptr_load(&GC_first_nonempty);
+  mse *my_top, *local_top;
+  size_t n_on_stack, n_to_get;
+
+  if (ADDR_LT((ptr_t)my_first_nonempty, (ptr_t)global_first_nonempty))
+    my_first_nonempty = global_first_nonempty;
+  my_top = (mse *)GC_cptr_load_acquire((volatile ptr_t *)&GC_mark_stack_top);
+  if (ADDR_LT((ptr_t)my_top, (ptr_t)my_first_nonempty)) {
+    *pmy_first_nonempty = my_first_nonempty;
+    return local_mark_stack - 1;
+  }
+  n_on_stack = (size_t)(my_top - my_first_nonempty) + 1;
+  n_to_get = n_on_stack < 2 * ENTRIES_TO_GET ? 1 : ENTRIES_TO_GET;
+  local_top = GC_steal_mark_stack(my_first_nonempty, my_top, local_mark_stack,
+                                  n_to_get, &my_first_nonempty);
+  GC_ASSERT(ADDR_GE((ptr_t)my_first_nonempty, (ptr_t)GC_mark_stack)
+            && ADDR_GE(GC_cptr_load((volatile ptr_t *)&GC_mark_stack_top)
+                           + sizeof(mse),
+                       (ptr_t)my_first_nonempty));
+
+  /*
+   * Advance `GC_first_nonempty`; unlike the shared hand-off scheme, the
+   * helpers rely on it (not on the mark lock) to detect that the global
+   * mark stack is empty.
+   */
+  for (;;) {
+    global_first_nonempty = (mse *)GC_cptr_load(&GC_first_nonempty);
+    if (ADDR_GE((ptr_t)global_first_nonempty, (ptr_t)my_first_nonempty)
+        || GC_cptr_compare_and_swap(&GC_first_nonempty,
+                                    (ptr_t)global_first_nonempty,
+                                    (ptr_t)my_first_nonempty))
+      break;
+  }
+  *pmy_first_nonempty = my_first_nonempty;
+  return local_top;
+}
+
+/*
+ * Called by a helper which has run out of work.  Waits until either
+ * some work appears in the global mark stack or in a deque, or all the
+ * helpers run out of work.  Returns `FALSE` in the latter case, i.e.
+ * when the mark phase is complete.  We do not hold the mark lock.
+ */
+static GC_bool
+wait_for_work(void)
+{
+  unsigned spins = 0;
+  GC_bool res;
+
+  (void)AO_fetch_and_add1(&GC_idle_count);
+  if (AO_fetch_and_sub1(&GC_active_count) == 1) {
+    /* We are the last active helper; wake up the sleeping ones. */
+    GC_acquire_mark_lock();
+    GC_notify_all_marker();
+    GC_release_mark_lock();
+    res = FALSE;
+  } else {
+    for (;;) {
+      if (0 == AO_load(&GC_active_count)) {
+        /*
+         * No active helper means no more work could appear, as only
+         * active helpers put the entries to the deques and the global
+         * mark stack, and an idle one does not own any entry.
+         */
+        res = FALSE;
+        break;
+      }
+      if (has_mark_work()) {
+        (void)AO_fetch_and_add1(&GC_active_count);
+        res = TRUE;
+        break;
+      }
+      if (++spins < MARK_IDLE_SPIN_MAX) {
+        AO_compiler_barrier();
+        continue;
+      }
+
+      GC_acquire_mark_lock();
+      (void)AO_fetch_and_add1(&GC_sleeping_count);
+      /* This pairs with the fence in `share_local_mark_stack`. */
+      AO_nop_full();
+      while (AO_load(&GC_active_count) > 0 && !has_mark_work()) {
+        /*
+         * We will be notified if either `GC_active_count` reaches zero,
+         * or if more entries are pushed to a deque or to the global
+         * mark stack.
+         */
+        GC_wait_marker();
+      }
+      (void)AO_fetch_and_sub1(&GC_sleeping_count);
+      GC_release_mark_lock();
+      spins = 0;
+    }
+  }
+  (void)AO_fetch_and_sub1(&GC_idle_count);
+  return res;
+}
+
+/*
+ * Mark using the local mark stack until the global mark stack and all
+ * the deques are empty and there are no active workers.  The work is
+ * taken from the own deque first, then from the global mark stack
+ * (which is filled initially by the roots and used later only for the
+ * deque overflows), then stolen from the deques of the other markers.
+ * Update `GC_first_nonempty` to reflect the progress.  Caller holds
+ * the mark lock.  Caller has already incremented `GC_helper_count`;
+ * we decrement it, and maintain `GC_active_count`.
+ */
+STATIC void
+GC_mark_local(mse *local_mark_stack, int id)
+{
+  struct mark_deque_s *my_deque;
+  mse *my_first_nonempty;
+  unsigned victim = (unsigned)id;
+
+  GC_ASSERT((unsigned)id < GC_n_mark_deques);
+  my_deque = &GC_mark_deques[id];
+  (void)AO_fetch_and_add1(&GC_active_count);
+  my_first_nonempty = (mse *)GC_cptr_load(&GC_first_nonempty);
+  GC_ASSERT(ADDR_GE((ptr_t)my_first_nonempty, (ptr_t)GC_mark_stack));
+  GC_ASSERT(
+      ADDR_GE(GC_cptr_load((volatile ptr_t *)&GC_mark_stack_top) + sizeof(mse),
+              (ptr_t)my_first_nonempty));
+  GC_VERBOSE_LOG_PRINTF("Starting mark helper %d\n", id);
+  GC_release_mark_lock();
+  for (;;) {
+    mse *local_top;
+    unsigned i;
+
+    if (mark_deque_pop(my_deque, local_mark_stack)) {
+      local_top = local_mark_stack;
+    } else {
+      local_top
+          = steal_global_mark_stack(local_mark_stack, &my_first_nonempty);
+      for (i = 1; i < GC_n_mark_deques
+                  && ADDR_LT((ptr_t)local_top, (ptr_t)local_mark_stack);
+           ++i) {
+        /* Visit the victims in a round-robin manner. */
+        if (++victim >= GC_n_mark_deques)
+          victim = 0;
+        if (victim == (unsigned)id && ++victim >= GC_n_mark_deques)
+          victim = 0;
+        local_top = mark_deque_steal_half(&GC_mark_deques[victim],
+                                          local_mark_stack,
+                                          LOCAL_MARK_STACK_SIZE / 4);
+      }
+    }
+    if (ADDR_GE((ptr_t)local_top, (ptr_t)local_mark_stack)) {
+      GC_do_local_mark(local_mark_stack, local_top, my_deque);
+    } else if (!wait_for_work()) {
+      break;
+    }
+  }
+
+  GC_acquire_mark_lock();
+  GC_ASSERT(AO_load(&my_deque->top) == AO_load(&my_deque->bottom));
+  GC_helper_count--;
+  GC_VERBOSE_LOG_PRINTF("Finished mark helper %d\n", id);
+  if (0 == GC_helper_count)
+    GC_notify_all_marker();
+}
+
+#  else /* !USE_MARK_DEQUES */
+
+#    ifndef N_LOCAL_ITERS
+#      define N_LOCAL_ITERS 1
+#    endif
+
 /*
  * Note: called only when the local and the main mark stacks are both
  * empty.
@@ -1224,10 +1920,6 @@ GC_do_local_mark(mse *local_mark_stack, mse *local_top)
   }
 }
 
-#  ifndef ENTRIES_TO_GET
-#    define ENTRIES_TO_GET 5
-#  endif
-
 /*
  * Mark using the local mark stack until the global mark stack is empty and
  * there are no active workers.  Update `GC_first_nonempty` to reflect the
@@ -1344,6 +2036,7 @@ GC_mark_local(mse *local_mark_stack, int id)
     GC_do_local_mark(local_mark_stack, local_top);
   }
 }
+#  endif /* !USE_MARK_DEQUES */
 
 /*
  * Perform parallel mark.  We hold the allocator lock, but not the mark lock.
@@ -1360,7 +2053,12 @@ GC_do_parallel_mark(void)
                         (unsigned long)GC_mark_no);
 
   GC_cptr_store(&GC_first_nonempty, (ptr_t)GC_mark_stack);
+#  ifdef USE_MARK_DEQUES
+  reset_mark_deques();
+  GC_ASSERT(0 == GC_idle_count && 0 == GC_sleeping_count);
+#  else
   GC_active_count = 0;
+#  endif
   GC_helper_count = 1;
   GC_help_wanted = TRUE;
   /* Wake up potential helpers. */
@@ -1379,6 +2077,150 @@ GC_do_parallel_mark(void)
   GC_notify_all_marker();
 }
 
+#  ifdef CONCURRENT_MARK
+/*
+ * Set when a marker thread is requested to do the concurrent marking
+ * work; `GC_concurrent_marker_busy` is set while a marker thread does it.
+ * Both are protected by the mark lock.
+ */
+STATIC GC_bool GC_concurrent_mark_wanted = FALSE;
+STATIC GC_bool GC_concurrent_marker_busy = FALSE;
+
+GC_INNER GC_bool GC_mark_in_background = FALSE;
+
+GC_INNER volatile AO_t GC_concurrent_drain_active = FALSE;
+
+/*
+ * Set by a mutator (holding the mark lock) to request the marker thread
+ * to stop the tracing done without the allocator lock.
+ */
+STATIC volatile AO_t GC_concurrent_drain_stop = FALSE;
+
+GC_INNER GC_bool
+GC_concurrent_mark_can_step(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(!AO_load(&GC_concurrent_drain_active));
+  switch (GC_mark_state) {
+  case MS_NONE:
+    return FALSE;
+  case MS_ROOTS_PUSHED:
+    return !GC_mark_stack_empty();
+  default:
+    return TRUE;
+  }
+}
+
+GC_INNER GC_bool
+GC_request_concurrent_mark(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  if (!GC_parallel)
+    return FALSE;
+
+  GC_acquire_mark_lock();
+  if (GC_concurrent_mark_wanted || GC_concurrent_marker_busy) {
+    GC_release_mark_lock();
+    return TRUE;
+  }
+  /* The mark stack is not being drained now. */
+  if (!GC_concurrent_mark_can_step()) {
+    GC_release_mark_lock();
+    return FALSE;
+  }
+  GC_concurrent_mark_wanted = TRUE;
+  GC_release_mark_lock();
+  GC_notify_all_marker();
+  return TRUE;
+}
+
+/*
+ * Invalidate the mark state and request the mark stack growth if the
+ * mark stack overflowed during the tracing done without the allocator
+ * lock.  Called with the allocator lock held after the drain is over.
+ */
+STATIC void
+GC_handle_drain_overflow(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(!AO_load(&GC_concurrent_drain_active));
+  if (!GC_concurrent_drain_overflow)
+    return;
+  GC_concurrent_drain_overflow = FALSE;
+  GC_mark_state = MS_INVALID;
+  /* The global mark stack is used by the drain even if `GC_parallel`. */
+  GC_mark_stack_too_small = TRUE;
+  GC_COND_LOG_PRINTF("Mark stack overflow in background marker;"
+                     " current size: %lu entries\n",
+                     (unsigned long)GC_mark_stack_size);
+}
+
+GC_INNER GC_bool
+GC_drain_mark_stack_unlocked(void)
+{
+  GC_bool stopped;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(!GC_mark_stack_empty());
+  AO_store(&GC_concurrent_drain_active, TRUE);
+  /* The mutators see the flag set once they acquire the allocator lock. */
+  UNLOCK();
+  do {
+    MARK_FROM_MARK_STACK();
+    AO_fetch_and_add1(&GC_concurrent_mark_credit);
+  } while (!GC_mark_stack_empty() && !AO_load(&GC_concurrent_drain_stop)
+           && !GC_concurrent_drain_overflow);
+
+  GC_acquire_mark_lock();
+  AO_store(&GC_concurrent_drain_active, FALSE);
+  stopped = (GC_bool)AO_load(&GC_concurrent_drain_stop);
+  GC_release_mark_lock();
+  if (stopped) {
+    /* Wake up the mutator waiting in `GC_stop_concurrent_drain_inner`. */
+    GC_notify_all_marker();
+    return FALSE;
+  }
+  LOCK();
+  GC_handle_drain_overflow();
+  return TRUE;
+}
+
+GC_INNER void
+GC_stop_concurrent_drain_inner(void)
+{
+  IF_CANCEL(int cancel_state;)
+
+  GC_ASSERT(I_HOLD_LOCK());
+  DISABLE_CANCEL(cancel_state);
+  GC_acquire_mark_lock();
+  if (AO_load(&GC_concurrent_drain_active)) {
+    AO_store(&GC_concurrent_drain_stop, TRUE);
+    do {
+      GC_wait_marker();
+    } while (AO_load(&GC_concurrent_drain_active));
+    AO_store(&GC_concurrent_drain_stop, FALSE);
+  }
+  GC_release_mark_lock();
+  GC_handle_drain_overflow();
+  RESTORE_CANCEL(cancel_state);
+}
+#  endif /* CONCURRENT_MARK */
+
+#  ifdef PARALLEL_STACK_SCAN
+/*
+ * Set when the markers are requested to scan the collected stack
+ * sections; `GC_stack_scanners` is the number of markers doing it.
+ * Both are protected by the mark lock.
+ */
+STATIC GC_bool GC_stack_scan_wanted = FALSE;
+STATIC unsigned GC_stack_scanners = 0;
+
+/* The index of the next collected stack section to scan. */
+STATIC volatile AO_t GC_next_stack_range = 0;
+
+STATIC void GC_scan_some_stack_ranges(mse *local_mark_stack);
+#  endif
+
 GC_INNER void
 GC_help_marker(word my_mark_no)
 {
@@ -1395,6 +2237,34 @@ GC_help_marker(word my_mark_no)
   GC_ASSERT(GC_parallel);
   while (GC_mark_no < my_mark_no
          || (!GC_help_wanted && GC_mark_no == my_mark_no)) {
+#  ifdef CONCURRENT_MARK
+    if (GC_concurrent_mark_wanted) {
+      /* Take the request; the mark lock should not be held meanwhile. */
+      GC_concurrent_mark_wanted = FALSE;
+      GC_concurrent_marker_busy = TRUE;
+      GC_release_mark_lock();
+      GC_concurrent_mark_steps();
+      GC_acquire_mark_lock();
+      GC_concurrent_marker_busy = FALSE;
+      continue;
+    }
+#  endif
+#  ifdef PARALLEL_STACK_SCAN
+    if (GC_stack_scan_wanted
+        && AO_load(&GC_next_stack_range) < GC_n_stack_ranges) {
+      GC_stack_scanners++;
+      GC_release_mark_lock();
+      GC_scan_some_stack_ranges(local_mark_stack);
+      GC_acquire_mark_lock();
+      if (0 == --GC_stack_scanners)
+        GC_notify_all_marker();
+      continue;
+    }
+#  endif
+#  ifdef PARALLEL_SWEEP
+    if (GC_sweep_some_blocks())
+      continue;
+#  endif
     GC_wait_marker();
   }
   my_id = GC_helper_count;
@@ -1471,6 +2341,9 @@ GC_INNER void
 GC_mark_init(void)
 {
   alloc_mark_stack(INITIAL_MARK_STACK_SIZE);
+#ifdef USE_SIMD_PTRS_FILTER
+  GC_init_ptrs_filter();
+#endif
 }
 
 GC_API void GC_CALL
@@ -1686,14 +2559,14 @@ GC_mark_and_push(void *obj, mse *mark_stack_top, mse *mark_stack_limit,
                                  mark_stack_limit, (ptr_t)src, TRUE);
 }
 
+/*
+ * Same as `GC_mark_and_push` but the interior pointers are recognized,
+ * and the invalid ones are added to the stack black list.
+ */
 GC_ATTR_NO_SANITIZE_ADDR
-GC_INNER void
-#if defined(PRINT_BLACK_LIST) || defined(KEEP_BACK_PTRS)
-GC_mark_and_push_stack(ptr_t p, ptr_t source)
-#else
-GC_mark_and_push_stack(ptr_t p)
-#  define source ((ptr_t)NULL)
-#endif
+GC_INLINE mse *
+mark_and_push_stack_inner(ptr_t p, ptr_t source, mse *mark_stack_top,
+                          mse *mark_stack_limit)
 {
   hdr *hhdr;
   ptr_t r = p;
@@ -1704,12 +2577,12 @@ GC_mark_and_push_stack(ptr_t p)
     if (NULL == hhdr || (r = (ptr_t)GC_base(p)) == NULL
         || (hhdr = HDR(r)) == NULL) {
       GC_ADD_TO_BLACK_LIST_STACK(p, source);
-      return;
+      return mark_stack_top;
     }
   }
   if (UNLIKELY(HBLK_IS_FREE(hhdr))) {
     GC_ADD_TO_BLACK_LIST_NORMAL(p, source);
-    return;
+    return mark_stack_top;
   }
 #ifdef THREADS
   /*
@@ -1718,13 +2591,26 @@ GC_mark_and_push_stack(ptr_t p)
    */
   GC_dirty(p); /*< entire object */
 #endif
-  GC_mark_stack_top = GC_ms_push_contents_hdr(
-      r, hhdr, GC_mark_stack_top, GC_mark_stack_limit, source, FALSE);
   /*
    * We silently ignore pointers to near the end of a block, which is
    * very mildly suboptimal.
    */
   /* FIXME: We should probably add a header word to address this. */
+  return GC_ms_push_contents_hdr(r, hhdr, mark_stack_top, mark_stack_limit,
+                                 source, FALSE);
+}
+
+GC_ATTR_NO_SANITIZE_ADDR
+GC_INNER void
+#if defined(PRINT_BLACK_LIST) || defined(KEEP_BACK_PTRS)
+GC_mark_and_push_stack(ptr_t p, ptr_t source)
+#else
+GC_mark_and_push_stack(ptr_t p)
+#  define source ((ptr_t)NULL)
+#endif
+{
+  GC_mark_stack_top = mark_and_push_stack_inner(
+      p, source, GC_mark_stack_top, GC_mark_stack_limit);
 #undef source
 }
 
@@ -1816,6 +2702,29 @@ GC_push_all_eager(void *bottom, void *top)
     if (lim_addr >= cap_limit)
       lim_addr = cap_limit - sizeof(ptr_t);
   }
+#endif
+#ifdef USE_SIMD_PTRS_FILTER
+  {
+    GC_ptrs_filter_proc ptrs_filter = GC_ptrs_filter;
+    word filter_lo1 = ADDR(least_ha) + 1;
+    word filter_span = ADDR_LT(least_ha, greatest_ha)
+                           ? ADDR(greatest_ha) - filter_lo1
+                           : 0;
+
+    for (; ADDR(current_p) + PTRS_TO_BYTES(PTRS_FILTER_CHUNK - 1) <= lim_addr;
+         current_p += PTRS_TO_BYTES(PTRS_FILTER_CHUNK)) {
+      unsigned mask
+          = ptrs_filter((const ptr_t *)current_p, filter_lo1, filter_span);
+
+      while (mask != 0) {
+        ptr_t *pq = (ptr_t *)current_p + __builtin_ctz(mask);
+        REGISTER ptr_t q = *pq;
+
+        mask &= mask - 1;
+        GC_PUSH_ONE_STACK(q, pq);
+      }
+    }
+  }
 #endif
   for (; ADDR(current_p) <= lim_addr; current_p += ALIGNMENT) {
     REGISTER ptr_t q;
@@ -1830,10 +2739,192 @@ GC_push_all_eager(void *bottom, void *top)
 #if !defined(NEED_FIXUP_POINTER) && !defined(NO_ALL_INTERIOR_POINTERS)   \
     && (!defined(STACK_NOT_SCANNED) || defined(IA64) || defined(THREADS) \
         || (defined(EMSCRIPTEN) && defined(EMSCRIPTEN_ASYNCIFY)))
+#  ifdef PARALLEL_STACK_SCAN
+struct stack_range_s {
+  ptr_t lo;
+  ptr_t hi;
+};
+
+#    ifndef STACK_SCAN_CHUNK_SIZE
+/*
+ * The collected stack sections are split into pieces of up to this
+ * size (in bytes), so that a deep stack is scanned by several markers.
+ */
+#      define STACK_SCAN_CHUNK_SIZE (16 * HBLKSIZE)
+#    endif
+
+/*
+ * Set while `GC_push_all_stack` should collect the stack sections.
+ * Protected by the allocator lock.
+ */
+STATIC GC_bool GC_collect_stack_ranges = FALSE;
+
+GC_INNER GC_bool
+GC_begin_parallel_stack_scan(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(!GC_collect_stack_ranges && 0 == GC_n_stack_ranges);
+  /*
+   * The markers are not available if the marking is done by one of
+   * them (in the background).
+   */
+  if (!GC_parallel || GC_parallel_mark_disabled)
+    return FALSE;
+  GC_collect_stack_ranges = TRUE;
+  return TRUE;
+}
+
+/*
+ * Append the given section to `GC_stack_ranges`, growing the latter
+ * if needed.  Returns `FALSE` if out of memory.
+ */
+static GC_bool
+add_stack_range(ptr_t lo, ptr_t hi)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  if (GC_n_stack_ranges == GC_stack_ranges_size) {
+    size_t new_size = GC_stack_ranges_size > 0
+                          ? 2 * GC_stack_ranges_size
+                          : HBLKSIZE / sizeof(struct stack_range_s);
+    struct stack_range_s *new_ranges = (struct stack_range_s *)GC_scratch_alloc(
+        new_size * sizeof(struct stack_range_s));
+
+    if (NULL == new_ranges)
+      return FALSE;
+    if (GC_stack_ranges_size > 0) {
+      BCOPY(GC_stack_ranges, new_ranges,
+            GC_n_stack_ranges * sizeof(struct stack_range_s));
+      GC_scratch_recycle_inner(GC_stack_ranges,
+                               GC_stack_ranges_size
+                                   * sizeof(struct stack_range_s));
+    }
+    GC_stack_ranges = new_ranges;
+    GC_stack_ranges_size = new_size;
+  }
+  GC_stack_ranges[GC_n_stack_ranges].lo = lo;
+  GC_stack_ranges[GC_n_stack_ranges].hi = hi;
+  GC_n_stack_ranges++;
+  return TRUE;
+}
+
+/*
+ * Same as `GC_push_all_eager` but the objects are pushed to the given
+ * local mark stack (which is returned to the global one when it is half
+ * full).  Returns the new top of the local mark stack.
+ */
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static mse *
+push_stack_range_local(ptr_t bottom, ptr_t top, mse *local_mark_stack,
+                       mse *local_top)
+{
+  ptr_t current_p;
+  word lim_addr;
+  ptr_t greatest_ha = (ptr_t)GC_greatest_plausible_heap_addr;
+  ptr_t least_ha = (ptr_t)GC_least_plausible_heap_addr;
+
+  current_p = PTR_ALIGN_UP(bottom, ALIGNMENT);
+  lim_addr = ADDR(PTR_ALIGN_DOWN(top, ALIGNMENT)) - sizeof(ptr_t);
+#    ifdef CHERI_PURECAP
+  {
+    word cap_limit = cheri_base_get(current_p) + cheri_length_get(current_p);
+
+    if (lim_addr >= cap_limit)
+      lim_addr = cap_limit - sizeof(ptr_t);
+  }
+#    endif
+  for (; ADDR(current_p) <= lim_addr; current_p += ALIGNMENT) {
+    ptr_t q;
+
+    LOAD_PTR_OR_CONTINUE(q, current_p);
+    if (ADDR_LT(least_ha, q) && ADDR_LT(q, greatest_ha)) {
+      local_top = mark_and_push_stack_inner(
+          q, current_p, local_top, local_mark_stack + LOCAL_MARK_STACK_SIZE);
+      if ((word)(local_top - local_mark_stack) >= LOCAL_MARK_STACK_SIZE / 2) {
+        GC_return_mark_stack(local_mark_stack, local_top);
+        local_top = local_mark_stack - 1;
+      }
+    }
+  }
+  return local_top;
+}
+
+/*
+ * Scan the collected stack sections not claimed yet by the other
+ * markers.  We do not hold the mark lock.
+ */
+STATIC void
+GC_scan_some_stack_ranges(mse *local_mark_stack)
+{
+  mse *local_top = local_mark_stack - 1;
+
+  for (;;) {
+    size_t i = (size_t)AO_fetch_and_add1(&GC_next_stack_range);
+
+    if (i >= GC_n_stack_ranges)
+      break;
+    local_top = push_stack_range_local(GC_stack_ranges[i].lo,
+                                       GC_stack_ranges[i].hi,
+                                       local_mark_stack, local_top);
+  }
+  GC_return_mark_stack(local_mark_stack, local_top);
+}
+
+GC_INNER void
+GC_end_parallel_stack_scan(void)
+{
+  size_t n_ranges = GC_n_stack_ranges;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(GC_collect_stack_ranges);
+  GC_collect_stack_ranges = FALSE;
+  if (0 == n_ranges)
+    return;
+
+  AO_store(&GC_next_stack_range, 0);
+  GC_acquire_mark_lock();
+  GC_ASSERT(0 == GC_stack_scanners);
+  GC_stack_scan_wanted = TRUE;
+  GC_notify_all_marker();
+  GC_release_mark_lock();
+  GC_scan_some_stack_ranges(GC_main_local_mark_stack);
+
+  /* Wait for the markers which have claimed the remaining sections. */
+  GC_acquire_mark_lock();
+  GC_stack_scan_wanted = FALSE;
+  while (GC_stack_scanners > 0) {
+    GC_wait_marker();
+  }
+  GC_release_mark_lock();
+  GC_VERBOSE_LOG_PRINTF("Scanned %lu stack sections by markers\n",
+                        (unsigned long)n_ranges);
+  GC_n_stack_ranges = 0;
+}
+#  endif /* PARALLEL_STACK_SCAN */
+
 GC_INNER void
 GC_push_all_stack(void *bottom, void *top)
 {
   GC_ASSERT(I_HOLD_LOCK());
+#  ifdef PARALLEL_STACK_SCAN
+  if (GC_collect_stack_ranges) {
+    ptr_t lo = PTR_ALIGN_UP((ptr_t)bottom, ALIGNMENT);
+
+    /* The boundaries of the pieces are aligned, thus no word is lost. */
+    while (ADDR_LT(lo, (ptr_t)top)) {
+      ptr_t hi = ADDR((ptr_t)top) - ADDR(lo) > STACK_SCAN_CHUNK_SIZE
+                     ? lo + STACK_SCAN_CHUNK_SIZE
+                     : (ptr_t)top;
+
+      if (!add_stack_range(lo, hi))
+        break;
+      lo = hi;
+    }
+    if (!ADDR_LT(lo, (ptr_t)top))
+      return;
+    /* Push the rest as usual. */
+    bottom = lo;
+  }
+#  endif
   if (GC_all_interior_pointers
 #  if defined(THREADS) && defined(MPROTECT_VDB)
       /* TODO: Should we avoid `GC_push_all()` if using `userfaultfd`? */
@@ -2169,6 +3260,66 @@ GC_push_unconditionally(struct hblk *h, const hdr *hhdr)
 }
 #endif /* ENABLE_DISCLAIM */
 
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_MANUAL_VDB)
+/*
+ * Same as `GC_push_marked`, but push only the marked objects overlapping
+ * the dirty cards.  For a large object with a length descriptor, only the
+ * dirty cards (clipped to the object) are pushed.
+ */
+STATIC void
+GC_push_marked_dirty_cards(struct hblk *h, const hdr *hhdr)
+{
+  size_t sz = hhdr->hb_sz;
+  word descr = hhdr->hb_descr;
+  ptr_t p;
+  ptr_t plim;
+  size_t bit_no;
+  mse *mark_stack_top;
+  mse *mark_stack_limit = GC_mark_stack_limit;
+
+  if ((/* `0 |` */ GC_DS_LENGTH) == descr)
+    return;
+  if (GC_block_empty(hhdr))
+    return; /*< nothing marked */
+
+  GC_n_rescuing_pages++;
+  GC_objects_are_marked = TRUE;
+  if (sz > MAXOBJBYTES && (descr & GC_DS_TAGS) == GC_DS_LENGTH) {
+    ptr_t lim = h->hb_body + descr;
+
+    for (p = PTR_ALIGN_DOWN(h->hb_body, CARD_BYTES); ADDR_LT(p, lim);) {
+      ptr_t q;
+
+      if (!GC_cards_were_dirty(p, p + 1)) {
+        p += CARD_BYTES;
+        continue;
+      }
+      /* Push the run of the adjacent dirty cards at once. */
+      for (q = p + CARD_BYTES; ADDR_LT(q, lim) && GC_cards_were_dirty(q, q + 1);
+           q += CARD_BYTES) {
+        /* Empty. */
+      }
+      GC_push_all(ADDR_LT(p, h->hb_body) ? h->hb_body : p,
+                  ADDR_LT(q, lim) ? q : lim);
+      p = q;
+    }
+    return;
+  }
+
+  plim = sz > MAXOBJBYTES ? h->hb_body
+                          : CAST_THRU_UINTPTR(ptr_t, (h + 1)->hb_body) - sz;
+  mark_stack_top = GC_mark_stack_top;
+  for (p = h->hb_body, bit_no = 0; ADDR_GE(plim, p);
+       p += sz, bit_no += MARK_BIT_OFFSET(sz)) {
+    if (mark_bit_from_hdr(hhdr, bit_no) && GC_cards_were_dirty(p, p + sz)) {
+      mark_stack_top
+          = GC_ms_push_obj_hdr(p, hhdr, mark_stack_top, mark_stack_limit);
+    }
+  }
+  GC_mark_stack_top = mark_stack_top;
+}
+#endif
+
 #ifndef GC_DISABLE_INCREMENTAL
 /* Test whether any page in the given block is dirty. */
 STATIC GC_bool
@@ -2225,6 +3376,9 @@ STATIC struct hblk *
 GC_push_next_marked_dirty(struct hblk *h)
 {
   const hdr *hhdr;
+#  ifndef NO_MANUAL_VDB
+  GC_bool only_cards_dirty = FALSE;
+#  endif
 
   GC_ASSERT(I_HOLD_LOCK());
   if (!GC_incremental)
@@ -2244,6 +3398,14 @@ GC_push_next_marked_dirty(struct hblk *h)
     }
     if (GC_block_was_dirty(h, hhdr))
       break;
+#  ifndef NO_MANUAL_VDB
+    if (GC_manual_vdb
+        && GC_cards_were_dirty((ptr_t)h,
+                               (ptr_t)(h + OBJ_SZ_TO_BLOCKS(hhdr->hb_sz)))) {
+      only_cards_dirty = TRUE;
+      break;
+    }
+#  endif
   }
 #  ifdef ENABLE_DISCLAIM
   if ((hhdr->hb_flags & MARK_UNCONDITIONALLY) != 0) {
@@ -2260,7 +3422,14 @@ GC_push_next_marked_dirty(struct hblk *h)
   } else
 #  endif
   /* else */ {
-    GC_push_marked(h, hhdr);
+#  ifndef NO_MANUAL_VDB
+    if (only_cards_dirty) {
+      GC_push_marked_dirty_cards(h, hhdr);
+    } else
+#  endif
+    /* else */ {
+      GC_push_marked(h, hhdr);
+    }
   }
   return h + OBJ_SZ_TO_BLOCKS(hhdr->hb_sz);
 }
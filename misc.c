@@ -428,30 +428,44 @@ GC_clear_stack(void *arg)
 
 #endif /* !ALWAYS_SMALL_CLEAR_STACK && !STACK_NOT_SCANNED */
 
-GC_API void *GC_CALL
-GC_base(void *p)
+/*
+ * The core of `GC_base()`.  The headers might be updated concurrently
+ * (unless the allocator lock is held), thus this function should not
+ * crash on the inconsistent values; the result is discarded then.
+ */
+GC_ATTR_NO_SANITIZE_THREAD
+static void *
+base_inner(void *p)
 {
   ptr_t r = (ptr_t)p;
   struct hblk *h;
+#ifndef FLAT_HDR_MAP
   bottom_index *bi;
+#endif
   hdr *hhdr;
   ptr_t limit;
   size_t sz;
 
-  if (UNLIKELY(!GC_is_initialized))
-    return NULL;
   h = HBLKPTR(r);
+#ifdef FLAT_HDR_MAP
+  hhdr = HDR(r);
+#else
   GET_BI(r, bi);
   hhdr = HDR_FROM_BI(bi, r);
+#endif
   if (NULL == hhdr)
     return NULL;
 
   /*
    * If it is a pointer to the middle of a large object, then move it
-   * to the beginning.
+   * to the beginning.  Unlike `GC_find_starting_hblk()`, stop at `NULL`
+   * entry (which might be observed only if the headers are updated).
    */
-  if (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
-    h = GC_find_starting_hblk(h, &hhdr);
+  while (IS_FORWARDING_ADDR_OR_NIL(hhdr)) {
+    h = FORWARDED_ADDR(h, hhdr);
+    hhdr = HDR(h);
+    if (UNLIKELY(NULL == hhdr))
+      return NULL;
     r = (ptr_t)h;
   }
   if (HBLK_IS_FREE(hhdr))
@@ -461,6 +475,8 @@ GC_base(void *p)
   r = PTR_ALIGN_DOWN(r, sizeof(ptr_t));
 
   sz = hhdr->hb_sz;
+  if (UNLIKELY(0 == sz))
+    return NULL;
   r -= HBLKDISPL(r) % sz;
   limit = r + sz;
   if ((ADDR_LT((ptr_t)(h + 1), limit) && sz <= HBLKSIZE)
@@ -470,27 +486,92 @@ GC_base(void *p)
   return r;
 }
 
+GC_API void *GC_CALL
+GC_base(void *p)
+{
+  void *r;
+#ifdef THREADS
+  AO_t seq;
+#endif
+
+  if (UNLIKELY(!GC_is_initialized))
+    return NULL;
+#ifdef THREADS
+  /*
+   * Try without the allocator lock first (nothing is written to the
+   * shared memory), retry holding the lock if the headers have been
+   * updated meanwhile.
+   */
+  seq = HDR_READ_BEGIN();
+  r = base_inner(p);
+  if (LIKELY(HDR_READ_VALID(seq)))
+    return r;
+  READER_LOCK();
+  r = base_inner(p);
+  READER_UNLOCK();
+#else
+  r = base_inner(p);
+#endif
+  return r;
+}
+
 GC_API int GC_CALL
 GC_is_heap_ptr(const void *p)
 {
+  /*
+   * No synchronization is needed: a single entry of the header index
+   * is read, and a heap block never leaves the heap.
+   */
+#ifdef FLAT_HDR_MAP
+  GC_ASSERT(GC_is_initialized);
+  return HDR(p) != NULL;
+#else
   bottom_index *bi;
 
   GC_ASSERT(GC_is_initialized);
   GET_BI(p, bi);
   return HDR_FROM_BI(bi, p) != NULL;
+#endif
+}
+
+/*
+ * The core of `GC_size()`.  Returns 0 if `p` does not point to the first
+ * heap block of an object (or the headers are being updated).
+ */
+GC_ATTR_NO_SANITIZE_THREAD
+static size_t
+size_inner(const void *p)
+{
+  const hdr *hhdr = HDR(p);
+
+  return IS_FORWARDING_ADDR_OR_NIL(hhdr) ? 0 : hhdr->hb_sz;
 }
 
 GC_API size_t GC_CALL
 GC_size(const void *p)
 {
-  const hdr *hhdr;
+  size_t sz;
+#ifdef THREADS
+  AO_t seq;
+#endif
 
   /* Accept `NULL` for compatibility with `malloc_usable_size()`. */
   if (UNLIKELY(NULL == p))
     return 0;
 
-  hhdr = HDR(p);
-  return hhdr->hb_sz;
+#ifdef THREADS
+  /* Same as in `GC_base()`. */
+  seq = HDR_READ_BEGIN();
+  sz = size_inner(p);
+  if (LIKELY(HDR_READ_VALID(seq)))
+    return sz;
+  READER_LOCK();
+  sz = size_inner(p);
+  READER_UNLOCK();
+#else
+  sz = size_inner(p);
+#endif
+  return sz;
 }
 
 /*
@@ -598,6 +679,48 @@ fill_prof_stats(struct GC_prof_stats_s *pstats)
   pstats->reclaimed_bytes_before_gc = GC_reclaimed_bytes_before_gc;
   pstats->expl_freed_bytes_since_gc = GC_bytes_freed; /*< since gc-7.7 */
   pstats->obtained_from_os_bytes = GC_our_mem_bytes;  /*< since gc-8.2 */
+  pstats->fl_refill_count = GC_fl_refill_count;       /*< since gc-8.3 */
+  pstats->fl_refill_bytes = GC_fl_refill_bytes;
+#  ifdef USE_FUTEX_LOCK
+  pstats->lock_acquisitions = GC_lock_acquisitions;
+  pstats->lock_contended_count = GC_lock_contended_count;
+  pstats->lock_wait_ns = GC_lock_wait_ns;
+#    ifdef LOCK_STATS
+  pstats->lock_max_hold_ns = GC_lock_max_hold_ns;
+#    else
+  pstats->lock_max_hold_ns = ~(word)0;
+#    endif
+#  else
+  pstats->lock_acquisitions = ~(word)0;
+  pstats->lock_contended_count = ~(word)0;
+  pstats->lock_wait_ns = ~(word)0;
+  pstats->lock_max_hold_ns = ~(word)0;
+#  endif
+#  if defined(THREADS) && !defined(NO_CLOCK)
+  pstats->world_stop_ns = GC_world_stop_total_ns;
+  pstats->world_stop_max_ns = GC_world_stop_max_ns;
+#  else
+  pstats->world_stop_ns = ~(word)0;
+  pstats->world_stop_max_ns = ~(word)0;
+#  endif
+#  ifdef THREADS
+  pstats->stack_scanned_bytes = GC_total_stacksize - GC_stack_skipped_bytes;
+  pstats->stack_skipped_bytes = GC_stack_skipped_bytes;
+#  else
+  pstats->stack_scanned_bytes = ~(word)0;
+  pstats->stack_skipped_bytes = ~(word)0;
+#  endif
+#  ifndef GC_DISABLE_INCREMENTAL
+  pstats->minor_gc_no = GC_minor_gc_no;
+  pstats->nursery_bytes = GC_nursery_bytes;
+  pstats->nursery_survived_bytes = GC_nursery_survived_bytes;
+  pstats->promoted_bytes = GC_promoted_bytes;
+#  else
+  pstats->minor_gc_no = 0;
+  pstats->nursery_bytes = ~(word)0;
+  pstats->nursery_survived_bytes = ~(word)0;
+  pstats->promoted_bytes = ~(word)0;
+#  endif
 }
 
 #  include <string.h> /*< for `memset()` */
@@ -675,6 +798,14 @@ GC_get_thr_restart_signal(void)
 }
 #endif /* THREADS && !SIGNAL_BASED_STOP_WORLD */
 
+#if defined(THREADS) && !defined(SAFEPOINT_STOP_WORLD)
+GC_API void GC_CALL
+GC_safepoint(void)
+{
+  /* Threads are stopped by the collector without their cooperation. */
+}
+#endif
+
 #if !defined(_MAX_PATH) && defined(ANY_MSWIN)
 #  define _MAX_PATH MAX_PATH
 #endif
@@ -1292,6 +1423,50 @@ GC_init(void)
       }
     }
   }
+  {
+    const char *str = GETENV("GC_MUTATOR_UTILIZATION");
+
+    if (str != NULL) {
+      int percent = atoi(str);
+
+      if (percent > 0 && percent < 100)
+        GC_set_mutator_utilization(percent);
+    }
+  }
+#endif
+#ifdef CONCURRENT_MARK
+  if (GETENV("GC_CONCURRENT_MARK") != NULL) {
+    GC_concurrent_mark = TRUE;
+  }
+#endif
+#ifdef BACKGROUND_SWEEP
+  if (GETENV("GC_BACKGROUND_SWEEP") != NULL) {
+    GC_background_sweep = TRUE;
+  }
+#endif
+#ifdef HUGE_PAGES_SUPPORTED
+  if (GETENV("GC_HUGE_PAGES") != NULL) {
+    GC_huge_pages = TRUE;
+  }
+  if (GC_huge_pages && GC_page_size >= HUGE_PAGE_SIZE) {
+    /* Nothing to do, the base page is not smaller than a huge one. */
+    GC_huge_pages = FALSE;
+  }
+#endif
+#ifdef FLAT_HDR_MAP
+  {
+    const char *str = GETENV("GC_HEAP_RESERVE_SIZE");
+
+    if (str != NULL) {
+      word value = GC_parse_mem_size_arg(str);
+
+      if (GC_WORD_MAX == value || 0 == value) {
+        WARN("Bad heap reserve size %s - ignoring\n", str);
+      } else {
+        GC_heap_reserve_size = (size_t)value;
+      }
+    }
+  }
 #endif
 #ifndef SMALL_CONFIG
   {
@@ -1348,6 +1523,28 @@ GC_init(void)
       }
     }
   }
+  {
+    const char *str = GETENV("GC_UNMAP_POLICY");
+
+    if (str != NULL) {
+      if (strcmp(str, "dontneed") == 0) {
+        GC_unmap_policy = GC_UNMAP_POLICY_DONTNEED;
+      } else if (strcmp(str, "free") == 0) {
+        GC_unmap_policy = GC_UNMAP_POLICY_FREE;
+      } else if (strcmp(str, "prot_none") == 0) {
+        GC_unmap_policy = GC_UNMAP_POLICY_PROT_NONE;
+      } else {
+        WARN("GC_UNMAP_POLICY environment variable has bad value"
+             " - ignoring\n",
+             0);
+      }
+    }
+  }
+#  ifdef ASYNC_UNMAP
+  if (GETENV("GC_ASYNC_UNMAP") != NULL) {
+    GC_async_unmap = TRUE;
+  }
+#  endif
   {
     const char *str = GETENV("GC_FORCE_UNMAP_ON_GCOLLECT");
 
@@ -1385,6 +1582,11 @@ GC_init(void)
 #endif
   GC_exclude_static_roots_inner(beginGC_arrays, endGC_arrays);
   GC_exclude_static_roots_inner(beginGC_obj_kinds, endGC_obj_kinds);
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_MANUAL_VDB)
+  GC_exclude_static_roots_inner(
+      PTR_ALIGN_UP((ptr_t)GC_card_table, ALIGNMENT),
+      PTR_ALIGN_DOWN((ptr_t)GC_card_table + sizeof(GC_card_table), ALIGNMENT));
+#endif
 #if defined(USE_PROC_FOR_LIBRARIES) && defined(LINUX) && defined(THREADS)
   /*
    * TODO: `USE_PROC_FOR_LIBRARIES` with LinuxThreads performs poorly!
@@ -1449,6 +1651,11 @@ GC_init(void)
     GC_init_linux_data_start();
 #endif
 #ifndef GC_DISABLE_INCREMENTAL
+  if (GETENV("GC_ENABLE_GENERATIONAL") != NULL) {
+    /* Indicate the intention to turn it on without incremental marking. */
+    GC_time_limit = GC_TIME_UNLIMITED;
+    GC_incremental = TRUE;
+  }
   if (GC_incremental || GETENV("GC_ENABLE_INCREMENTAL") != NULL) {
     set_incremental_mode_on();
     GC_ASSERT(0 == GC_bytes_allocd);
@@ -1564,6 +1771,18 @@ GC_init(void)
    * any threads are created.
    */
   GC_init_dyld();
+#endif
+#ifdef CONCURRENT_MARK
+  if (GC_concurrent_mark) {
+    /* The marker thread acquires the allocator lock. */
+    set_need_to_lock();
+  }
+#endif
+#ifdef BACKGROUND_SWEEP
+  if (GC_background_sweep) {
+    /* The sweeper thread acquires the allocator lock. */
+    set_need_to_lock();
+  }
 #endif
   RESTORE_CANCEL(cancel_state);
   /*
@@ -1631,6 +1850,17 @@ GC_enable_incremental(void)
   GC_init();
 }
 
+GC_API void GC_CALL
+GC_enable_generational(void)
+{
+#ifndef GC_DISABLE_INCREMENTAL
+  LOCK();
+  GC_time_limit = GC_TIME_UNLIMITED;
+  UNLOCK();
+#endif
+  GC_enable_incremental();
+}
+
 GC_API void GC_CALL
 GC_start_mark_threads(void)
 {
@@ -3053,6 +3283,77 @@ GC_get_force_unmap_on_gcollect(void)
   return (int)GC_force_unmap_on_gcollect;
 }
 
+GC_API void GC_CALL
+GC_set_unmap_policy(int value)
+{
+  GC_ASSERT(!GC_is_initialized);
+#ifdef USE_MUNMAP
+  /* Ignore an unknown policy (like the environment variable does). */
+  if (value >= GC_UNMAP_POLICY_DONTNEED && value <= GC_UNMAP_POLICY_PROT_NONE)
+    GC_unmap_policy = value;
+#else
+  UNUSED_ARG(value);
+#endif
+}
+
+GC_API int GC_CALL
+GC_get_unmap_policy(void)
+{
+#ifdef USE_MUNMAP
+  return GC_unmap_policy;
+#else
+  return GC_UNMAP_POLICY_DONTNEED;
+#endif
+}
+
+GC_API void GC_CALL
+GC_set_huge_pages(int value)
+{
+  GC_ASSERT(!GC_is_initialized);
+#ifdef HUGE_PAGES_SUPPORTED
+  GC_huge_pages = value != 0;
+#else
+  UNUSED_ARG(value);
+#endif
+}
+
+GC_API int GC_CALL
+GC_get_huge_pages(void)
+{
+#ifdef HUGE_PAGES_SUPPORTED
+  return (int)GC_huge_pages;
+#else
+  return 0;
+#endif
+}
+
+GC_API void GC_CALL
+GC_set_async_unmap(int value)
+{
+#ifdef ASYNC_UNMAP
+  LOCK();
+  GC_async_unmap = value != 0;
+  UNLOCK();
+#else
+  UNUSED_ARG(value);
+#endif
+}
+
+GC_API int GC_CALL
+GC_get_async_unmap(void)
+{
+#ifdef ASYNC_UNMAP
+  int value;
+
+  READER_LOCK();
+  value = (int)GC_async_unmap;
+  READER_UNLOCK();
+  return value;
+#else
+  return 0;
+#endif
+}
+
 GC_API GC_OOM_ABORT_THROW_ATTRIBUTE void GC_CALL
 GC_abort_on_oom(void)
 {
@@ -161,6 +161,57 @@ GC_build_fl(struct hblk *h, ptr_t list, size_t lg, GC_bool clear)
   return (ptr_t)p;
 }
 
+#ifdef BUMP_ALLOC
+GC_INNER ptr_t
+GC_bump_alloc_inner(size_t lg, int kind)
+{
+  struct bump_region *r = &GC_bump_regions[kind][lg];
+  ptr_t op = r->cur;
+  size_t lb_adjusted = GRANULES_TO_BYTES(lg);
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(kind <= NORMAL && lg <= MAXOBJGRANULES);
+  if (UNLIKELY(0 == lg) || ADDR(op) + lb_adjusted > ADDR(r->limit))
+    return NULL;
+
+  r->cur = op + lb_adjusted;
+  if (GC_obj_kinds[kind].ok_init)
+    BZERO(op, lb_adjusted);
+  return op;
+}
+
+GC_INNER void
+GC_release_bump_regions(void)
+{
+  int kind;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  for (kind = 0; kind <= NORMAL; kind++) {
+    size_t lg;
+
+    for (lg = 1; lg <= MAXOBJGRANULES; lg++) {
+      struct bump_region *r = &GC_bump_regions[kind][lg];
+      void **flh = &GC_obj_kinds[kind].ok_freelist[lg];
+      ptr_t p;
+
+      if (NULL == r->cur)
+        continue;
+
+      /*
+       * The objects are not cleared here as the collector is about
+       * to clear the free lists anyway.
+       */
+      for (p = r->cur; ADDR_LT(p, r->limit); p += GRANULES_TO_BYTES(lg)) {
+        obj_link(p) = *flh;
+        *flh = p;
+      }
+      r->cur = NULL;
+      r->limit = NULL;
+    }
+  }
+}
+#endif /* BUMP_ALLOC */
+
 GC_INNER void
 GC_new_hblk(size_t lg, int kind)
 {
@@ -169,6 +220,29 @@ GC_new_hblk(size_t lg, int kind)
 
   GC_STATIC_ASSERT(sizeof(struct hblk) == HBLKSIZE);
   GC_ASSERT(I_HOLD_LOCK());
+#ifdef BUMP_ALLOC
+  if (kind <= NORMAL && !GC_debugging_started) {
+    struct bump_region *r = &GC_bump_regions[kind][lg];
+    ptr_t op = GC_bump_alloc_inner(lg, kind);
+
+    if (NULL == op) {
+      h = GC_allochblk(lb_adjusted, kind, 0 /* `flags` */, 0 /* `align_m1` */);
+      if (UNLIKELY(NULL == h))
+        return; /*< out of memory */
+
+      /* The rest of the block is handed out by `GC_bump_alloc_inner`. */
+      r->cur = h->hb_body + lb_adjusted;
+      r->limit = h->hb_body + HBLKSIZE - HBLKSIZE % lb_adjusted;
+      op = h->hb_body;
+      if (GC_obj_kinds[kind].ok_init)
+        BZERO(op, lb_adjusted);
+    }
+    obj_link(op) = GC_obj_kinds[kind].ok_freelist[lg];
+    GC_obj_kinds[kind].ok_freelist[lg] = op;
+    return;
+  }
+#endif
+
   /* Allocate a new heap block. */
   h = GC_allochblk(lb_adjusted, kind, 0 /* `flags` */, 0 /* `align_m1` */);
   if (UNLIKELY(NULL == h))
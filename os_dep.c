@@ -77,6 +77,10 @@ STATIC GC_bool GC_pages_executable = TRUE;
 /* Note: it is undefined later on `GC_pages_executable` real use. */
 #define IGNORE_PAGES_EXECUTABLE 1
 
+#ifdef HUGE_PAGES_SUPPORTED
+GC_INNER GC_bool GC_huge_pages = FALSE;
+#endif
+
 /*
  * A runtime flag indicating that `mprotect`-based VDB should be avoided.
  * Zero-initialized.
@@ -2458,7 +2462,7 @@ static int zero_fd = -1;
 #      define OPT_MAP_ANON 0
 #    endif
 
-#    ifndef MSWIN_XBOX1
+#    if !defined(MSWIN_XBOX1) && !defined(FLAT_HDR_MAP)
 #      if defined(SYMBIAN) && !defined(USE_MMAP_ANON)
 EXTERN_C_BEGIN
 extern char *GC_get_private_path_and_zero_file(void);
@@ -2534,16 +2538,224 @@ GC_unix_mmap_get_mem(size_t bytes)
   GC_ASSERT((last_addr & (GC_page_size - 1)) == 0);
   return result;
 }
-#    endif /* !MSWIN_XBOX1 */
+
+#      ifdef HUGE_PAGES_SUPPORTED
+/*
+ * Same as `GC_unix_mmap_get_mem` but the result is aligned to
+ * `HUGE_PAGE_SIZE` and the kernel is advised to back the mapping by
+ * transparent huge pages.  `bytes` should be a multiple of `HUGE_PAGE_SIZE`.
+ * The alignment is achieved by mapping an extra space and unmapping
+ * the unaligned head and tail of the region.
+ */
+STATIC void *
+GC_unix_mmap_get_huge_mem(size_t bytes)
+{
+  ptr_t result, aligned;
+  size_t slop = HUGE_PAGE_SIZE - GC_page_size;
+
+  GC_ASSERT((bytes & (HUGE_PAGE_SIZE - 1)) == 0);
+  if (UNLIKELY(bytes > GC_SIZE_MAX - slop))
+    return NULL;
+  result = (ptr_t)GC_unix_mmap_get_mem(bytes + slop);
+  if (UNLIKELY(NULL == result))
+    return NULL;
+  aligned = PTR_ALIGN_UP(result, HUGE_PAGE_SIZE);
+  if (aligned != result)
+    (void)munmap(result, (size_t)(aligned - result));
+  if (aligned + bytes != result + bytes + slop)
+    (void)munmap(aligned + bytes, (size_t)(result + slop - aligned));
+#        ifdef MADV_HUGEPAGE
+  if (madvise(aligned, bytes, MADV_HUGEPAGE) == -1) {
+    /* Probably, the transparent huge pages are disabled in the kernel. */
+    GC_COND_LOG_PRINTF("madvise(MADV_HUGEPAGE) failed, errno= %d\n", errno);
+  }
+#        endif
+  return aligned;
+}
+#      endif
+#    endif /* !MSWIN_XBOX1 && !FLAT_HDR_MAP */
 
 #  endif /* MMAP_SUPPORTED */
 
+#  ifdef FLAT_HDR_MAP
+#    ifndef MAP_NORESERVE
+#      define MAP_NORESERVE 0
+#    endif
+
+#    ifndef MIN_HEAP_RESERVE_SIZE
+/*
+ * The reservation size is halved on failure until it becomes less than
+ * this value.
+ */
+#      define MIN_HEAP_RESERVE_SIZE ((size_t)1 << 30) /*< 1 GiB */
+#    endif
+
+GC_INNER size_t GC_heap_reserve_size = GC_HEAP_RESERVE_SIZE;
+
+/*
+ * The number of bytes at the beginning of `GC_flat_hdrs` which are
+ * accessible (the rest of the header map is reserved only).
+ */
+static size_t flat_hdrs_committed;
+
+/*
+ * Reserve an inaccessible address space range of `bytes` size aligned
+ * to `align` (a power of two not less than the page size).  Returns
+ * `NULL` on failure.
+ */
+static ptr_t
+reserve_addr_range(size_t bytes, size_t align)
+{
+  ptr_t result, aligned;
+  size_t slop = align - GC_page_size;
+
+  if (UNLIKELY(bytes > GC_SIZE_MAX - slop))
+    return NULL;
+  result = (ptr_t)mmap(NULL, bytes + slop, PROT_NONE,
+                       MAP_PRIVATE | MAP_NORESERVE | OPT_MAP_ANON, zero_fd,
+                       0 /* `offset` */);
+  if (UNLIKELY(MAP_FAILED == (void *)result))
+    return NULL;
+  aligned = PTR_ALIGN_UP(result, align);
+  if (aligned != result)
+    (void)munmap(result, (size_t)(aligned - result));
+  if (aligned + bytes != result + bytes + slop)
+    (void)munmap(aligned + bytes, (size_t)(result + slop - aligned));
+  return aligned;
+}
+
+GC_INNER void
+GC_init_heap_reserve(void)
+{
+  size_t align, bytes;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  if (GC_flat_hdrs != NULL)
+    return;
+
+  GC_ASSERT(GC_page_size != 0);
+  align = GC_page_size > HBLKSIZE ? GC_page_size : HBLKSIZE;
+#    ifdef HUGE_PAGES_SUPPORTED
+  if (align < HUGE_PAGE_SIZE)
+    align = HUGE_PAGE_SIZE;
+#    endif
+  for (bytes = GC_heap_reserve_size & ~(align - 1);;
+       bytes = (bytes >> 1) & ~(align - 1)) {
+    ptr_t heap, hdrs;
+    size_t hdrs_bytes;
+
+    if (bytes < MIN_HEAP_RESERVE_SIZE)
+      ABORT("Cannot reserve address space for heap");
+    hdrs_bytes = ROUNDUP_PAGESIZE((bytes >> LOG_HBLKSIZE) * sizeof(hdr *));
+    heap = reserve_addr_range(bytes, align);
+    if (heap != NULL) {
+      hdrs = reserve_addr_range(hdrs_bytes, GC_page_size);
+      if (LIKELY(hdrs != NULL)) {
+        GC_heap_reserve_addr = ADDR(heap);
+        GC_heap_reserve_size = bytes;
+        GC_flat_hdrs = (hdr **)hdrs;
+        GC_COND_LOG_PRINTF("Reserved %lu MiB of address space at %p\n",
+                           (unsigned long)(bytes >> 20), (void *)heap);
+        return;
+      }
+      (void)munmap(heap, bytes);
+    }
+    WARN("Failed to reserve %" WARN_PRIuPTR " MiB of address space"
+         " for heap - trying to reserve less\n",
+         bytes >> 20);
+  }
+}
+
+/*
+ * Make the part of the header map covering the first `used` bytes of
+ * the reserved range accessible.  Returns `FALSE` on failure.
+ */
+static GC_bool
+commit_flat_hdrs(word used)
+{
+  size_t need = ROUNDUP_PAGESIZE((size_t)(used >> LOG_HBLKSIZE)
+                                 * sizeof(hdr *));
+
+  if (need <= flat_hdrs_committed)
+    return TRUE;
+  if (mprotect((ptr_t)GC_flat_hdrs + flat_hdrs_committed,
+               need - flat_hdrs_committed, PROT_READ | PROT_WRITE)
+      == -1)
+    return FALSE;
+  flat_hdrs_committed = need;
+  return TRUE;
+}
+
+/*
+ * Carve `bytes` of memory from the reserved range.  The result is
+ * aligned to `HUGE_PAGE_SIZE` (and advised to be backed by huge pages)
+ * if the huge pages mode is on and `bytes` is a multiple of the huge
+ * page size.  Returns `NULL` if the reserved range is exhausted.
+ */
+STATIC void *
+GC_flat_get_mem(size_t bytes)
+{
+  size_t align;
+  word start;
+  ptr_t result;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_init_heap_reserve();
+  if (bytes & (GC_page_size - 1))
+    ABORT("Bad GET_MEM arg");
+  align = GC_page_size > HBLKSIZE ? GC_page_size : HBLKSIZE;
+#    ifdef HUGE_PAGES_SUPPORTED
+  if (GC_huge_pages && (bytes & (HUGE_PAGE_SIZE - 1)) == 0)
+    align = HUGE_PAGE_SIZE;
+#    endif
+  start = (GC_heap_reserve_used + align - 1) & ~(word)(align - 1);
+  if (UNLIKELY(start > GC_heap_reserve_size
+               || bytes > GC_heap_reserve_size - start))
+    return NULL;
+
+  result = MAKE_CPTR(GC_heap_reserve_addr + start);
+  if (mprotect(result, bytes,
+               (PROT_READ | PROT_WRITE)
+                   | (GC_pages_executable ? PROT_EXEC : 0))
+      == -1) {
+    if (GC_pages_executable && (EACCES == errno || EPERM == errno))
+      ABORT("Cannot allocate executable pages");
+    return NULL;
+  }
+#    ifdef HUGE_PAGES_SUPPORTED
+  if (HUGE_PAGE_SIZE == align) {
+#      ifdef MADV_HUGEPAGE
+    if (madvise(result, bytes, MADV_HUGEPAGE) == -1) {
+      GC_COND_LOG_PRINTF("madvise(MADV_HUGEPAGE) failed, errno= %d\n",
+                         errno);
+    }
+#      endif
+  }
+#    endif
+  if (UNLIKELY(!commit_flat_hdrs(start + bytes))) {
+    (void)mprotect(result, bytes, PROT_NONE);
+    return NULL;
+  }
+  /* Publish the new range only once its headers are accessible. */
+  GC_heap_reserve_used = start + bytes;
+  return result;
+}
+#  endif /* FLAT_HDR_MAP */
+
 #  if defined(USE_MMAP)
 
 GC_INNER void *
 GC_unix_get_mem(size_t bytes)
 {
+#    ifdef FLAT_HDR_MAP
+  return GC_flat_get_mem(bytes);
+#    else
+#      ifdef HUGE_PAGES_SUPPORTED
+  if (GC_huge_pages && (bytes & (HUGE_PAGE_SIZE - 1)) == 0)
+    return GC_unix_mmap_get_huge_mem(bytes);
+#      endif
   return GC_unix_mmap_get_mem(bytes);
+#    endif
 }
 
 #  else /* !USE_MMAP */
@@ -2868,6 +3080,12 @@ GC_win32_free_heap(void)
 #    include <sys/stat.h>
 #  endif
 
+GC_INNER int GC_unmap_policy = GC_UNMAP_POLICY_DONTNEED;
+
+#  ifdef ASYNC_UNMAP
+GC_INNER GC_bool GC_async_unmap = FALSE;
+#  endif
+
 /*
  * Compute a page-aligned starting address for the memory unmap
  * operation on a block of size `bytes` starting at `start`.
@@ -2879,6 +3097,18 @@ GC_unmap_start(ptr_t start, size_t bytes)
   ptr_t result;
 
   GC_ASSERT(GC_page_size != 0);
+#  ifdef HUGE_PAGES_SUPPORTED
+  if (GC_huge_pages) {
+    /*
+     * Do not split huge pages: unmapping a part of a huge page makes
+     * the kernel break it up into base pages.
+     */
+    result = PTR_ALIGN_UP(start, HUGE_PAGE_SIZE);
+    if (ADDR_LT(start + bytes, result + HUGE_PAGE_SIZE))
+      return NULL;
+    return result;
+  }
+#  endif
   result = PTR_ALIGN_UP(start, GC_page_size);
   if (ADDR_LT(start + bytes, result + GC_page_size))
     return NULL;
@@ -2892,6 +3122,87 @@ GC_unmap_start(ptr_t start, size_t bytes)
  * the endpoints in both places.
  */
 
+#  ifndef USE_WINALLOC
+#    ifdef ASYNC_UNMAP
+GC_INNER
+#    else
+STATIC
+#    endif
+void
+GC_unmap_pages(ptr_t start_addr, size_t len)
+{
+#    ifdef SN_TARGET_PS3
+  ps3_free_mem(start_addr, len);
+#    elif defined(AIX) || defined(COSMO) || defined(CYGWIN) || defined(HPUX) \
+        || (defined(LINUX) && !defined(PREFER_MMAP_PROT_NONE))
+  /*
+   * On AIX, `mmap(PROT_NONE)` fails with `ENOMEM` unless the
+   * environment variable `XPG_SUS_ENV` is set to `ON`.
+   * On Cygwin, calling `mmap()` with the new protection flags on
+   * an existing memory map with `MAP_FIXED` is broken.
+   * However, calling `mprotect()` on the given address range
+   * with `PROT_NONE` seems to work fine.  On Linux, low `RLIMIT_AS`
+   * value may lead to `mmap()` failure.
+   */
+#      if (defined(COSMO) || defined(LINUX)) \
+          && !defined(FORCE_MPROTECT_BEFORE_MADVISE)
+  /* On Linux, at least, `madvise()` should be sufficient. */
+#        ifdef LINUX
+  if (GC_unmap_policy == GC_UNMAP_POLICY_PROT_NONE) {
+    /*
+     * Unlike remapping of the range by `mmap()`, this keeps the mapping
+     * attributes (e.g. the `userfaultfd` registration, the huge pages
+     * advice) intact.
+     */
+    if (mprotect(start_addr, len, PROT_NONE))
+      ABORT_ON_REMAP_FAIL("unmap: mprotect", start_addr, len);
+  }
+#        endif
+#      else
+  if (mprotect(start_addr, len, PROT_NONE))
+    ABORT_ON_REMAP_FAIL("unmap: mprotect", start_addr, len);
+#      endif
+#      if !defined(CYGWIN)
+  {
+    int advice = MADV_DONTNEED;
+
+#        if defined(LINUX) && defined(MADV_FREE)
+    /*
+     * The pages are reclaimed by the kernel lazily (only under memory
+     * pressure), so reusing them soon is cheaper.
+     */
+    if (GC_unmap_policy == GC_UNMAP_POLICY_FREE)
+      advice = MADV_FREE;
+#        endif
+    /*
+     * On Linux (and some other platforms probably), `mprotect(PROT_NONE)`
+     * is just disabling access to the pages but not returning them to OS.
+     */
+    if (madvise(start_addr, len, advice) == -1)
+      ABORT_ON_REMAP_FAIL("unmap: madvise", start_addr, len);
+  }
+#      endif
+#    else
+  /*
+   * We immediately remap it to prevent an intervening `mmap()` from
+   * accidentally grabbing the same address space.
+   */
+  void *result = mmap(start_addr, len, PROT_NONE,
+                      MAP_PRIVATE | MAP_FIXED | OPT_MAP_ANON, zero_fd,
+                      0 /* `offset` */);
+
+  if (UNLIKELY(MAP_FAILED == result))
+    ABORT_ON_REMAP_FAIL("unmap: mmap", start_addr, len);
+  if (result != start_addr)
+    ABORT("unmap: mmap() result differs from start_addr");
+#      if defined(CPPCHECK) || defined(LINT2)
+  /* Explicitly store the resource handle to a global variable. */
+  GC_noop1_ptr(result);
+#      endif
+#    endif
+}
+#  endif /* !USE_WINALLOC */
+
 static void
 block_unmap_inner(ptr_t start_addr, size_t len)
 {
@@ -2931,52 +3242,16 @@ block_unmap_inner(ptr_t start_addr, size_t len)
   }
 #  else
   if (len != 0) {
-#    ifdef SN_TARGET_PS3
-    ps3_free_mem(start_addr, len);
-#    elif defined(AIX) || defined(COSMO) || defined(CYGWIN) || defined(HPUX) \
-        || (defined(LINUX) && !defined(PREFER_MMAP_PROT_NONE))
-    /*
-     * On AIX, `mmap(PROT_NONE)` fails with `ENOMEM` unless the
-     * environment variable `XPG_SUS_ENV` is set to `ON`.
-     * On Cygwin, calling `mmap()` with the new protection flags on
-     * an existing memory map with `MAP_FIXED` is broken.
-     * However, calling `mprotect()` on the given address range
-     * with `PROT_NONE` seems to work fine.  On Linux, low `RLIMIT_AS`
-     * value may lead to `mmap()` failure.
-     */
-#      if (defined(COSMO) || defined(LINUX)) \
-          && !defined(FORCE_MPROTECT_BEFORE_MADVISE)
-    /* On Linux, at least, `madvise()` should be sufficient. */
-#      else
-    if (mprotect(start_addr, len, PROT_NONE))
-      ABORT_ON_REMAP_FAIL("unmap: mprotect", start_addr, len);
-#      endif
-#      if !defined(CYGWIN)
-    /*
-     * On Linux (and some other platforms probably), `mprotect(PROT_NONE)`
-     * is just disabling access to the pages but not returning them to OS.
-     */
-    if (madvise(start_addr, len, MADV_DONTNEED) == -1)
-      ABORT_ON_REMAP_FAIL("unmap: madvise", start_addr, len);
-#      endif
-#    else
+#    ifdef ASYNC_UNMAP
     /*
-     * We immediately remap it to prevent an intervening `mmap()` from
-     * accidentally grabbing the same address space.
+     * The range is accounted as unmapped right away even if the actual
+     * unmapping is done later by the unmapper thread.
      */
-    void *result = mmap(start_addr, len, PROT_NONE,
-                        MAP_PRIVATE | MAP_FIXED | OPT_MAP_ANON, zero_fd,
-                        0 /* `offset` */);
-
-    if (UNLIKELY(MAP_FAILED == result))
-      ABORT_ON_REMAP_FAIL("unmap: mmap", start_addr, len);
-    if (result != start_addr)
-      ABORT("unmap: mmap() result differs from start_addr");
-#      if defined(CPPCHECK) || defined(LINT2)
-    /* Explicitly store the resource handle to a global variable. */
-    GC_noop1_ptr(result);
-#      endif
+    if (!GC_async_unmap || !GC_enqueue_unmap(start_addr, len))
 #    endif
+    /* else */ {
+      GC_unmap_pages(start_addr, len);
+    }
     GC_unmapped_bytes += len;
   }
 #  endif
@@ -2986,6 +3261,10 @@ block_unmap_inner(ptr_t start_addr, size_t len)
 GC_INLINE ptr_t
 GC_unmap_end(ptr_t start, size_t bytes)
 {
+#  ifdef HUGE_PAGES_SUPPORTED
+  if (GC_huge_pages)
+    return PTR_ALIGN_DOWN(start + bytes, HUGE_PAGE_SIZE);
+#  endif
   return (ptr_t)HBLK_PAGE_ALIGNED(start + bytes);
 }
 
@@ -3007,6 +3286,10 @@ GC_remap(ptr_t start, size_t bytes)
   if (NULL == start_addr) {
     return;
   }
+#  ifdef ASYNC_UNMAP
+  /* The range (or its part) might be still waiting to be unmapped. */
+  GC_cancel_unmap(start_addr, (size_t)len);
+#  endif
 
   /* FIXME: Handle out-of-memory correctly (at least for Win32). */
 #  ifdef USE_WINALLOC
@@ -3045,7 +3328,15 @@ GC_remap(ptr_t start, size_t bytes)
 #    if !defined(SN_TARGET_PS3) && !defined(FORCE_MPROTECT_BEFORE_MADVISE) \
         && (defined(LINUX) && !defined(PREFER_MMAP_PROT_NONE)              \
             || defined(COSMO))
-    /* Nothing to unprotect as `madvise()` is just a hint. */
+#      ifdef LINUX
+    if (GC_unmap_policy == GC_UNMAP_POLICY_PROT_NONE) {
+      if (mprotect(start_addr, len,
+                   (PROT_READ | PROT_WRITE)
+                       | (GC_pages_executable ? PROT_EXEC : 0)))
+        ABORT_ON_REMAP_FAIL("remap: mprotect", start_addr, len);
+    }
+#      endif
+    /* Otherwise, nothing to unprotect as `madvise()` is just a hint. */
 #    elif defined(COSMO) || defined(NACL) || defined(NETBSD)
     /*
      * NaCl does not expose `mprotect`, but `mmap` should work fine.
@@ -4215,6 +4506,65 @@ GC_proc_read_dirty(GC_bool output_unneeded)
 
 #endif /* PROC_VDB */
 
+#if defined(UFFDWP_VDB) && !defined(NO_UFFDWP_ASYNC)
+/*
+ * Use the asynchronous write-protect mode (where the kernel resolves
+ * the write faults itself) if supported by the kernel (Linux 6.7+).
+ */
+#  define UFFDWP_ASYNC
+#endif
+
+#if defined(SOFT_VDB) && !defined(CHECK_SOFT_VDB) \
+    && !defined(NO_SOFT_PAGEMAP_SCAN)
+/*
+ * Retrieve only the soft-dirty pages ranges by `PAGEMAP_SCAN` requests
+ * (instead of reading the `pagemap` entries of all the pages) if
+ * supported by the kernel (Linux 6.7+).
+ */
+#  define SOFT_PAGEMAP_SCAN
+#endif
+
+#if defined(UFFDWP_ASYNC) || defined(SOFT_PAGEMAP_SCAN)
+#  include <linux/fs.h>
+#  include <sys/ioctl.h>
+
+/* The following might be missing in the kernel headers. */
+#  ifndef PAGEMAP_SCAN
+#    define PAGE_IS_WRITTEN (1 << 1)
+#    define PAGE_IS_SOFT_DIRTY (1 << 7)
+#    define PM_SCAN_WP_MATCHING (1 << 0)
+#    define PM_SCAN_CHECK_WPASYNC (1 << 1)
+
+struct page_region {
+  __u64 start;
+  __u64 end;
+  __u64 categories;
+};
+
+struct pm_scan_arg {
+  __u64 size;
+  __u64 flags;
+  __u64 start;
+  __u64 end;
+  __u64 walk_end;
+  __u64 vec;
+  __u64 vec_len;
+  __u64 max_pages;
+  __u64 category_inverted;
+  __u64 category_mask;
+  __u64 category_anyof_mask;
+  __u64 return_mask;
+};
+
+#    define PAGEMAP_SCAN _IOWR('f', 16, struct pm_scan_arg)
+#  endif
+
+#  ifndef PAGEMAP_SCAN_VEC_LEN
+/* The number of page ranges retrieved by one `PAGEMAP_SCAN` request. */
+#    define PAGEMAP_SCAN_VEC_LEN 64
+#  endif
+#endif
+
 #ifdef SOFT_VDB
 #  ifndef VDB_BUF_SZ
 #    define VDB_BUF_SZ 16384
@@ -4288,6 +4638,15 @@ clear_soft_dirty_bits(void)
                res < 0 ? errno : 0);
 }
 
+#  ifdef SOFT_PAGEMAP_SCAN
+/*
+ * Is `PAGEMAP_SCAN` supported?  If so, the soft-dirty pages are retrieved
+ * by the requests to `GC_pagemap_fd`.  The bits are still cleared by
+ * writing to `clear_refs` file.
+ */
+static GC_bool soft_pagemap_scan_supported = FALSE;
+#  endif
+
 /* The bit 55 of the 64-bit `qword` of `pagemap` file is the soft-dirty one. */
 #  define PM_SOFTDIRTY_MASK ((pagemap_elem_t)1 << 55)
 
@@ -4362,6 +4721,20 @@ GC_dirty_init(void)
     close(GC_pagemap_fd);
     return FALSE;
   }
+#  ifdef SOFT_PAGEMAP_SCAN
+  {
+    struct pm_scan_arg arg;
+
+    /* Check `PAGEMAP_SCAN` is supported (on an empty range). */
+    BZERO(&arg, sizeof(arg));
+    arg.size = sizeof(arg);
+    soft_pagemap_scan_supported
+        = ioctl(GC_pagemap_fd, PAGEMAP_SCAN, &arg) != -1;
+    if (!soft_pagemap_scan_supported) {
+      GC_COND_LOG_PRINTF("PAGEMAP_SCAN is not supported by kernel\n");
+    }
+  }
+#  endif
   return TRUE;
 }
 
@@ -4434,6 +4807,63 @@ pagemap_buffered_read(size_t *pres, off_t fpos, size_t len,
   return &((pagemap_elem_t *)GC_soft_vdb_buf)[ofs / sizeof(pagemap_elem_t)];
 }
 
+/*
+ * Set the entries of `GC_grungy_pages` for the heap blocks of the range
+ * of soft-dirty pages [`vaddr`, `vlimit`) intersected with [`start`,
+ * `limit`).
+ */
+static void
+soft_set_grungy_range(ptr_t vaddr, ptr_t vlimit, ptr_t start, ptr_t limit,
+                      GC_bool is_static_root)
+{
+  struct hblk *h;
+
+  if (UNLIKELY(ADDR_LT(limit, vlimit))) {
+    vlimit = limit;
+  }
+#  ifdef DEBUG_DIRTY_BITS
+  if (is_static_root)
+    GC_log_printf("static root dirty pages at: %p..%p\n", (void *)vaddr,
+                  (void *)vlimit);
+#  endif
+  h = (struct hblk *)vaddr;
+  if (UNLIKELY(ADDR_LT(vaddr, start))) {
+    h = (struct hblk *)start;
+  }
+  for (; ADDR_LT((ptr_t)h, vlimit); h++) {
+    size_t index = PHT_HASH(h);
+
+    /*
+     * Filter out the blocks without pointers.  It might be worth for
+     * the case when the heap is large enough for the hash collisions
+     * to occur frequently.  Thus, off by default.
+     */
+#  if defined(FILTER_PTRFREE_HBLKS_IN_SOFT_VDB) || defined(CHECKSUMS) \
+      || defined(DEBUG_DIRTY_BITS)
+    if (!is_static_root) {
+      hdr *hhdr;
+
+#    ifdef CHECKSUMS
+      set_pht_entry_from_index(GC_written_pages, index);
+#    endif
+      GET_HDR(h, hhdr);
+      if (NULL == hhdr)
+        continue;
+
+      (void)GC_find_starting_hblk(h, &hhdr);
+      if (HBLK_IS_FREE(hhdr) || IS_PTRFREE(hhdr))
+        continue;
+#    ifdef DEBUG_DIRTY_BITS
+      GC_log_printf("dirty page (hblk) at: %p\n", (void *)h);
+#    endif
+    }
+#  else
+    UNUSED_ARG(is_static_root);
+#  endif
+    set_pht_entry_from_index(GC_grungy_pages, index);
+  }
+}
+
 static void
 soft_set_grungy_pages(ptr_t start, ptr_t limit, ptr_t next_start_hint,
                       GC_bool is_static_root)
@@ -4465,57 +4895,12 @@ soft_set_grungy_pages(ptr_t start, ptr_t limit, ptr_t next_start_hint,
     limit_buf = vaddr + ((res / sizeof(pagemap_elem_t)) << GC_log_pagesize);
     for (; ADDR_LT(vaddr, limit_buf); vaddr += GC_page_size, bufp++) {
       if ((*bufp & PM_SOFTDIRTY_MASK) != 0) {
-        struct hblk *h;
-        ptr_t next_vaddr = vaddr + GC_page_size;
-
-        if (UNLIKELY(ADDR_LT(limit, next_vaddr))) {
-          next_vaddr = limit;
-        }
-
         /*
          * If the bit is set, the respective PTE was written to
          * since clearing the soft-dirty bits.
          */
-#  ifdef DEBUG_DIRTY_BITS
-        if (is_static_root)
-          GC_log_printf("static root dirty page at: %p\n", (void *)vaddr);
-#  endif
-        h = (struct hblk *)vaddr;
-        if (UNLIKELY(ADDR_LT(vaddr, start))) {
-          h = (struct hblk *)start;
-        }
-        for (; ADDR_LT((ptr_t)h, next_vaddr); h++) {
-          size_t index = PHT_HASH(h);
-
-          /*
-           * Filter out the blocks without pointers.  It might be worth for
-           * the case when the heap is large enough for the hash collisions
-           * to occur frequently.  Thus, off by default.
-           */
-#  if defined(FILTER_PTRFREE_HBLKS_IN_SOFT_VDB) || defined(CHECKSUMS) \
-      || defined(DEBUG_DIRTY_BITS)
-          if (!is_static_root) {
-            hdr *hhdr;
-
-#    ifdef CHECKSUMS
-            set_pht_entry_from_index(GC_written_pages, index);
-#    endif
-            GET_HDR(h, hhdr);
-            if (NULL == hhdr)
-              continue;
-
-            (void)GC_find_starting_hblk(h, &hhdr);
-            if (HBLK_IS_FREE(hhdr) || IS_PTRFREE(hhdr))
-              continue;
-#    ifdef DEBUG_DIRTY_BITS
-            GC_log_printf("dirty page (hblk) at: %p\n", (void *)h);
-#    endif
-          }
-#  else
-          UNUSED_ARG(is_static_root);
-#  endif
-          set_pht_entry_from_index(GC_grungy_pages, index);
-        }
+        soft_set_grungy_range(vaddr, vaddr + GC_page_size, start, limit,
+                              is_static_root);
       } else {
 #  if defined(CHECK_SOFT_VDB) /* `&& defined(MPROTECT_VDB)` */
         /*
@@ -4541,6 +4926,68 @@ soft_set_grungy_pages(ptr_t start, ptr_t limit, ptr_t next_start_hint,
   }
 }
 
+#  ifdef SOFT_PAGEMAP_SCAN
+/*
+ * Issue a `PAGEMAP_SCAN` request for the soft-dirty pages of the range
+ * [`*pvaddr`, `vlimit`) (both should be page-aligned).  The found ranges
+ * are stored to `vec`, the number of them is returned.  `*pvaddr` is
+ * advanced to the end of the scanned part of the range.  A negative
+ * value is returned in case of a failure.
+ */
+static long
+soft_pagemap_scan(word *pvaddr, word vlimit, struct page_region *vec)
+{
+  struct pm_scan_arg arg;
+  long n;
+
+  GC_ASSERT(*pvaddr < vlimit);
+  BZERO(&arg, sizeof(arg));
+  arg.size = sizeof(arg);
+  arg.start = *pvaddr;
+  arg.end = vlimit;
+  arg.vec = ADDR(vec);
+  arg.vec_len = PAGEMAP_SCAN_VEC_LEN;
+  arg.category_mask = PAGE_IS_SOFT_DIRTY;
+  arg.return_mask = PAGE_IS_SOFT_DIRTY;
+  n = ioctl(GC_pagemap_fd, PAGEMAP_SCAN, &arg);
+  if (UNLIKELY(n < 0 || arg.walk_end <= *pvaddr))
+    return -1;
+  *pvaddr = (word)arg.walk_end;
+  return n;
+}
+
+/*
+ * Same as `soft_set_grungy_pages` but the soft-dirty pages ranges are
+ * retrieved by `PAGEMAP_SCAN` requests.
+ */
+static void
+soft_scan_grungy_pages(ptr_t start, ptr_t limit, GC_bool is_static_root)
+{
+  struct page_region vec[PAGEMAP_SCAN_VEC_LEN];
+  word vaddr = ADDR(HBLK_PAGE_ALIGNED(start));
+  word vlimit = ADDR(PTR_ALIGN_UP(limit, GC_page_size));
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(modHBLKSZ(ADDR(start)) == 0);
+  while (vaddr < vlimit) {
+    long i;
+    long n = soft_pagemap_scan(&vaddr, vlimit, vec);
+
+    if (n < 0) {
+      /* Punt. */
+      memset(GC_grungy_pages, 0xff, sizeof(page_hash_table));
+      WARN("PAGEMAP_SCAN failed, errno= %" WARN_PRIdPTR "\n",
+           (GC_signed_word)errno);
+      break;
+    }
+    for (i = 0; i < n; i++) {
+      soft_set_grungy_range(MAKE_CPTR(vec[i].start), MAKE_CPTR(vec[i].end),
+                            start, limit, is_static_root);
+    }
+  }
+}
+#  endif /* SOFT_PAGEMAP_SCAN */
+
 GC_INLINE void
 GC_soft_read_dirty(GC_bool output_unneeded)
 {
@@ -4569,22 +5016,42 @@ GC_soft_read_dirty(GC_bool output_unneeded)
     BZERO(GC_grungy_pages, sizeof(GC_grungy_pages));
     GC_pagemap_buf_len = 0; /*< invalidate `GC_soft_vdb_buf` */
 
-    for (i = 0; i < GC_n_heap_sects; ++i) {
-      ptr_t start = GC_heap_sects[i].hs_start;
+#  ifdef SOFT_PAGEMAP_SCAN
+    if (soft_pagemap_scan_supported) {
+      for (i = 0; i < GC_n_heap_sects; ++i) {
+        ptr_t start = GC_heap_sects[i].hs_start;
 
-      soft_set_grungy_pages(
-          start, start + GC_heap_sects[i].hs_bytes,
-          i + 1 < GC_n_heap_sects ? GC_heap_sects[i + 1].hs_start : NULL,
-          FALSE);
-    }
+        soft_scan_grungy_pages(start, start + GC_heap_sects[i].hs_bytes,
+                               FALSE);
+      }
+#    ifndef NO_VDB_FOR_STATIC_ROOTS
+      for (i = 0; i < n_root_sets; ++i) {
+        soft_scan_grungy_pages((ptr_t)HBLKPTR(GC_static_roots[i].r_start),
+                               GC_static_roots[i].r_end, TRUE);
+      }
+#    endif
+    } else
+#  endif
+    /* else */ {
+      for (i = 0; i < GC_n_heap_sects; ++i) {
+        ptr_t start = GC_heap_sects[i].hs_start;
+
+        soft_set_grungy_pages(
+            start, start + GC_heap_sects[i].hs_bytes,
+            i + 1 < GC_n_heap_sects ? GC_heap_sects[i + 1].hs_start : NULL,
+            FALSE);
+      }
 
 #  ifndef NO_VDB_FOR_STATIC_ROOTS
-    for (i = 0; i < n_root_sets; ++i) {
-      soft_set_grungy_pages(
-          (ptr_t)HBLKPTR(GC_static_roots[i].r_start), GC_static_roots[i].r_end,
-          i + 1 < n_root_sets ? GC_static_roots[i + 1].r_start : NULL, TRUE);
-    }
+      for (i = 0; i < n_root_sets; ++i) {
+        soft_set_grungy_pages(
+            (ptr_t)HBLKPTR(GC_static_roots[i].r_start),
+            GC_static_roots[i].r_end,
+            i + 1 < n_root_sets ? GC_static_roots[i + 1].r_start : NULL,
+            TRUE);
+      }
 #  endif
+    }
   }
 
   clear_soft_dirty_bits();
@@ -4596,12 +5063,28 @@ GC_soft_read_dirty(GC_bool output_unneeded)
 #  include <sys/ioctl.h>
 #  include <sys/syscall.h>
 
-/* Open the `userfaultfd` file descriptor. */
+#  ifdef UFFDWP_ASYNC
+/* The following might be missing in the kernel headers. */
+#    ifndef UFFD_FEATURE_WP_UNPOPULATED
+#      define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#    endif
+#    ifndef UFFD_FEATURE_WP_ASYNC
+#      define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#    endif
+
+/*
+ * Is the asynchronous mode on?  If so, the written pages are retrieved
+ * (and write-protected again) by `PAGEMAP_SCAN` requests to the file
+ * referred by `uffdwp_pagemap_fd`, and no monitor thread is used.
+ */
+static GC_bool uffdwp_async = FALSE;
+static int uffdwp_pagemap_fd = -1;
+#  endif /* UFFDWP_ASYNC */
+
+/* Open the `userfaultfd` file descriptor only. */
 static GC_bool
-uffdwp_dirty_open_files(void)
+uffdwp_open_fd(void)
 {
-  struct uffdio_api api;
-
   GC_ASSERT(-1 == uffdwp_fd);
 #  ifndef UFFDWP_NOT_USER_MODE_ONLY
 #    ifndef UFFD_USER_MODE_ONLY
@@ -4622,6 +5105,75 @@ uffdwp_dirty_open_files(void)
       return FALSE;
     }
   }
+  return TRUE;
+}
+
+#  ifdef UFFDWP_ASYNC
+/*
+ * Try to enable the asynchronous write-protect mode on the newly opened
+ * `userfaultfd` file descriptor.  In case of a failure, the descriptor
+ * is reopened (`uffdwp_fd` is -1 if the latter fails).
+ */
+static void
+uffdwp_try_async_mode(void)
+{
+  struct uffdio_api api;
+
+#    ifdef MEMORY_SANITIZER
+  BZERO(&api, sizeof(api));
+#    endif
+  api.api = UFFD_API;
+  /*
+   * Without `UFFD_FEATURE_WP_UNPOPULATED`, the never-touched (and the
+   * unmapped) pages of the heap cannot be write-protected, thus they
+   * would be reported as written on every scan.
+   */
+  api.features = UFFD_FEATURE_PAGEFAULT_FLAG_WP | UFFD_FEATURE_WP_ASYNC
+                 | UFFD_FEATURE_WP_UNPOPULATED;
+  if (ioctl(uffdwp_fd, UFFDIO_API, &api) != -1
+      && (api.features & UFFD_FEATURE_WP_ASYNC) != 0
+      && (api.features & UFFD_FEATURE_WP_UNPOPULATED) != 0) {
+    uffdwp_pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (uffdwp_pagemap_fd != -1) {
+      struct pm_scan_arg arg;
+
+      /* Check `PAGEMAP_SCAN` is supported (on an empty range). */
+      BZERO(&arg, sizeof(arg));
+      arg.size = sizeof(arg);
+      if (ioctl(uffdwp_pagemap_fd, PAGEMAP_SCAN, &arg) != -1) {
+        uffdwp_async = TRUE;
+        return;
+      }
+      close(uffdwp_pagemap_fd);
+      uffdwp_pagemap_fd = -1;
+    }
+  }
+  GC_COND_LOG_PRINTF(
+      "userfaultfd asynchronous write-protect is not supported by kernel\n");
+
+  /* The API handshake cannot be repeated, so reopen the descriptor. */
+  close(uffdwp_fd);
+  uffdwp_fd = -1;
+  (void)uffdwp_open_fd();
+}
+#  endif
+
+/* Open the `userfaultfd` file descriptor and enable the write-protection. */
+static GC_bool
+uffdwp_dirty_open_files(void)
+{
+  struct uffdio_api api;
+
+  if (!uffdwp_open_fd())
+    return FALSE;
+#  ifdef UFFDWP_ASYNC
+  uffdwp_try_async_mode();
+  if (uffdwp_async)
+    return TRUE;
+  if (-1 == uffdwp_fd)
+    return FALSE;
+#  endif
+
   /* Enable the write-protect feature. */
 #  ifdef MEMORY_SANITIZER
   /* Prevent MSan false positive (FP) about use of uninitialized value. */
@@ -4717,6 +5269,12 @@ uffdwp_monitor_thread(void *arg)
 }
 
 #  ifdef CAN_HANDLE_FORK
+/*
+ * Is the monitor thread to be started (before the heap sections are
+ * registered)?  Set in the forked child in the synchronous mode.
+ */
+static GC_bool uffdwp_monitor_needed = FALSE;
+
 GC_INNER void
 GC_dirty_update_child(void)
 {
@@ -4733,10 +5291,41 @@ GC_dirty_update_child(void)
    * kernel when closing the file descriptor.
    */
   close(uffdwp_fd);
-  /* TODO: Re-enable incremental mode in child. */
   GC_uffdwp_registered_sects = 0;
   uffdwp_fd = -1;
-  GC_incremental = FALSE;
+#    ifdef UFFDWP_ASYNC
+  if (uffdwp_async) {
+    /* The descriptor refers to the parent process. */
+    close(uffdwp_pagemap_fd);
+    uffdwp_pagemap_fd = -1;
+    uffdwp_async = FALSE;
+  }
+#    endif
+  if (!uffdwp_dirty_open_files()) {
+    /* Should be safe to turn it off. */
+    GC_incremental = FALSE;
+    return;
+  }
+#    ifdef UFFDWP_ASYNC
+  if (uffdwp_async) {
+    /*
+     * As the pages are not write-protected in the child, all of them are
+     * considered written till the heap sections are registered again and
+     * the pages are protected by the next `GC_read_dirty` call.
+     */
+    return;
+  }
+#    endif
+  /*
+   * The monitor thread of the parent does not exist in the child.
+   * A new one is started once the heap sections are registered again
+   * (i.e. not in the `fork()` handler).  The writes are not tracked till
+   * the heap is protected by the next `GC_read_dirty` call, thus all the
+   * pages are considered written.
+   */
+  uffdwp_monitor_needed = TRUE;
+  memset(CAST_AWAY_VOLATILE_PVOID(GC_dirty_pages), 0xff,
+         sizeof(GC_dirty_pages));
 }
 #  endif /* CAN_HANDLE_FORK */
 
@@ -4763,6 +5352,12 @@ GC_dirty_init(void)
 #  endif
   if (!uffdwp_dirty_open_files())
     return FALSE;
+#  ifdef UFFDWP_ASYNC
+  if (uffdwp_async) {
+    GC_COND_LOG_PRINTF("Using userfaultfd asynchronous write-protect mode\n");
+    return TRUE;
+  }
+#  endif
   if (UNLIKELY(!create_detached_thread(uffdwp_monitor_thread))) {
     WARN("Failed to create userfaultfd monitor thread\n", 0);
     close(uffdwp_fd);
@@ -4777,6 +5372,14 @@ uffdwp_register_heap_lazy(void)
 {
   size_t i;
 
+#  ifdef CAN_HANDLE_FORK
+  if (UNLIKELY(uffdwp_monitor_needed)) {
+    /* No page could be write-protected before the monitor is started. */
+    if (UNLIKELY(!create_detached_thread(uffdwp_monitor_thread)))
+      ABORT("Failed to create userfaultfd monitor thread in child");
+    uffdwp_monitor_needed = FALSE;
+  }
+#  endif
   for (i = GC_uffdwp_registered_sects; i < GC_n_heap_sects; i++) {
     struct uffdio_register mem_reg;
 
@@ -4793,6 +5396,61 @@ uffdwp_register_heap_lazy(void)
   GC_uffdwp_registered_sects = GC_n_heap_sects;
 }
 
+#  ifdef UFFDWP_ASYNC
+/*
+ * Retrieve the pages of the (registered) heap sections written since
+ * the previous call, and write-protect them again, in one `PAGEMAP_SCAN`
+ * request per heap section (unless the output buffer is not big enough).
+ * The dirty pages are added to `GC_grungy_pages` unless `output_unneeded`.
+ */
+static void
+uffdwp_async_read_dirty(GC_bool output_unneeded)
+{
+  struct page_region vec[PAGEMAP_SCAN_VEC_LEN];
+  size_t i;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(GC_uffdwp_registered_sects == GC_n_heap_sects);
+  for (i = 0; i < GC_n_heap_sects; i++) {
+    struct pm_scan_arg arg;
+    word start = ADDR(GC_heap_sects[i].hs_start);
+    word end = start + GC_heap_sects[i].hs_bytes;
+
+    BZERO(&arg, sizeof(arg));
+    arg.size = sizeof(arg);
+    arg.flags = PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC;
+    arg.vec = ADDR(vec);
+    arg.vec_len = PAGEMAP_SCAN_VEC_LEN;
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask = PAGE_IS_WRITTEN;
+    while (start < end) {
+      long n, j;
+
+      arg.start = start;
+      arg.end = end;
+      n = ioctl(uffdwp_pagemap_fd, PAGEMAP_SCAN, &arg);
+      if (n < 0 || arg.walk_end <= start)
+        ABORT_ARG2("PAGEMAP_SCAN failed", ": heap section %lu, errno= %d",
+                   (unsigned long)i, errno);
+      if (!output_unneeded) {
+        for (j = 0; j < n; j++) {
+          struct hblk *h = (struct hblk *)MAKE_CPTR(vec[j].start);
+          ptr_t limit = MAKE_CPTR(vec[j].end);
+
+#    ifdef DEBUG_DIRTY_BITS
+          GC_log_printf("dirty pages at: %p..%p\n", (void *)h, (void *)limit);
+#    endif
+          for (; ADDR_LT((ptr_t)h, limit); h++) {
+            set_pht_entry_from_index(GC_grungy_pages, PHT_HASH(h));
+          }
+        }
+      }
+      start = (word)arg.walk_end;
+    }
+  }
+}
+#  endif /* UFFDWP_ASYNC */
+
 #  ifdef MPROTECT_VDB
 #    define UF_MP_PROTECT_INNER(addr, len, allow_write)           \
       do {                                                        \
@@ -4923,6 +5581,70 @@ GC_dirty_inner(const void *p)
 }
 #endif
 
+#if !defined(GC_DISABLE_INCREMENTAL) && !defined(NO_MANUAL_VDB)
+unsigned char GC_card_table[CARD_TABLE_ENTRIES];
+unsigned char GC_cards_marked = 0;
+
+/* Is any bit set in `GC_grungy_cards`? */
+STATIC GC_bool GC_grungy_cards_present = FALSE;
+
+/*
+ * Move the marks of `GC_card_table` to `GC_grungy_cards` (unless
+ * `output_unneeded`).  The card table is not scanned at all unless
+ * a card has been marked since the previous call; otherwise, it is
+ * scanned a word at a time, and only its nonzero words are cleared.
+ * A card marked concurrently between the read and the clear of the word
+ * is lost; as for `GC_dirty()`, the updated object should be kept on the
+ * stack (and, thus, treated as dirty) in the interim.
+ */
+GC_ATTR_NO_SANITIZE_THREAD
+STATIC void
+GC_read_dirty_cards(GC_bool output_unneeded)
+{
+  size_t i;
+
+  if (GC_grungy_cards_present) {
+    BZERO(GC_grungy_cards, sizeof(GC_grungy_cards));
+    GC_grungy_cards_present = FALSE;
+  }
+  if (!GC_cards_marked)
+    return;
+  /* Cleared before the table is read, thus no mark is missed next time. */
+  GC_cards_marked = 0;
+  for (i = 0; i < CARD_TABLE_ENTRIES; i += sizeof(word)) {
+    word w;
+    size_t j;
+
+    BCOPY(&GC_card_table[i], &w, sizeof(word));
+    if (LIKELY(0 == w))
+      continue;
+    BZERO(&GC_card_table[i], sizeof(word));
+    if (output_unneeded)
+      continue;
+    for (j = 0; j < sizeof(word); j++) {
+      if (((unsigned char *)&w)[j] != 0)
+        set_pht_entry_from_index(GC_grungy_cards, i + j);
+    }
+    GC_grungy_cards_present = TRUE;
+  }
+}
+
+GC_INNER GC_bool
+GC_cards_were_dirty(ptr_t start, ptr_t limit)
+{
+  ptr_t p;
+
+  if (!GC_grungy_cards_present)
+    return FALSE;
+  for (p = PTR_ALIGN_DOWN(start, CARD_BYTES); ADDR_LT(p, limit);
+       p += CARD_BYTES) {
+    if (get_pht_entry_from_index(GC_grungy_cards, GC_CARD_INDEX(p)))
+      return TRUE;
+  }
+  return FALSE;
+}
+#endif
+
 #ifndef GC_DISABLE_INCREMENTAL
 GC_INNER void
 GC_read_dirty(GC_bool output_unneeded)
@@ -4943,9 +5665,19 @@ GC_read_dirty(GC_bool output_unneeded)
       BCOPY(CAST_AWAY_VOLATILE_PVOID(GC_dirty_pages), GC_grungy_pages,
             sizeof(GC_dirty_pages));
     BZERO(CAST_AWAY_VOLATILE_PVOID(GC_dirty_pages), sizeof(GC_dirty_pages));
+#  ifndef NO_MANUAL_VDB
+    if (GC_manual_vdb)
+      GC_read_dirty_cards(output_unneeded);
+#  endif
 #  if defined(MPROTECT_VDB) || defined(UFFDWP_VDB)
     if (!GC_manual_vdb) {
       REGISTER_HEAP_LAZY();
+#    ifdef UFFDWP_ASYNC
+      if (uffdwp_async) {
+        uffdwp_async_read_dirty(output_unneeded);
+        return;
+      }
+#    endif
       GC_protect_heap();
     }
 #  endif
@@ -5034,7 +5766,7 @@ GC_page_was_ever_dirty(const struct hblk *h)
 GC_INNER void
 GC_remove_protection(struct hblk *h, size_t nblocks, GC_bool is_ptrfree)
 {
-#  ifndef PARALLEL_MARK
+#  if !defined(PARALLEL_MARK) && !defined(SIZE_CLASS_LOCKS)
   GC_ASSERT(I_HOLD_LOCK());
 #  endif
 #  if defined(MPROTECT_VDB) || defined(UFFDWP_VDB)
@@ -5051,6 +5783,10 @@ GC_remove_protection(struct hblk *h, size_t nblocks, GC_bool is_ptrfree)
 #    if defined(GWW_VDB) || defined(SOFT_VDB)
   if (IS_NON_MPROTECT_VDB())
     return;
+#    elif defined(UFFDWP_ASYNC)
+  /* The writes are tracked by the kernel without blocking the writer. */
+  if (uffdwp_async)
+    return;
 #    endif
   GC_ASSERT(GC_page_size != 0);
   REGISTER_HEAP_LAZY();
@@ -27,6 +27,12 @@
 #    include <semaphore.h>
 #    include <signal.h>
 #    include <time.h>
+#    ifdef SAFEPOINT_STOP_WORLD
+#      include <limits.h>
+#      include <linux/futex.h>
+#      include <sys/syscall.h>
+#      include <unistd.h>
+#    endif
 #  endif /* !NACL */
 
 #  ifdef E2K
@@ -560,6 +566,170 @@ resend_lost_signals_retry(int n_live_threads, int (*suspend_restart_all)(void))
   suspend_restart_barrier(n_live_threads);
 }
 
+#    ifdef SAFEPOINT_STOP_WORLD
+/*
+ * The cooperative world stop.  `GC_stop_world()` publishes an even
+ * `GC_safepoint_epoch` value; the registered threads notice it at the
+ * allocation entry points (or in `GC_safepoint()`), store their stack
+ * pointer and park on a futex.  Only the threads which have not parked
+ * within `SAFEPOINT_TIMEOUT_USEC` are sent the suspend signal.
+ */
+#      ifndef SAFEPOINT_TIMEOUT_USEC
+#        define SAFEPOINT_TIMEOUT_USEC 1000
+#      endif
+
+GC_INNER volatile unsigned GC_safepoint_epoch = THREAD_RESTARTED;
+
+/*
+ * The number of threads parked during the current world stop, and the
+ * number of threads `GC_stop_world()` waits to park.  The thread parking
+ * the last one wakes up the world stopper.
+ */
+STATIC volatile unsigned GC_safepoint_parked = 0;
+STATIC volatile unsigned GC_safepoint_expected = 0;
+
+static void
+safepoint_futex_wait(volatile unsigned *p, unsigned v,
+                     const struct timespec *timeout)
+{
+  (void)syscall(SYS_futex, p, FUTEX_WAIT_PRIVATE, v, timeout, NULL, 0);
+}
+
+static void
+safepoint_futex_wake(volatile unsigned *p, int cnt)
+{
+  (void)syscall(SYS_futex, p, FUTEX_WAKE_PRIVATE, cnt, NULL, NULL, 0);
+}
+
+GC_INNER void
+GC_safepoint_park_self(ptr_t tlfs, void *context)
+{
+  GC_thread me = (GC_thread)(tlfs - offsetof(struct GC_Thread_Rep, tlfs));
+  unsigned epoch = AO_int_load_acquire(&GC_safepoint_epoch);
+  AO_t my_stop_count = AO_load_acquire(&GC_stop_count);
+  AO_t state;
+
+  UNUSED_ARG(context);
+  GC_ASSERT(I_DONT_HOLD_LOCK());
+  if ((unsigned)my_stop_count != epoch
+      || (my_stop_count & THREAD_RESTARTED) != 0
+      || (me->flags & DO_BLOCKING) != 0) {
+    /* The world is not being stopped (anymore) by `GC_stop_world()`. */
+    return;
+  }
+
+  GC_store_stack_ptr(me->crtn);
+  state = AO_load(&me->safepoint_state);
+  if (state == (my_stop_count | THREAD_RESTARTED)
+      || !AO_compare_and_swap_release(&me->safepoint_state, state,
+                                      my_stop_count)) {
+    /* We are about to receive the suspend signal. */
+    return;
+  }
+  if (AO_load_acquire(&GC_stop_count) != my_stop_count) {
+    /*
+     * The world has been restarted meanwhile, the collection treated
+     * this thread as a parked one.
+     */
+    return;
+  }
+
+  if (AO_int_fetch_and_add1(&GC_safepoint_parked) + 1
+      == AO_int_load(&GC_safepoint_expected))
+    safepoint_futex_wake(&GC_safepoint_parked, 1);
+  /*
+   * `GC_start_world()` updates `GC_safepoint_epoch` after `GC_stop_count`,
+   * and before waking up the threads, thus no wakeup could be lost.
+   */
+  while (AO_load_acquire(&GC_stop_count) == my_stop_count) {
+    safepoint_futex_wait(&GC_safepoint_epoch, epoch, NULL);
+  }
+}
+
+GC_API void GC_CALL
+GC_safepoint(void)
+{
+  GC_SAFEPOINT_POLL();
+}
+
+/*
+ * Request all the threads to park at a safepoint and wait (for a limited
+ * time) until they do.  The threads which have not parked are stopped by
+ * `GC_suspend_all()` afterwards.  Return the number of parked threads.
+ */
+STATIC unsigned
+GC_safepoint_stop(void)
+{
+  unsigned n_expected = 0;
+  unsigned n_parked = 0;
+  struct timespec deadline, ts;
+  pthread_t self = pthread_self();
+  GC_thread p;
+  int i;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT((GC_stop_count & THREAD_RESTARTED) == 0);
+  for (i = 0; i < THREAD_TABLE_SZ; i++) {
+    for (p = GC_threads[i]; p != NULL; p = p->tm.next) {
+      if (!THREAD_EQUAL(p->id, self)
+          && (p->flags & (FINISHED | DO_BLOCKING)) == 0
+#      ifdef GC_ENABLE_SUSPEND_THREAD
+          && (p->ext_suspend_cnt & 1) == 0
+#      endif
+      )
+        n_expected++;
+    }
+  }
+  AO_int_store_release(&GC_safepoint_parked, 0);
+  AO_int_store_release(&GC_safepoint_expected, n_expected);
+  AO_int_store_release(&GC_safepoint_epoch, (unsigned)GC_stop_count);
+  if (0 == n_expected || clock_gettime(CLOCK_MONOTONIC, &deadline) != 0)
+    return 0;
+#      ifdef USE_FUTEX_LOCK
+  /* Let the threads waiting for the allocator lock park. */
+  safepoint_futex_wake(&GC_allocate_futex, INT_MAX);
+#      endif
+
+  TS_NSEC_ADD(deadline, SAFEPOINT_TIMEOUT_USEC * (unsigned32)1000);
+  for (;;) {
+    n_parked = AO_int_load(&GC_safepoint_parked);
+    if (n_parked >= n_expected || clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+      break;
+
+    /* Compute the time left till the deadline. */
+    ts.tv_sec = deadline.tv_sec - ts.tv_sec;
+    ts.tv_nsec = deadline.tv_nsec - ts.tv_nsec;
+    if (ts.tv_nsec < 0) {
+      ts.tv_nsec += 1000000L * 1000;
+      ts.tv_sec--;
+    }
+    if (ts.tv_sec < 0)
+      break;
+    safepoint_futex_wait(&GC_safepoint_parked, n_parked, &ts);
+  }
+  return n_parked;
+}
+
+/*
+ * Decide to stop the thread by a signal unless it has already parked
+ * itself.  Return `FALSE` if the thread is parked.
+ */
+static GC_bool
+safepoint_claim_thread(GC_thread p)
+{
+  for (;;) {
+    AO_t state = AO_load_acquire(&p->safepoint_state);
+
+    if (state == GC_stop_count)
+      return FALSE;
+    if (state == (GC_stop_count | THREAD_RESTARTED)
+        || AO_compare_and_swap_full(&p->safepoint_state, state,
+                                    GC_stop_count | THREAD_RESTARTED))
+      return TRUE;
+  }
+}
+#    endif /* SAFEPOINT_STOP_WORLD */
+
 STATIC void
 GC_restart_handler(int sig)
 {
@@ -832,6 +1002,118 @@ GC_is_thread_suspended(GC_SUSPEND_THREAD_ID thread)
 #    undef ao_store_release_async
 #  endif /* !NACL */
 
+#  ifdef STACK_WATERMARKS
+#    ifndef STACK_HOT_BYTES
+/*
+ * The size of the top part of a stopped thread stack which is never
+ * skipped regardless of its contents, e.g. the suspend handler frame
+ * is stored there.
+ */
+#      define STACK_HOT_BYTES (4 * HBLKSIZE)
+#    endif
+
+/*
+ * Return the lowest address `p` (not less than `lo`) such that the
+ * stack memory in [`p`, `hi`) equals to its copy ending at `copy_end`.
+ * Both `lo` and `hi` should be word-aligned.  The words are compared
+ * one by one (instead of `memcmp()`) not to upset the sanitizers.
+ */
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static ptr_t
+unchanged_stack_start(ptr_t lo, ptr_t hi, const word *copy_end)
+{
+  const word *p = (const word *)hi;
+
+  while (ADDR_LT(lo, (ptr_t)p) && p[-1] == copy_end[-1]) {
+    p--;
+    copy_end--;
+  }
+  return (ptr_t)p;
+}
+
+/*
+ * Save a copy of the cold part of the thread stack just scanned from
+ * `lo`; the part above `hi` (if any) has been skipped, thus it already
+ * equals to its copy.  Returns `FALSE` if out of memory.
+ */
+GC_ATTR_NO_SANITIZE_ADDR_MEM_THREAD
+static GC_bool
+save_stack_copy(GC_stack_context_t crtn, ptr_t lo, ptr_t hi)
+{
+  ptr_t end = PTR_ALIGN_DOWN(crtn->stack_end, sizeof(word));
+  const word *p;
+  word *q;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  if (ADDR_GE(lo, end - STACK_HOT_BYTES))
+    return TRUE;
+  lo = PTR_ALIGN_UP(lo + STACK_HOT_BYTES, sizeof(word));
+  if ((size_t)(end - lo) > crtn->stack_copy_size) {
+    size_t new_size = ROUNDUP_PAGESIZE((size_t)(end - lo));
+    ptr_t new_copy = GC_scratch_alloc(new_size);
+
+    if (NULL == new_copy)
+      return FALSE;
+    GC_scratch_recycle_inner(crtn->stack_copy, crtn->stack_copy_size);
+    crtn->stack_copy = new_copy;
+    crtn->stack_copy_size = new_size;
+    hi = end;
+  } else if (ADDR_LT(end, hi)) {
+    hi = end;
+  }
+  q = (word *)(crtn->stack_copy + crtn->stack_copy_size)
+      - (size_t)(end - lo) / sizeof(word);
+  for (p = (const word *)lo; ADDR_LT((ptr_t)p, hi); p++, q++) {
+    *q = *p;
+  }
+  return TRUE;
+}
+
+GC_INNER void
+GC_update_stack_watermarks(GC_bool marks_kept)
+{
+  pthread_t self = pthread_self();
+  int i;
+  GC_thread p;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  for (i = 0; i < THREAD_TABLE_SZ; i++) {
+    for (p = GC_threads[i]; p != NULL; p = p->tm.next) {
+      GC_stack_context_t crtn = p->crtn;
+      ptr_t lo = crtn->scanned_lo;
+      ptr_t sp = GC_cptr_load(&crtn->stack_ptr);
+      ptr_t end;
+
+      crtn->stack_watermark = NULL;
+      if (!marks_kept || NULL == lo || NULL == sp
+          || crtn->scanned_hi != crtn->stack_end
+          || crtn->traced_stack_sect != NULL || KNOWN_FINISHED(p)
+          || THREAD_EQUAL(p->id, self))
+        continue;
+
+      /*
+       * The cold part of the stack which still holds the same contents
+       * as at the recent scan of it need not be scanned again (provided
+       * the marks have not been cleared since then).  Note that it is
+       * not sufficient to compare just the stack pointer with that at
+       * the scan, as the older frames could be written (via pointers to
+       * locals) without the stack being unwound.
+       */
+      if (ADDR_LT(lo, sp))
+        lo = sp;
+      end = PTR_ALIGN_DOWN(crtn->stack_end, sizeof(word));
+      if (ADDR_GE(lo, end - STACK_HOT_BYTES))
+        continue;
+      lo = unchanged_stack_start(
+          PTR_ALIGN_UP(lo + STACK_HOT_BYTES, sizeof(word)), end,
+          (const word *)(crtn->stack_copy + crtn->stack_copy_size));
+      if (ADDR_LT(lo, end))
+        crtn->stack_watermark = lo;
+    }
+  }
+}
+#  endif /* STACK_WATERMARKS */
+
 GC_INNER void
 GC_push_all_stacks(void)
 {
@@ -848,16 +1130,32 @@ GC_push_all_stacks(void)
   struct GC_traced_stack_sect_s *traced_stack_sect;
   pthread_t self = pthread_self();
   word total_size = 0;
+#  ifdef STACK_WATERMARKS
+  word skipped_size = 0;
+#  endif
+#  ifdef PARALLEL_STACK_SCAN
+  GC_bool scan_in_parallel;
+#  endif
 
   GC_ASSERT(I_HOLD_LOCK());
   GC_ASSERT(GC_thr_initialized);
 #  ifdef DEBUG_THREADS
   GC_log_printf("Pushing stacks from thread %p\n", PTHREAD_TO_VPTR(self));
+#  endif
+#  ifdef PARALLEL_STACK_SCAN
+  /*
+   * Just collect the stack sections while walking the thread table,
+   * the sections are scanned by all the markers after that.
+   */
+  scan_in_parallel = GC_begin_parallel_stack_scan();
 #  endif
   for (i = 0; i < THREAD_TABLE_SZ; i++) {
     for (p = GC_threads[i]; p != NULL; p = p->tm.next) {
 #  if defined(E2K) || defined(IA64)
       GC_bool is_self = FALSE;
+#  endif
+#  ifdef STACK_WATERMARKS
+      GC_bool whole_stack;
 #  endif
       GC_stack_context_t crtn = p->crtn;
 
@@ -933,6 +1231,17 @@ GC_push_all_stacks(void)
 #  ifdef STACKPTR_CORRECTOR_AVAILABLE
       if (GC_sp_corrector != 0)
         GC_sp_corrector((void **)&lo, THREAD_ID_TO_VPTR(p->id));
+#  endif
+#  ifdef STACK_WATERMARKS
+      /* Only a part of the stack is pushed otherwise. */
+      whole_stack = hi == crtn->stack_end && NULL == traced_stack_sect;
+      if (whole_stack && crtn->stack_watermark != NULL
+          && ADDR_LT(lo, crtn->stack_watermark)) {
+        /* The part above the watermark has not changed since the scan. */
+        skipped_size += hi - crtn->stack_watermark;
+        total_size += hi - crtn->stack_watermark;
+        hi = crtn->stack_watermark;
+      }
 #  endif
       GC_push_all_stack_sections(lo, hi, traced_stack_sect);
 #  ifdef STACK_GROWS_UP
@@ -940,6 +1249,25 @@ GC_push_all_stacks(void)
 #  else
       total_size += hi - lo; /*< `lo` is not greater than `hi` */
 #  endif
+#  ifdef STACK_WATERMARKS
+      /*
+       * The skipped part (if any) is a subrange of the previously scanned
+       * one, thus the whole `[lo, stack_end)` could be considered scanned.
+       * The scanned range and the copy are not updated if the world is
+       * not stopped (e.g. the roots are pushed during an incremental
+       * marking step), as the thread stack could be changed between the
+       * scan and copying of it; the copy saved by the recent scan done
+       * with the world stopped remains valid.
+       */
+      if ((GC_stop_count & THREAD_RESTARTED) == 0) {
+        if (whole_stack && save_stack_copy(crtn, lo, hi)) {
+          crtn->scanned_lo = lo;
+        } else {
+          crtn->scanned_lo = NULL;
+        }
+        crtn->scanned_hi = crtn->stack_end;
+      }
+#  endif
 #  ifdef NACL
       /* Push `reg_storage` as roots, this will cover the reg context. */
       GC_push_all_stack(p->reg_storage,
@@ -979,10 +1307,25 @@ GC_push_all_stacks(void)
 #  endif
     }
   }
+#  ifdef PARALLEL_STACK_SCAN
+  if (scan_in_parallel)
+    GC_end_parallel_stack_scan();
+#  endif
   GC_VERBOSE_LOG_PRINTF("Pushed %d thread stacks\n", (int)nthreads);
-  if (!found_me && !GC_in_thread_creation)
+  if (!found_me && !GC_in_thread_creation
+#  ifdef CONCURRENT_MARK
+      && !GC_mark_in_background
+#  endif
+  )
     ABORT("Collecting from unknown thread");
   GC_total_stacksize = total_size;
+#  ifdef STACK_WATERMARKS
+  if (skipped_size > 0) {
+    GC_VERBOSE_LOG_PRINTF("Skipped %lu bytes of unchanged thread stacks\n",
+                          (unsigned long)skipped_size);
+  }
+  GC_stack_skipped_bytes = skipped_size;
+#  endif
 }
 
 #  ifdef DEBUG_THREADS
@@ -1023,6 +1366,12 @@ GC_suspend_all(void)
           /* Matters only if `GC_retry_signals`. */
           continue;
         }
+#    ifdef SAFEPOINT_STOP_WORLD
+        if (!safepoint_claim_thread(p)) {
+          /* The thread is parked at a safepoint. */
+          continue;
+        }
+#    endif
         n_live_threads++;
 #    ifdef DEBUG_THREADS
         GC_log_printf("Sending suspend signal to %p\n",
@@ -1114,6 +1463,9 @@ GC_stop_world(void)
 {
 #  ifndef NACL
   int n_live_threads;
+#    ifdef SAFEPOINT_STOP_WORLD
+  unsigned n_parked;
+#    endif
 #  endif
   GC_ASSERT(I_HOLD_LOCK());
   /*
@@ -1142,6 +1494,13 @@ GC_stop_world(void)
 #  else
   /* Note: only concurrent reads are possible. */
   AO_store(&GC_stop_count, GC_stop_count + THREAD_RESTARTED);
+#    ifdef SAFEPOINT_STOP_WORLD
+  /*
+   * Done before acquiring the dirty lock, so that the threads inside
+   * `GC_dirty()` could reach a safepoint.
+   */
+  n_parked = GC_safepoint_stop();
+#    endif
   if (GC_manual_vdb) {
     GC_acquire_dirty_lock();
     /*
@@ -1160,6 +1519,10 @@ GC_stop_world(void)
     /* Note: cannot be done in `GC_suspend_all`. */
     GC_release_dirty_lock();
   }
+#    ifdef SAFEPOINT_STOP_WORLD
+  GC_VERBOSE_LOG_PRINTF("World stopped: %u threads parked, %d signaled\n",
+                        n_parked, n_live_threads);
+#    endif
 #  endif
 
 #  ifdef PARALLEL_MARK
@@ -1371,6 +1734,13 @@ GC_restart_all(void)
 #    ifdef GC_ENABLE_SUSPEND_THREAD
         if ((p->ext_suspend_cnt & 1) != 0)
           continue;
+#    endif
+#    ifdef SAFEPOINT_STOP_WORLD
+        if (AO_load(&p->safepoint_state)
+            == (GC_stop_count & ~(AO_t)THREAD_RESTARTED)) {
+          /* The thread is parked, it is woken up by `GC_start_world`. */
+          continue;
+        }
 #    endif
         if (GC_retry_signals
             && AO_load(&p->last_stop_count) == GC_stop_count) {
@@ -1439,6 +1809,11 @@ GC_start_world(void)
    * synchronize memory).
    */
   AO_store_release(&GC_stop_count, GC_stop_count + THREAD_RESTARTED);
+#    ifdef SAFEPOINT_STOP_WORLD
+  AO_int_store_release(&GC_safepoint_epoch, (unsigned)GC_stop_count);
+  if (GC_safepoint_expected > 0)
+    safepoint_futex_wake(&GC_safepoint_epoch, INT_MAX);
+#    endif
 
   GC_ASSERT(!in_resend_restart_signals);
   n_live_threads = GC_restart_all();
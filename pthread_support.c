@@ -51,9 +51,10 @@
 #      include <sys/stat.h>
 #      include <sys/time.h>
 #    endif
-#    if defined(GC_EXPLICIT_SIGNALS_UNBLOCK) \
-        || !defined(GC_NO_PTHREAD_SIGMASK)   \
-        || (defined(GC_PTHREADS_PARAMARK)    \
+#    if defined(GC_EXPLICIT_SIGNALS_UNBLOCK)                       \
+        || !defined(GC_NO_PTHREAD_SIGMASK)                         \
+        || ((defined(GC_PTHREADS_PARAMARK)                         \
+             || defined(BACKGROUND_SWEEP) || defined(ASYNC_UNMAP)) \
             && !defined(NO_MARKER_SPECIAL_SIGMASK))
 #      include <signal.h>
 #    endif
@@ -63,6 +64,12 @@
 #    include <alloca.h>
 #  endif
 
+#  ifdef USE_FUTEX_LOCK
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#  endif
+
 #  if defined(DARWIN) || defined(ANY_BSD)
 #    if defined(NETBSD) || defined(OPENBSD)
 #      include <sys/param.h>
@@ -319,6 +326,9 @@ GC_mark_thread_local_free_lists(void)
         GC_mark_thread_local_fls_for(&p->tlfs);
     }
   }
+#    ifdef PERCPU_ALLOC
+  GC_mark_percpu_freelists();
+#    endif
 }
 
 #    if defined(GC_ASSERTIONS)
@@ -343,6 +353,9 @@ GC_check_tls(void)
         GC_check_tls_for(&p->tlfs);
     }
   }
+#      ifdef PERCPU_ALLOC
+  GC_check_percpu_freelists();
+#      endif
 #      if defined(USE_CUSTOM_SPECIFIC)
   if (GC_thread_key != 0)
     GC_check_tsd_marks(GC_thread_key);
@@ -362,8 +375,9 @@ GC_check_tls(void)
 #    define GC_INNER_WIN32THREAD STATIC
 #  endif
 
-#  if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID) \
-      && (defined(PARALLEL_MARK) || defined(UFFDWP_VDB))
+#  if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)         \
+      && (defined(PARALLEL_MARK) || defined(UFFDWP_VDB) \
+          || defined(BACKGROUND_SWEEP) || defined(ASYNC_UNMAP))
 #    ifdef UFFDWP_VDB
 GC_INNER
 #    else
@@ -731,6 +745,289 @@ GC_start_mark_threads_inner(void)
 
 #  endif /* GC_PTHREADS_PARAMARK */
 
+#  if defined(BACKGROUND_SWEEP) || defined(ASYNC_UNMAP)
+/*
+ * Create a detached thread (invisible to the client) running the given
+ * routine, with all signals blocked.  Returns `FALSE` on failure.
+ */
+static GC_bool
+GC_start_daemon_thread(void *(*start_routine)(void *))
+{
+  int res;
+  pthread_t new_thread;
+  pthread_attr_t attr;
+#    ifndef NO_MARKER_SPECIAL_SIGMASK
+  sigset_t set, oldset;
+#    endif
+
+  INIT_REAL_SYMS(); /*< for `pthread_sigmask` and `pthread_create` */
+  if (pthread_attr_init(&attr) != 0)
+    ABORT("pthread_attr_init failed");
+  if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0)
+    ABORT("pthread_attr_setdetachstate failed");
+#    ifndef NO_MARKER_SPECIAL_SIGMASK
+  /* Do not steal user-defined signals by the collector thread. */
+  if (sigfillset(&set) != 0)
+    ABORT("sigfillset failed");
+#      ifdef GC_NO_PTHREAD_SIGMASK
+#        define daemon_pthread_sigmask pthread_sigmask
+#      else
+#        define daemon_pthread_sigmask REAL_FUNC(pthread_sigmask)
+#      endif
+  if (UNLIKELY(daemon_pthread_sigmask(SIG_BLOCK, &set, &oldset) != 0)) {
+    WARN("pthread_sigmask set failed\n", 0);
+    (void)pthread_attr_destroy(&attr);
+    return FALSE;
+  }
+#    endif
+  res = REAL_FUNC(pthread_create)(&new_thread, &attr, start_routine, NULL);
+#    ifndef NO_MARKER_SPECIAL_SIGMASK
+  if (UNLIKELY(daemon_pthread_sigmask(SIG_SETMASK, &oldset, NULL) != 0))
+    WARN("pthread_sigmask restore failed\n", 0);
+#      undef daemon_pthread_sigmask
+#    endif
+  (void)pthread_attr_destroy(&attr);
+  return 0 == res;
+}
+#  endif
+
+#  ifdef BACKGROUND_SWEEP
+#    ifndef GC_SWEEPER_PERIOD_MS
+/*
+ * The delay (in milliseconds) between the passes of the background
+ * sweeper while the reclaim lists are not empty.
+ */
+#      define GC_SWEEPER_PERIOD_MS 2
+#    endif
+
+static pthread_mutex_t sweeper_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sweeper_cv = PTHREAD_COND_INITIALIZER;
+
+/* Set by `GC_notify_sweeper`; protected by `sweeper_mutex`. */
+static GC_bool sweep_requested = FALSE;
+
+/* Is the sweeper thread running?  Protected by the allocator lock. */
+static GC_bool sweeper_started = FALSE;
+
+static void *
+GC_sweeper_thread(void *arg)
+{
+  GC_bool more = FALSE;
+  IF_CANCEL(int cancel_state;)
+
+  if (ADDR(arg) == GC_WORD_MAX)
+    return NULL; /*< to prevent a compiler warning */
+  /* Same as the marker threads, the sweeper is invisible to client. */
+  DISABLE_CANCEL(cancel_state);
+#    ifdef HAVE_PTHREAD_SETNAME_NP_WITH_TID
+  GC_pthread_setname_np_checked("GC-sweeper");
+#    endif
+  for (;;) {
+    if (more) {
+      struct timespec ts;
+
+      ts.tv_sec = 0;
+      ts.tv_nsec = GC_SWEEPER_PERIOD_MS * 1000000L;
+      nanosleep(&ts, 0);
+    } else {
+      pthread_mutex_lock(&sweeper_mutex);
+      while (!sweep_requested)
+        pthread_cond_wait(&sweeper_cv, &sweeper_mutex);
+      sweep_requested = FALSE;
+      pthread_mutex_unlock(&sweeper_mutex);
+    }
+    more = GC_sweep_in_background();
+  }
+}
+
+STATIC void
+GC_start_sweeper_thread(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  if (UNLIKELY(!GC_start_daemon_thread(GC_sweeper_thread))) {
+    WARN("Sweeper thread creation failed\n", 0);
+    /* Do not retry at every collection. */
+    GC_background_sweep = FALSE;
+    return;
+  }
+  sweeper_started = TRUE;
+  GC_COND_LOG_PRINTF("Started background sweeper thread\n");
+}
+
+GC_INNER void
+GC_notify_sweeper(void)
+{
+  GC_ASSERT(I_HOLD_LOCK());
+  if (UNLIKELY(!GC_need_to_lock)) {
+    /* A collection during `GC_init()`; the sweeper is started later. */
+    return;
+  }
+  if (!sweeper_started) {
+    GC_start_sweeper_thread();
+    if (!sweeper_started)
+      return;
+  }
+  pthread_mutex_lock(&sweeper_mutex);
+  sweep_requested = TRUE;
+  pthread_cond_signal(&sweeper_cv);
+  pthread_mutex_unlock(&sweeper_mutex);
+}
+#  endif /* BACKGROUND_SWEEP */
+
+#  ifdef ASYNC_UNMAP
+#    ifndef GC_UNMAP_QUEUE_SIZE
+/*
+ * The maximum number of the address ranges waiting for the unmapper
+ * thread.  If the queue is full, the range is unmapped synchronously.
+ */
+#      define GC_UNMAP_QUEUE_SIZE 256
+#    endif
+
+struct unmap_range_s {
+  ptr_t start;
+  size_t len;
+};
+
+static pthread_mutex_t unmapper_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Signaled when a range is added to the queue. */
+static pthread_cond_t unmapper_cv = PTHREAD_COND_INITIALIZER;
+
+/* Broadcast when the unmapping of `unmap_in_progress` is completed. */
+static pthread_cond_t unmap_done_cv = PTHREAD_COND_INITIALIZER;
+
+/*
+ * The disjoint ranges waiting to be unmapped (in no particular order),
+ * and the range being unmapped by the unmapper thread (if its `len` is
+ * nonzero).  Protected by `unmapper_mutex`.
+ */
+static struct unmap_range_s unmap_queue[GC_UNMAP_QUEUE_SIZE];
+static size_t unmap_queue_len = 0;
+static struct unmap_range_s unmap_in_progress = { NULL, 0 };
+
+/* Is the unmapper thread running?  Protected by the allocator lock. */
+static GC_bool unmapper_started = FALSE;
+
+static void *
+GC_unmapper_thread(void *arg)
+{
+  IF_CANCEL(int cancel_state;)
+
+  if (ADDR(arg) == GC_WORD_MAX)
+    return NULL; /*< to prevent a compiler warning */
+  DISABLE_CANCEL(cancel_state);
+#    ifdef HAVE_PTHREAD_SETNAME_NP_WITH_TID
+  GC_pthread_setname_np_checked("GC-unmapper");
+#    endif
+  pthread_mutex_lock(&unmapper_mutex);
+  for (;;) {
+    while (0 == unmap_queue_len)
+      pthread_cond_wait(&unmapper_cv, &unmapper_mutex);
+    unmap_in_progress = unmap_queue[--unmap_queue_len];
+    pthread_mutex_unlock(&unmapper_mutex);
+    /* Note: the allocator lock is not held here. */
+    GC_unmap_pages(unmap_in_progress.start, unmap_in_progress.len);
+    pthread_mutex_lock(&unmapper_mutex);
+    unmap_in_progress.len = 0;
+    pthread_cond_broadcast(&unmap_done_cv);
+  }
+}
+
+GC_INNER GC_bool
+GC_enqueue_unmap(ptr_t start_addr, size_t len)
+{
+  GC_bool queued = FALSE;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(len != 0);
+  if (!unmapper_started) {
+    if (UNLIKELY(!GC_start_daemon_thread(GC_unmapper_thread))) {
+      WARN("Unmapper thread creation failed\n", 0);
+      /* Do not retry at every unmapping. */
+      GC_async_unmap = FALSE;
+      return FALSE;
+    }
+    unmapper_started = TRUE;
+    GC_COND_LOG_PRINTF("Started unmapper thread\n");
+  }
+  pthread_mutex_lock(&unmapper_mutex);
+  if (unmap_queue_len > 0
+      && unmap_queue[unmap_queue_len - 1].start
+                 + unmap_queue[unmap_queue_len - 1].len
+             == start_addr) {
+    /* Coalesce with the adjacent range queued last. */
+    unmap_queue[unmap_queue_len - 1].len += len;
+    queued = TRUE;
+  } else if (unmap_queue_len < GC_UNMAP_QUEUE_SIZE) {
+    unmap_queue[unmap_queue_len].start = start_addr;
+    unmap_queue[unmap_queue_len].len = len;
+    unmap_queue_len++;
+    queued = TRUE;
+  }
+  if (queued)
+    pthread_cond_signal(&unmapper_cv);
+  pthread_mutex_unlock(&unmapper_mutex);
+  return queued;
+}
+
+GC_INNER void
+GC_cancel_unmap(ptr_t start_addr, size_t len)
+{
+  ptr_t end_addr = start_addr + len;
+  ptr_t tail_start = NULL;
+  size_t tail_len = 0;
+  size_t i;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  pthread_mutex_lock(&unmapper_mutex);
+  for (i = 0; i < unmap_queue_len;) {
+    struct unmap_range_s *p = &unmap_queue[i];
+    ptr_t p_end = p->start + p->len;
+
+    if (!ADDR_LT(p->start, end_addr) || !ADDR_LT(start_addr, p_end)) {
+      /* No overlap. */
+      i++;
+    } else if (ADDR_LT(p->start, start_addr)) {
+      if (ADDR_LT(end_addr, p_end)) {
+        /*
+         * The given range is strictly inside the queued one (this could
+         * happen at most once as the queued ranges are disjoint).
+         */
+        if (unmap_queue_len < GC_UNMAP_QUEUE_SIZE) {
+          unmap_queue[unmap_queue_len].start = end_addr;
+          unmap_queue[unmap_queue_len].len = (size_t)(p_end - end_addr);
+          unmap_queue_len++;
+        } else {
+          tail_start = end_addr;
+          tail_len = (size_t)(p_end - end_addr);
+        }
+      }
+      p->len = (size_t)(start_addr - p->start);
+      i++;
+    } else if (ADDR_LT(end_addr, p_end)) {
+      p->len = (size_t)(p_end - end_addr);
+      p->start = end_addr;
+      i++;
+    } else {
+      /* The queued range is covered entirely, thus just drop it. */
+      *p = unmap_queue[--unmap_queue_len];
+    }
+  }
+  while (unmap_in_progress.len != 0
+         && ADDR_LT(unmap_in_progress.start, end_addr)
+         && ADDR_LT(start_addr,
+                    unmap_in_progress.start + unmap_in_progress.len)) {
+    /* Should be rare; the unmapper does not need the allocator lock. */
+    pthread_cond_wait(&unmap_done_cv, &unmapper_mutex);
+  }
+  pthread_mutex_unlock(&unmapper_mutex);
+  if (tail_len != 0) {
+    /* No room in the queue for the tail part of the split range. */
+    GC_unmap_pages(tail_start, tail_len);
+  }
+}
+#  endif /* ASYNC_UNMAP */
+
 GC_INNER GC_thread GC_threads[THREAD_TABLE_SZ] = { NULL };
 
 /*
@@ -948,6 +1245,10 @@ GC_delete_thread(GC_thread t)
       mach_port_deallocate(mach_task_self(), p->mach_thread);
 #  endif
       GC_ASSERT(p->crtn != &first_crtn);
+#  ifdef STACK_WATERMARKS
+      GC_scratch_recycle_inner(p->crtn->stack_copy,
+                               p->crtn->stack_copy_size);
+#  endif
       GC_INTERNAL_FREE(p->crtn);
       GC_INTERNAL_FREE(p);
     }
@@ -1372,7 +1673,24 @@ GC_wait_for_gc_completion(GC_bool wait_for_all)
     do {
       GC_ASSERT(!GC_in_thread_creation);
       GC_in_thread_creation = TRUE;
-      GC_collect_a_little_inner(1);
+#    ifdef CONCURRENT_MARK
+      if (GC_concurrent_mark && GC_dont_gc) {
+        /*
+         * The allocating threads do not assist the background marker
+         * while the collection is disabled (e.g. by this exiting thread),
+         * thus finish the marking without yielding, lest the heap grows
+         * meanwhile.
+         */
+        GC_collect_a_little_inner(1);
+        GC_in_thread_creation = FALSE;
+        continue;
+      }
+#    endif
+      /*
+       * In the mostly-concurrent marking mode, this lets the background
+       * marker do the work while we yield.
+       */
+      GC_collect_a_little_on_alloc(1);
       GC_in_thread_creation = FALSE;
 
       UNLOCK();
@@ -1480,6 +1798,10 @@ GC_remove_all_threads_but_me(void)
         if (p != &first_thread) {
           /* TODO: Should call `mach_port_deallocate`? */
           GC_ASSERT(p->crtn != &first_crtn);
+#      ifdef STACK_WATERMARKS
+          GC_scratch_recycle_inner(p->crtn->stack_copy,
+                                   p->crtn->stack_copy_size);
+#      endif
           GC_INTERNAL_FREE(p->crtn);
           GC_INTERNAL_FREE(p);
         }
@@ -1570,16 +1892,27 @@ fork_prepare_proc(void)
 
   LOCK();
   DISABLE_CANCEL(fork_cancel_state);
-  GC_parent_pthread_self = pthread_self();
-  /* The following waits may include cancellation points. */
-#    ifdef PARALLEL_MARK
-  if (GC_parallel)
-    wait_for_reclaim_atfork();
-#    endif
+  /*
+   * The following waits may include cancellation points.  Note: the
+   * allocator lock might be released temporarily while waiting for the
+   * collection completion, thus another thread could start building free
+   * lists or enter `fork_prepare_proc()` meanwhile.
+   */
   if (is_thread_registered_inner()) {
     /* `fork()` is called from a thread registered in the collector. */
     GC_wait_for_gc_completion(TRUE);
   }
+  /* The child should not see the mark stack half-drained. */
+  GC_stop_concurrent_drain();
+#    ifdef PARALLEL_MARK
+  if (GC_parallel) {
+#      ifdef PARALLEL_SWEEP
+    GC_finish_parallel_sweep();
+#      endif
+    wait_for_reclaim_atfork();
+  }
+#    endif
+  GC_parent_pthread_self = pthread_self();
 #    ifdef PARALLEL_MARK
   if (GC_parallel) {
 #      if defined(THREAD_SANITIZER) && defined(GC_ASSERTIONS) \
@@ -1593,6 +1926,10 @@ fork_prepare_proc(void)
     GC_acquire_mark_lock();
 #      endif
   }
+#    endif
+#    ifdef ASYNC_UNMAP
+  /* Do not let the unmapper thread be inside the queue update at fork. */
+  pthread_mutex_lock(&unmapper_mutex);
 #    endif
   GC_acquire_dirty_lock();
 }
@@ -1608,6 +1945,9 @@ static void
 fork_parent_proc(void)
 {
   GC_release_dirty_lock();
+#    ifdef ASYNC_UNMAP
+  pthread_mutex_unlock(&unmapper_mutex);
+#    endif
 #    ifdef PARALLEL_MARK
   if (GC_parallel) {
 #      if defined(THREAD_SANITIZER) && defined(GC_ASSERTIONS) \
@@ -1679,6 +2019,52 @@ fork_child_proc(void)
   /* TSan does not support threads creation in the child process. */
   GC_available_markers_m1 = 0;
 #      endif
+#    endif
+#    ifdef BACKGROUND_SWEEP
+  if (sweeper_started) {
+    /*
+     * The sweeper thread does not exist in the child process; it is
+     * restarted at the end of the next collection.  Reinitialize its
+     * mutex and condition variable (as the sweeper might use them at
+     * fork).
+     */
+    pthread_cond_t sweeper_cv_local = PTHREAD_COND_INITIALIZER;
+
+    (void)pthread_mutex_destroy(&sweeper_mutex);
+    if (pthread_mutex_init(&sweeper_mutex, NULL) != 0)
+      ABORT("sweeper_mutex re-init failed in child");
+    BCOPY(&sweeper_cv_local, &sweeper_cv, sizeof(sweeper_cv));
+    sweep_requested = FALSE;
+    sweeper_started = FALSE;
+  }
+#      ifdef THREAD_SANITIZER
+  /* TSan does not support threads creation in the child process. */
+  GC_background_sweep = FALSE;
+#      endif
+#    endif
+#    ifdef ASYNC_UNMAP
+  {
+    /*
+     * The unmapper thread does not exist in the child process; it is
+     * restarted on the next unmapping request (and handles the ranges
+     * queued before `fork()`).  The range being unmapped at `fork()`
+     * is left mapped in the child.
+     */
+    pthread_cond_t unmapper_cv_local = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t unmap_done_cv_local = PTHREAD_COND_INITIALIZER;
+
+    (void)pthread_mutex_destroy(&unmapper_mutex);
+    if (pthread_mutex_init(&unmapper_mutex, NULL) != 0)
+      ABORT("unmapper_mutex re-init failed in child");
+    BCOPY(&unmapper_cv_local, &unmapper_cv, sizeof(unmapper_cv));
+    BCOPY(&unmap_done_cv_local, &unmap_done_cv, sizeof(unmap_done_cv));
+    unmap_in_progress.len = 0;
+    unmapper_started = FALSE;
+  }
+#      ifdef THREAD_SANITIZER
+  /* TSan does not support threads creation in the child process. */
+  GC_async_unmap = FALSE;
+#      endif
 #    endif
   /* Clean up the thread table, so that just our thread is left. */
   GC_remove_all_threads_but_me();
@@ -1854,6 +2240,10 @@ GC_register_my_thread_inner(const struct GC_stack_base *sb,
  */
 STATIC int GC_nprocs = 1;
 
+#    ifdef SIZE_CLASS_LOCKS
+static void init_size_class_locks(void);
+#    endif
+
 GC_INNER void
 GC_thr_init(void)
 {
@@ -1866,6 +2256,9 @@ GC_thr_init(void)
 #    ifdef CAN_HANDLE_FORK
   GC_setup_atfork();
 #    endif
+#    ifdef SIZE_CLASS_LOCKS
+  init_size_class_locks();
+#    endif
 
 #    ifdef INCLUDE_LINUX_THREAD_DESCR
   /*
@@ -2959,7 +3352,7 @@ GC_wrap_pthread_create(pthread_t *new_thread,
 
 #  if ((defined(GC_PTHREADS_PARAMARK) || defined(USE_PTHREAD_LOCKS)) \
        && !defined(NO_PTHREAD_TRYLOCK))                              \
-      || defined(USE_SPIN_LOCK)
+      || defined(USE_SPIN_LOCK) || defined(USE_FUTEX_LOCK)
 /*
  * Spend a few cycles in a way that cannot introduce contention with
  * other threads.
@@ -2979,7 +3372,7 @@ GC_pause(void)
 #    endif
   }
 }
-#  endif /* USE_SPIN_LOCK || !NO_PTHREAD_TRYLOCK */
+#  endif /* USE_SPIN_LOCK || USE_FUTEX_LOCK || !NO_PTHREAD_TRYLOCK */
 
 #  ifndef SPIN_MAX
 /* Maximum number of calls to `GC_pause()` before give up. */
@@ -3154,6 +3547,132 @@ yield:
   }
 }
 
+#  elif defined(USE_FUTEX_LOCK)
+static void
+futex_wait(volatile unsigned *p, unsigned v)
+{
+  /* Spurious wake-ups, `EAGAIN` and `EINTR` are handled by the caller. */
+  (void)syscall(SYS_futex, p, FUTEX_WAIT_PRIVATE, v, NULL, NULL, 0);
+}
+
+static void
+futex_wake_one(volatile unsigned *p)
+{
+  (void)syscall(SYS_futex, p, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/*
+ * A moving average of the number of `GC_pause()` calls which was
+ * needed to acquire the allocator lock by spinning.  A hint only,
+ * thus a data race is OK.
+ */
+static volatile AO_t futex_spins = 0;
+
+/* Update the statistics once the allocator lock is acquired. */
+GC_INLINE void
+note_lock_acquired(void)
+{
+#    ifdef LOCK_STATS
+  GET_TIME(GC_lock_acquired_at);
+#    endif
+  GC_lock_acquisitions++;
+}
+
+/*
+ * Set the futex word to 2 (i.e. locked, possibly with waiters).
+ * Returns the previous value; 0 means the lock is acquired.
+ */
+static unsigned
+futex_mark_contended(void)
+{
+  for (;;) {
+    unsigned c = AO_int_load(&GC_allocate_futex);
+
+    if (2 == c
+        || AO_int_fetch_compare_and_swap_acquire(&GC_allocate_futex, c, 2)
+               == c)
+      return c;
+  }
+}
+
+GC_INNER void
+GC_lock(void)
+{
+  CLOCK_TYPE start_time, now;
+  unsigned c;
+
+  if (LIKELY(AO_int_fetch_compare_and_swap_acquire(&GC_allocate_futex, 0, 1)
+             == 0)) {
+    note_lock_acquired();
+    return;
+  }
+
+  /* The clock is read only if the lock is contended. */
+  GET_TIME(start_time);
+  if (GC_nprocs > 1 && !is_collecting()) {
+    /*
+     * Spin up to twice as long as it took on average to succeed; if
+     * spinning does not help, the average decays and the next waiter
+     * goes to sleep sooner.
+     */
+    AO_t spins = AO_load(&futex_spins);
+    AO_t my_spin_max = spins * 2 + 10;
+    AO_t i;
+
+    if (my_spin_max > SPIN_MAX)
+      my_spin_max = SPIN_MAX;
+    for (i = 0; i < my_spin_max; ++i) {
+      GC_pause();
+      if (AO_int_load(&GC_allocate_futex) == 0
+          && AO_int_fetch_compare_and_swap_acquire(&GC_allocate_futex, 0, 1)
+                 == 0) {
+        AO_store(&futex_spins, spins + i / 8 - spins / 8);
+        goto acquired;
+      }
+    }
+    AO_store(&futex_spins, spins / 2);
+  }
+
+  for (c = futex_mark_contended(); c != 0; c = futex_mark_contended()) {
+    /*
+     * The world stopper wakes up all the waiters once it has requested
+     * the threads to park at a safepoint.
+     */
+    GC_SAFEPOINT_POLL();
+    futex_wait(&GC_allocate_futex, 2);
+  }
+
+acquired:
+  GET_TIME(now);
+#    ifdef LOCK_STATS
+  GC_lock_acquired_at = now;
+#    endif
+  GC_lock_acquisitions++;
+  GC_lock_contended_count++;
+  GC_lock_wait_ns += (word)MS_TIME_DIFF(now, start_time) * (word)1000000
+                     + NS_FRAC_TIME_DIFF(now, start_time);
+}
+
+GC_INNER void
+GC_unlock(void)
+{
+#    ifdef LOCK_STATS
+  CLOCK_TYPE now;
+  word hold_ns;
+
+  GET_TIME(now);
+  hold_ns = (word)MS_TIME_DIFF(now, GC_lock_acquired_at) * (word)1000000
+            + NS_FRAC_TIME_DIFF(now, GC_lock_acquired_at);
+  if (hold_ns > GC_lock_max_hold_ns)
+    GC_lock_max_hold_ns = hold_ns;
+#    endif
+  if (AO_int_fetch_compare_and_swap_release(&GC_allocate_futex, 1, 0) != 1) {
+    /* There might be waiters, wake up one of them. */
+    AO_int_store_release(&GC_allocate_futex, 0);
+    futex_wake_one(&GC_allocate_futex);
+  }
+}
+
 #  elif defined(USE_PTHREAD_LOCKS)
 #    ifdef USE_RWLOCK
 GC_INNER pthread_rwlock_t GC_allocate_ml = PTHREAD_RWLOCK_INITIALIZER;
@@ -3165,6 +3684,8 @@ GC_INNER pthread_mutex_t GC_allocate_ml = PTHREAD_MUTEX_INITIALIZER;
 GC_INNER void
 GC_lock(void)
 {
+  /* Park instead of blocking on the lock held by the world stopper. */
+  GC_SAFEPOINT_POLL();
   if (1 == GC_nprocs || is_collecting()) {
     pthread_mutex_lock(&GC_allocate_ml);
   } else {
@@ -3183,7 +3704,82 @@ GC_lock(void)
 }
 #    endif /* NO_PTHREAD_TRYLOCK && GC_ASSERTIONS */
 
-#  endif /* !USE_SPIN_LOCK && USE_PTHREAD_LOCKS */
+#  endif /* !USE_SPIN_LOCK && (USE_FUTEX_LOCK || USE_PTHREAD_LOCKS) */
+
+#  ifdef BACKGROUND_SWEEP
+GC_INNER GC_bool
+GC_try_lock(void)
+{
+  GC_ASSERT(I_DONT_HOLD_LOCK());
+#    if defined(USE_SPIN_LOCK)
+  if (AO_test_and_set_acquire(&GC_allocate_lock) != AO_TS_CLEAR)
+    return FALSE;
+#    elif defined(USE_FUTEX_LOCK)
+  if (AO_int_fetch_compare_and_swap_acquire(&GC_allocate_futex, 0, 1) != 0)
+    return FALSE;
+  note_lock_acquired();
+#    elif defined(USE_RWLOCK)
+  if (pthread_rwlock_trywrlock(&GC_allocate_ml) != 0)
+    return FALSE;
+#    else
+  if (pthread_mutex_trylock(&GC_allocate_ml) != 0)
+    return FALSE;
+#    endif
+#    ifdef GC_ASSERTIONS
+  SET_LOCK_HOLDER();
+#    endif
+  return TRUE;
+}
+#  endif
+
+#  ifdef SIZE_CLASS_LOCKS
+#    ifndef SIZE_CLASS_LOCK_TABLE_SZ
+/* Must be a power of two. */
+#      define SIZE_CLASS_LOCK_TABLE_SZ 256
+#    endif
+
+/*
+ * The size class locks.  Each one occupies its own cache line, so that
+ * the threads refilling the different size classes do not contend.
+ */
+static union {
+  pthread_mutex_t m;
+  char pad[(sizeof(pthread_mutex_t) + CACHE_LINE_SIZE - 1)
+           & ~(CACHE_LINE_SIZE - 1)];
+} size_class_locks[SIZE_CLASS_LOCK_TABLE_SZ];
+
+#    define SIZE_CLASS_LOCK(kind, lg)                                   \
+      (&size_class_locks[((size_t)(kind) * (MAXOBJGRANULES + 1) + (lg)) \
+                         & (SIZE_CLASS_LOCK_TABLE_SZ - 1)]              \
+            .m)
+
+static void
+init_size_class_locks(void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE_CLASS_LOCK_TABLE_SZ; i++) {
+    if (pthread_mutex_init(&size_class_locks[i].m, NULL) != 0)
+      ABORT("pthread_mutex_init failed");
+  }
+}
+
+GC_INNER void
+GC_lock_size_class(int kind, size_t lg)
+{
+  GC_ASSERT(I_HOLD_READER_LOCK());
+  GC_ASSERT(lg <= MAXOBJGRANULES);
+  if (pthread_mutex_lock(SIZE_CLASS_LOCK(kind, lg)) != 0)
+    ABORT("pthread_mutex_lock failed");
+}
+
+GC_INNER void
+GC_unlock_size_class(int kind, size_t lg)
+{
+  if (pthread_mutex_unlock(SIZE_CLASS_LOCK(kind, lg)) != 0)
+    ABORT("pthread_mutex_unlock failed");
+}
+#  endif /* SIZE_CLASS_LOCKS */
 
 #  ifdef GC_PTHREADS_PARAMARK
 
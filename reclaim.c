@@ -457,7 +457,7 @@ GC_reclaim_generic(struct hblk *hbp, hdr *hhdr, size_t sz, GC_bool init,
 {
   ptr_t result;
 
-#ifndef PARALLEL_MARK
+#if !defined(PARALLEL_MARK) && !defined(SIZE_CLASS_LOCKS)
   GC_ASSERT(I_HOLD_LOCK());
 #endif
   GC_ASSERT(GC_find_header(hbp) == hhdr);
@@ -593,7 +593,7 @@ GC_reclaim_block(struct hblk *hbp, void *report_if_found)
           GC_large_allocd_bytes -= HBLKSIZE * OBJ_SZ_TO_BLOCKS(sz);
         }
         GC_bytes_found += (GC_signed_word)sz;
-        GC_freehblk(hbp);
+        GC_free_large_hblk(hbp);
         FREE_PROFILER_HOOK(hbp);
       }
     } else {
@@ -847,6 +847,208 @@ GC_clear_fl_links(void **flp)
   }
 }
 
+#ifdef PARALLEL_SWEEP
+/*
+ * The maximum number of blocks of a reclaim list taken by a marker
+ * thread at a time.  Should be small enough to let the other markers
+ * (and the allocating threads) share the blocks of a long list, and to
+ * not delay the next collection much.
+ */
+#  ifndef GC_SWEEP_CHUNK_BLOCKS
+#    define GC_SWEEP_CHUNK_BLOCKS 32
+#  endif
+
+GC_INNER GC_bool GC_parallel_sweep_in_progress = FALSE;
+
+/*
+ * The state of the parallel sweeping; protected by the mark lock.
+ * `GC_sweep_pending` is set while some reclaim lists have not been
+ * processed by the marker threads yet; the next one to look at is
+ * `ok_reclaim_list[GC_sweep_lg]` of `GC_sweep_kind`.
+ */
+STATIC GC_bool GC_sweep_pending = FALSE;
+STATIC unsigned GC_sweep_kind = 0;
+STATIC size_t GC_sweep_lg = 0;
+STATIC unsigned GC_sweep_n_kinds = 0;
+
+/*
+ * The free lists built by the marker threads, indexed by kind and object
+ * size in granules.  The storage is allocated by `GC_scratch_alloc()`
+ * on demand.  `GC_swept_bytes` is the total size of the objects reclaimed
+ * by the marker threads but not accounted in `GC_bytes_found` yet.
+ * Protected by the mark lock.
+ */
+STATIC void **GC_swept_fl[MAXOBJKINDS] = { NULL };
+STATIC word GC_swept_bytes = 0;
+
+/*
+ * Hand the reclaim lists filled in by `GC_start_reclaim` to the marker
+ * threads.  Does nothing if we fail to allocate the swept free lists.
+ */
+STATIC void
+GC_start_parallel_sweep(void)
+{
+  unsigned kind;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(!GC_parallel_sweep_in_progress);
+  for (kind = 0; kind < GC_n_kinds; kind++) {
+    if (GC_obj_kinds[kind].ok_reclaim_list != NULL
+        && NULL == GC_swept_fl[kind]) {
+      void **sfl = (void **)GC_scratch_alloc((MAXOBJGRANULES + 1)
+                                             * sizeof(void *));
+
+      if (UNLIKELY(NULL == sfl))
+        return;
+      BZERO(sfl, (MAXOBJGRANULES + 1) * sizeof(void *));
+      GC_swept_fl[kind] = sfl;
+    }
+  }
+
+  GC_acquire_mark_lock();
+  GC_sweep_kind = 0;
+  GC_sweep_lg = 1;
+  GC_sweep_n_kinds = GC_n_kinds;
+  GC_sweep_pending = TRUE;
+  GC_release_mark_lock();
+  GC_parallel_sweep_in_progress = TRUE;
+  GC_notify_all_marker();
+}
+
+GC_INNER GC_bool
+GC_sweep_some_blocks(void)
+{
+  struct obj_kind *ok;
+  struct hblk **rlh;
+  struct hblk *hbp, *last;
+  hdr *hhdr;
+  unsigned kind;
+  size_t lg, sz;
+  unsigned short gc_no;
+  int n;
+  ptr_t list = NULL;
+  ptr_t tail = NULL;
+  word found = 0;
+
+  if (!GC_sweep_pending)
+    return FALSE;
+
+  /* Find the next nonempty reclaim list. */
+  for (;; GC_sweep_lg++) {
+    if (GC_sweep_lg > MAXOBJGRANULES) {
+      GC_sweep_lg = 1;
+      GC_sweep_kind++;
+    }
+    if (GC_sweep_kind >= GC_sweep_n_kinds) {
+      GC_sweep_pending = FALSE;
+      return FALSE;
+    }
+    ok = &GC_obj_kinds[GC_sweep_kind];
+    rlh = ok->ok_reclaim_list;
+#  ifdef ENABLE_DISCLAIM
+    /* The disclaim procedures are invoked holding the allocator lock. */
+    if (ok->ok_disclaim_proc != 0) {
+      GC_sweep_lg = MAXOBJGRANULES;
+      continue;
+    }
+#  endif
+    if (rlh != NULL && rlh[GC_sweep_lg] != NULL)
+      break;
+  }
+  kind = GC_sweep_kind;
+  lg = GC_sweep_lg;
+
+  /* Detach up to `GC_SWEEP_CHUNK_BLOCKS` blocks from the list head. */
+  rlh += lg;
+  hbp = *rlh;
+  last = hbp;
+  for (n = 1; n < GC_SWEEP_CHUNK_BLOCKS; n++) {
+    struct hblk *next = HDR(last)->hb_next;
+
+    if (NULL == next)
+      break;
+    last = next;
+  }
+  hhdr = HDR(last);
+  *rlh = hhdr->hb_next;
+  hhdr->hb_next = NULL;
+  gc_no = (unsigned short)GC_gc_no;
+  ++GC_fl_builder_count;
+  GC_release_mark_lock();
+
+  sz = GRANULES_TO_BYTES(lg);
+  for (; hbp != NULL; hbp = hhdr->hb_next) {
+    hhdr = HDR(hbp);
+    GC_ASSERT(hhdr->hb_sz == sz);
+    hhdr->hb_last_reclaimed = gc_no;
+    list = GC_reclaim_generic(hbp, hhdr, sz, ok->ok_init, list, &found);
+    if (NULL == tail && list != NULL) {
+      /* Remember the last object to link the list in constant time. */
+      for (tail = list; obj_link(tail) != NULL; tail = (ptr_t)obj_link(tail)) {
+        /* Empty. */
+      }
+    }
+  }
+
+  GC_acquire_mark_lock();
+  if (list != NULL) {
+    obj_link(tail) = GC_swept_fl[kind][lg];
+    GC_swept_fl[kind][lg] = list;
+    GC_swept_bytes += found;
+  }
+  if (0 == --GC_fl_builder_count)
+    GC_notify_all_builder();
+  return TRUE;
+}
+
+GC_INNER void
+GC_finish_parallel_sweep(void)
+{
+  unsigned kind;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  if (GC_parallel_sweep_in_progress) {
+    GC_acquire_mark_lock();
+    GC_sweep_pending = FALSE;
+    GC_release_mark_lock();
+  }
+  GC_wait_for_reclaim();
+  if (!GC_parallel_sweep_in_progress)
+    return;
+
+  /* No marker thread accesses the swept free lists now. */
+  GC_parallel_sweep_in_progress = FALSE;
+  for (kind = 0; kind < GC_n_kinds; kind++) {
+    void **sfl = GC_swept_fl[kind];
+    size_t lg;
+
+    if (NULL == sfl)
+      continue;
+    for (lg = 1; lg <= MAXOBJGRANULES; lg++) {
+      void **flh = &GC_obj_kinds[kind].ok_freelist[lg];
+      void *p = *flh;
+
+      if (NULL == sfl[lg])
+        continue;
+      if (NULL == p) {
+        *flh = sfl[lg];
+      } else {
+        /*
+         * Append to the regular free list, which is expected to be
+         * short (it is refilled from the swept one when it is empty).
+         */
+        while (obj_link(p) != NULL)
+          p = obj_link(p);
+        obj_link(p) = sfl[lg];
+      }
+      sfl[lg] = NULL;
+    }
+  }
+  GC_bytes_found += (GC_signed_word)GC_swept_bytes;
+  GC_swept_bytes = 0;
+}
+#endif /* PARALLEL_SWEEP */
+
 GC_INNER void
 GC_start_reclaim(GC_bool report_if_found)
 {
@@ -855,6 +1057,9 @@ GC_start_reclaim(GC_bool report_if_found)
   GC_ASSERT(I_HOLD_LOCK());
 #ifdef PARALLEL_MARK
   GC_ASSERT(0 == GC_fl_builder_count);
+#endif
+#ifdef PARALLEL_SWEEP
+  GC_ASSERT(!GC_parallel_sweep_in_progress);
 #endif
   /* Reset in-use counters.  `GC_reclaim_block` recomputes them. */
   GC_composite_in_use = 0;
@@ -912,6 +1117,14 @@ GC_start_reclaim(GC_bool report_if_found)
 #ifdef PARALLEL_MARK
   GC_ASSERT(0 == GC_fl_builder_count);
 #endif
+#ifdef PARALLEL_SWEEP
+  if (GC_parallel && !report_if_found && !GC_find_leak_inner)
+    GC_start_parallel_sweep();
+#endif
+#ifdef BACKGROUND_SWEEP
+  if (GC_background_sweep && !report_if_found && !GC_find_leak_inner)
+    GC_notify_sweeper();
+#endif
 }
 
 GC_INNER void
@@ -929,6 +1142,40 @@ GC_continue_reclaim(size_t lg, int kind)
   }
 
   flh = &ok->ok_freelist[lg];
+#ifdef PARALLEL_SWEEP
+  if (GC_parallel_sweep_in_progress) {
+    void **sfl;
+
+    /* Prefer the objects already reclaimed by the marker threads. */
+    GC_acquire_mark_lock();
+    sfl = GC_swept_fl[kind];
+    if (sfl != NULL && sfl[lg] != NULL && NULL == *flh) {
+      *flh = sfl[lg];
+      sfl[lg] = NULL;
+      GC_bytes_found += (GC_signed_word)GC_swept_bytes;
+      GC_swept_bytes = 0;
+      GC_release_mark_lock();
+      return;
+    }
+
+    /*
+     * Otherwise sweep the blocks not taken by the marker threads yet,
+     * one at a time, as the reclaim list is shared with them.
+     */
+    for (rlh += lg; (hbp = *rlh) != NULL;) {
+      const hdr *hhdr = HDR(hbp);
+
+      *rlh = hhdr->hb_next;
+      GC_release_mark_lock();
+      GC_reclaim_small_nonempty_block(hbp, hhdr->hb_sz, FALSE);
+      if (*flh != NULL)
+        return;
+      GC_acquire_mark_lock();
+    }
+    GC_release_mark_lock();
+    return;
+  }
+#endif
   for (rlh += lg; (hbp = *rlh) != NULL;) {
     const hdr *hhdr = HDR(hbp);
 
@@ -957,6 +1204,10 @@ GC_reclaim_all(GC_stop_func stop_func, GC_bool ignore_old)
     GET_TIME(start_time);
 #endif
   GC_ASSERT(I_HOLD_LOCK());
+#ifdef PARALLEL_SWEEP
+  if (GC_parallel_sweep_in_progress)
+    GC_finish_parallel_sweep();
+#endif
 
   for (kind = 0; kind < (int)GC_n_kinds; kind++) {
     rlp = GC_obj_kinds[kind].ok_reclaim_list;
@@ -993,6 +1244,136 @@ GC_reclaim_all(GC_stop_func stop_func, GC_bool ignore_old)
   return TRUE;
 }
 
+#ifdef BACKGROUND_SWEEP
+/*
+ * The maximum number of the reclaim list portions swept by the background
+ * sweeper per one acquisition of the allocator lock.  A portion is what
+ * `GC_continue_reclaim` sweeps at a time, usually a single block.
+ */
+#  ifndef GC_BG_SWEEP_BLOCKS_PER_LOCK
+#    define GC_BG_SWEEP_BLOCKS_PER_LOCK 4
+#  endif
+
+GC_INNER GC_bool GC_background_sweep = FALSE;
+
+/*
+ * The number of times the free list of the given kind and size has been
+ * found empty since the previous pass of the sweeper (decayed by half
+ * at each pass).  The storage is allocated by the sweeper on demand.
+ * Protected by the allocator lock.
+ */
+STATIC unsigned short *GC_sweep_demand[MAXOBJKINDS] = { NULL };
+
+/*
+ * The value of `GC_bytes_allocd` at the previous pass of the sweeper, and
+ * the running average of the amount of bytes allocated between the passes.
+ * Protected by the allocator lock.
+ */
+STATIC word GC_bg_sweep_last_allocd = 0;
+STATIC word GC_bg_sweep_alloc_rate = 0;
+
+GC_INNER void
+GC_note_sweep_demand(size_t lg, int kind)
+{
+  unsigned short *demand = GC_sweep_demand[kind];
+
+  GC_ASSERT(I_HOLD_LOCK());
+  GC_ASSERT(lg <= MAXOBJGRANULES);
+  if (demand != NULL && demand[lg] < (unsigned short)(-1))
+    demand[lg]++;
+}
+
+GC_INNER GC_bool
+GC_sweep_in_background(void)
+{
+  unsigned kind;
+  word allocd, budget;
+  unsigned swept = 0;
+  GC_bool more = FALSE;
+
+  if (!GC_try_lock()) {
+    /* Do not compete with the client threads for the allocator lock. */
+    return TRUE;
+  }
+  if (!GC_background_sweep) {
+    UNLOCK();
+    return FALSE;
+  }
+
+  /*
+   * Estimate the allocation rate.  Let the sweeper be ahead of the
+   * allocators twice the recent amount of allocated bytes.
+   */
+  allocd = GC_bytes_allocd;
+  GC_bg_sweep_alloc_rate = (GC_bg_sweep_alloc_rate
+                            + (allocd >= GC_bg_sweep_last_allocd
+                                   ? allocd - GC_bg_sweep_last_allocd
+                                   : allocd /* a collection occurred */))
+                           >> 1;
+  GC_bg_sweep_last_allocd = allocd;
+  budget = 2 * GC_bg_sweep_alloc_rate / HBLKSIZE + 1;
+
+  for (kind = 0; kind < GC_n_kinds; kind++) {
+    struct obj_kind *ok = &GC_obj_kinds[kind];
+    unsigned short *demand;
+    size_t lg;
+
+#  ifdef ENABLE_DISCLAIM
+    /* Do not invoke the client disclaim procedures from this thread. */
+    if (ok->ok_disclaim_proc != 0)
+      continue;
+#  endif
+    if (NULL == ok->ok_reclaim_list)
+      continue;
+    demand = GC_sweep_demand[kind];
+    if (NULL == demand) {
+      demand = (unsigned short *)GC_scratch_alloc((MAXOBJGRANULES + 1)
+                                                  * sizeof(unsigned short));
+      if (UNLIKELY(NULL == demand))
+        break;
+      BZERO(demand, (MAXOBJGRANULES + 1) * sizeof(unsigned short));
+      GC_sweep_demand[kind] = demand;
+      more = TRUE;
+      continue;
+    }
+
+    for (lg = 1; lg <= MAXOBJGRANULES; lg++) {
+      unsigned n;
+
+#  ifdef PARALLEL_SWEEP
+      /* The reclaim lists are shared with the marker threads otherwise. */
+      if (!GC_parallel_sweep_in_progress)
+#  endif
+      {
+        if (NULL == ok->ok_reclaim_list[lg]) {
+          demand[lg] = 0;
+          continue;
+        }
+      }
+      more = TRUE;
+
+      for (n = demand[lg]; n > 0; n--) {
+        if (0 == budget)
+          goto done;
+        GC_continue_reclaim(lg, (int)kind);
+        budget--;
+        if (++swept % GC_BG_SWEEP_BLOCKS_PER_LOCK == 0) {
+          /* Give the client threads a chance to acquire the lock. */
+          UNLOCK();
+          sched_yield();
+          if (!GC_try_lock())
+            return TRUE;
+        }
+      }
+      demand[lg] >>= 1;
+    }
+  }
+done:
+  UNLOCK();
+  return more;
+}
+#endif /* BACKGROUND_SWEEP */
+
 #if !defined(EAGER_SWEEP) && defined(ENABLE_DISCLAIM)
 /*
  * We do an eager sweep on heap blocks where unconditional marking has
@@ -171,6 +171,7 @@ static CRITICAL_SECTION incr_cs;
 #endif
 
 #ifdef TEST_MANUAL_VDB
+#  include "gc/gc_inline.h" /*< for `GC_PTR_STORE_AND_MARK_CARD` */
 #  define INIT_MANUAL_VDB_ALLOWED GC_set_manual_vdb_allowed(1)
 #else
 #  define INIT_MANUAL_VDB_ALLOWED GC_set_manual_vdb_allowed(0)
@@ -935,7 +936,12 @@ reverse_test_inner(void *data)
   test_generic_malloc_or_special(g);
   g = (sexpr *)checkOOM(GC_REALLOC(g, 800 * sizeof(sexpr)));
   AO_fetch_and_add1(&realloc_count);
+#ifdef TEST_MANUAL_VDB
+  /* Test the card marking barrier on a large object. */
+  GC_PTR_STORE_AND_MARK_CARD(g + 799, ints(1, 18));
+#else
   GC_PTR_STORE_AND_DIRTY(g + 799, ints(1, 18));
+#endif
   h = (sexpr *)checkOOM(GC_MALLOC(1025 * sizeof(sexpr)));
   AO_fetch_and_add1(&collectable_count);
   h = (sexpr *)checkOOM(GC_REALLOC(h, 2000 * sizeof(sexpr)));
@@ -1545,6 +1551,7 @@ run_one_test(void)
 #ifndef NO_TEST_HANDLE_FORK
   pid_t pid;
   int wstatus;
+  int uffdwp_incremental;
 #endif
   struct thr_handle_sb_s thr_handle_sb;
 
@@ -1757,6 +1764,8 @@ run_one_test(void)
   GC_free(checkOOM(GC_malloc(0)));
   GC_freezero(checkOOM(GC_malloc_atomic(0)), GC_SIZE_MAX);
 #ifndef NO_TEST_HANDLE_FORK
+  uffdwp_incremental
+      = GC_is_incremental_mode() && GC_get_actual_vdb() == GC_VDB_UFFDWP;
   GC_atfork_prepare();
   pid = fork();
   if (pid != 0) {
@@ -1779,6 +1788,9 @@ run_one_test(void)
     GC_atfork_child();
     if (print_stats)
       GC_log_printf("Started a child process, pid= %ld\n", (long)child_pid);
+    /* Both modes of `userfaultfd` write-protection work in the child. */
+    if (uffdwp_incremental)
+      TEST_ASSERT(GC_is_incremental_mode());
 #  ifdef PARALLEL_MARK
     /* No parallel markers. */
     GC_gcollect();
@@ -2116,11 +2128,60 @@ check_heap_stats(void)
   /* Get global counters (just to check the functions work). */
   GC_get_heap_usage_safe(NULL, NULL, NULL, NULL, NULL);
   {
-    struct GC_prof_stats_s stats;
-    (void)GC_get_prof_stats(&stats, sizeof(stats));
+    struct GC_prof_stats_s stats, stats2;
+
+    TEST_ASSERT(GC_get_prof_stats(&stats, sizeof(stats)) == sizeof(stats));
+    GC_gcollect();
 #  ifdef THREADS
-    (void)GC_get_prof_stats_unsafe(&stats, sizeof(stats));
+    (void)GC_get_prof_stats_unsafe(&stats2, sizeof(stats2));
 #  endif
+    TEST_ASSERT(GC_get_prof_stats(&stats2, sizeof(stats2)) == sizeof(stats2));
+    /*
+     * The collection might be aborted by `test_stop_func()` (or disabled
+     * temporarily by an exiting thread).
+     */
+    TEST_ASSERT(stats2.gc_no >= stats.gc_no);
+
+    /* The counters do not decrease (the tests are too short to wrap). */
+    TEST_ASSERT(stats2.fl_refill_count >= stats.fl_refill_count);
+    TEST_ASSERT(stats2.fl_refill_bytes >= stats.fl_refill_bytes);
+    /* Each free-list refill provides one object at least. */
+    TEST_ASSERT(stats2.fl_refill_bytes >= stats2.fl_refill_count);
+#  ifndef USE_RWLOCK
+    if (!GC_is_incremental_mode() || !GC_get_manual_vdb_allowed()) {
+      /*
+       * A batch is allocated while holding the allocator lock (unless
+       * a size-class lock is used or the manual VDB mode is on).
+       */
+      GC_word fl_refill_count = stats2.fl_refill_count;
+
+      GC_reachable_here(checkOOM(GC_malloc_many(16)));
+      TEST_ASSERT(GC_get_prof_stats(&stats2, sizeof(stats2))
+                  == sizeof(stats2));
+      TEST_ASSERT(stats2.fl_refill_count > fl_refill_count);
+    }
+#  endif
+
+    if (stats2.lock_acquisitions != ~(GC_word)0) {
+      /* The lock statistics are supported. */
+      TEST_ASSERT(stats2.lock_acquisitions > stats.lock_acquisitions);
+      TEST_ASSERT(stats2.lock_contended_count >= stats.lock_contended_count);
+      TEST_ASSERT(stats2.lock_contended_count <= stats2.lock_acquisitions);
+      TEST_ASSERT(stats2.lock_wait_ns >= stats.lock_wait_ns);
+      if (stats2.lock_max_hold_ns != ~(GC_word)0) {
+        /* The lock is held during the collection. */
+        TEST_ASSERT(stats2.lock_max_hold_ns > 0);
+        TEST_ASSERT(stats2.lock_max_hold_ns >= stats.lock_max_hold_ns);
+      }
+    }
+
+    if (stats2.world_stop_ns != ~(GC_word)0) {
+      /* Many collections have stopped the world by now. */
+      TEST_ASSERT(stats2.world_stop_max_ns > 0);
+      TEST_ASSERT(stats2.world_stop_max_ns >= stats.world_stop_max_ns);
+      TEST_ASSERT(stats2.world_stop_ns >= stats.world_stop_ns);
+      TEST_ASSERT(stats2.world_stop_ns >= stats2.world_stop_max_ns);
+    }
   }
   (void)GC_get_size_map_at(-1);
   (void)GC_get_size_map_at(1);
@@ -2149,6 +2210,119 @@ check_heap_stats(void)
 #endif
 }
 
+#ifndef GC_GET_HEAP_USAGE_NOT_NEEDED
+static sexpr minor_gc_list;
+
+/*
+ * Check that a minor collection updates the nursery statistics and that
+ * the young objects reachable from a root are counted as promoted ones.
+ */
+static void
+test_minor_gc_stats(void)
+{
+  struct GC_prof_stats_s stats;
+  GC_word minor_gc_no, promoted_bytes;
+  int i;
+
+  if (!GC_is_incremental_mode() || GC_get_find_leak()
+      || GC_get_full_freq() == 0) {
+    GC_gcollect_minor();
+    return;
+  }
+
+  /* Start with the partial collections counter reset. */
+  GC_gcollect();
+  TEST_ASSERT(GC_get_prof_stats(&stats, sizeof(stats)) == sizeof(stats));
+  minor_gc_no = stats.minor_gc_no;
+  promoted_bytes = stats.promoted_bytes;
+  for (i = 0; i < 1000; i++) {
+    minor_gc_list = small_cons(minor_gc_list, nil);
+  }
+  GC_gcollect_minor();
+  TEST_ASSERT(GC_get_prof_stats(&stats, sizeof(stats)) == sizeof(stats));
+  TEST_ASSERT(stats.minor_gc_no > minor_gc_no);
+  TEST_ASSERT(stats.nursery_survived_bytes <= stats.nursery_bytes);
+  TEST_ASSERT(stats.promoted_bytes != promoted_bytes);
+  minor_gc_list = nil;
+}
+#endif
+
+#if defined(GC_PTHREADS) && !defined(GC_GET_HEAP_USAGE_NOT_NEEDED)
+static pthread_mutex_t deep_stack_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t deep_stack_cond = PTHREAD_COND_INITIALIZER;
+
+/* 1: the thread waits at the deepest frame; 2: the thread should exit. */
+static int deep_stack_state;
+
+static void
+deep_stack_recurse(unsigned depth)
+{
+  char buf[1024];
+
+  buf[0] = (char)depth;
+  if (depth > 0) {
+    deep_stack_recurse(depth - 1);
+  } else {
+    TEST_ASSERT(pthread_mutex_lock(&deep_stack_lock) == 0);
+    deep_stack_state = 1;
+    TEST_ASSERT(pthread_cond_broadcast(&deep_stack_cond) == 0);
+    while (deep_stack_state != 2) {
+      TEST_ASSERT(pthread_cond_wait(&deep_stack_cond, &deep_stack_lock)
+                  == 0);
+    }
+    TEST_ASSERT(pthread_mutex_unlock(&deep_stack_lock) == 0);
+  }
+  GC_noop1_ptr(buf);
+}
+
+static void *
+deep_stack_thread(void *arg)
+{
+  deep_stack_recurse(64);
+  return arg;
+}
+
+/*
+ * Check that the unchanged cold part of the stack of a thread blocked
+ * in a deep frame is not rescanned by a minor collection.
+ */
+static void
+test_stack_watermarks(void)
+{
+  struct GC_prof_stats_s stats;
+  pthread_t t;
+  int err;
+
+  TEST_ASSERT(GC_get_prof_stats(&stats, sizeof(stats)) == sizeof(stats));
+  if (stats.stack_skipped_bytes == ~(GC_word)0 || !GC_is_incremental_mode()
+      || GC_get_find_leak() || GC_get_full_freq() == 0)
+    return;
+
+  err = pthread_create(&t, NULL, deep_stack_thread, NULL);
+  if (err != 0) {
+    GC_printf("Thread creation failed, errno= %d\n", err);
+    exit(69);
+  }
+  TEST_ASSERT(pthread_mutex_lock(&deep_stack_lock) == 0);
+  while (deep_stack_state != 1) {
+    TEST_ASSERT(pthread_cond_wait(&deep_stack_cond, &deep_stack_lock) == 0);
+  }
+  TEST_ASSERT(pthread_mutex_unlock(&deep_stack_lock) == 0);
+
+  /* The full collection scans the whole stack of the thread. */
+  GC_gcollect();
+  GC_gcollect_minor();
+  TEST_ASSERT(GC_get_prof_stats(&stats, sizeof(stats)) == sizeof(stats));
+  TEST_ASSERT(stats.stack_skipped_bytes > 0);
+
+  TEST_ASSERT(pthread_mutex_lock(&deep_stack_lock) == 0);
+  deep_stack_state = 2;
+  TEST_ASSERT(pthread_cond_broadcast(&deep_stack_cond) == 0);
+  TEST_ASSERT(pthread_mutex_unlock(&deep_stack_lock) == 0);
+  TEST_ASSERT(pthread_join(t, NULL) == 0);
+}
+#endif
+
 static void GC_CALLBACK
 warn_proc(const char *msg, GC_uintptr_t arg)
 {
@@ -2504,6 +2678,18 @@ main(void)
   GC_set_rate(10);
   GC_set_max_prior_attempts(GC_get_max_prior_attempts());
   TEST_ASSERT(GC_get_rate() == 10);
+  GC_set_concurrent_mark(GC_get_concurrent_mark());
+  {
+    int utilization = GC_get_mutator_utilization();
+
+    GC_set_mutator_utilization(100);
+    TEST_ASSERT(GC_get_mutator_utilization() <= 99);
+    GC_set_mutator_utilization(-1);
+    TEST_ASSERT(GC_get_mutator_utilization() == 0);
+    GC_set_mutator_utilization(utilization);
+  }
+  GC_set_background_sweep(GC_get_background_sweep());
+  GC_set_async_unmap(GC_get_async_unmap());
 #if defined(GC_WIN32_THREADS) && !defined(GC_PTHREADS)
   InitializeCriticalSection(&incr_cs);
 #endif
@@ -2544,6 +2730,14 @@ main(void)
 #endif
 
   GC_start_incremental_collection();
+#ifdef GC_GET_HEAP_USAGE_NOT_NEEDED
+  GC_gcollect_minor();
+#else
+  test_minor_gc_stats();
+#endif
+#if defined(GC_PTHREADS) && !defined(GC_GET_HEAP_USAGE_NOT_NEEDED)
+  test_stack_watermarks();
+#endif
   default_stop_func = GC_get_stop_func();
   GC_set_stop_func(test_stop_func);
 #if NTHREADS > 0
@@ -22,6 +22,12 @@
 
 #  include "private/thread_local_alloc.h"
 
+#  ifdef PERCPU_ALLOC
+#    include <stddef.h> /*< for `offsetof` */
+#    include <sys/rseq.h>
+#    include <unistd.h>
+#  endif
+
 #  if defined(USE_COMPILER_TLS)
 __thread GC_ATTR_TLS_FAST
 #  elif defined(USE_WIN32_COMPILER_TLS)
@@ -66,6 +72,13 @@ init_freelists(GC_tlfs p)
 #  ifdef GC_GCJ_SUPPORT
   p->gcj_freelists[0] = MAKE_CPTR(ERROR_FL);
 #  endif
+#  ifdef MEDIUM_TL_ALLOC
+  p->medium_freelists = NULL;
+#  endif
+#  ifdef BUMP_ALLOC
+  BZERO(p->bump_regions, sizeof(p->bump_regions));
+#  endif
+  BZERO(p->refill_bytes, sizeof(p->refill_bytes));
 }
 
 /*
@@ -122,6 +135,40 @@ return_freelists(void **fl, void **gfl)
   }
 }
 
+#  ifdef MEDIUM_TL_ALLOC
+/*
+ * Recover the contents of the medium free-list array `fl` of the given
+ * `kind`.  The small objects are returned to the global free lists, the
+ * large ones are deallocated.
+ */
+static void
+return_medium_freelists(void **fl, int kind)
+{
+  int i;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  for (i = 0; i < MEDIUM_TL_FREELISTS; ++i) {
+    void *q = fl[i];
+
+    if (ADDR(q) >= HBLKSIZE) {
+      if ((size_t)i <= MAXOBJGRANULES - GC_TINY_FREELISTS) {
+        return_single_freelist(
+            q, &GC_obj_kinds[kind].ok_freelist[i + GC_TINY_FREELISTS]);
+      } else {
+        do {
+          void *next = obj_link(q);
+
+          GC_free_internal(q, HDR(q), 0 /* `clear_ofs` */,
+                           0 /* `clear_lb` */);
+          q = next;
+        } while (q != NULL);
+      }
+    }
+    fl[i] = (ptr_t)NUMERIC_TO_VPTR(HBLKSIZE);
+  }
+}
+#  endif
+
 #  ifdef HAS_WIN32_THREADS_DISCOVERY
 static void
 return_freelists_async(void **fl, void **gfl, GC_bool is_async)
@@ -158,6 +205,248 @@ reset_thread_key(void *v)
 #    define reset_thread_key 0
 #  endif
 
+#  ifdef PERCPU_ALLOC
+/*
+ * The per-CPU free lists for the tiny `PTRFREE` and `NORMAL` objects.
+ * These are used instead of the thread-local ones (for these kinds) if
+ * the restartable sequences are registered by `glibc`; an entry is
+ * either `NULL` or a pointer to a nonempty free list.  An object is
+ * popped (and a refilled list is pushed) by a restartable sequence,
+ * i.e. without any lock, and the kernel restarts the sequence if the
+ * thread is preempted, migrated or gets a signal before it commits.
+ * Thus the free lists are consistent whenever the world is stopped.
+ */
+struct percpu_freelists {
+  void *fl[NORMAL + 1][GC_TINY_FREELISTS];
+};
+
+/* The distance between the free lists of adjacent CPUs, in bytes. */
+#    define PERCPU_STRIDE                                      \
+      ((sizeof(struct percpu_freelists) + CACHE_LINE_SIZE - 1) \
+       & ~(size_t)(CACHE_LINE_SIZE - 1))
+
+/*
+ * The per-CPU free lists array and the number of its elements (zero
+ * means the per-CPU free lists are not in use).  Set once while holding
+ * the allocator lock.
+ */
+static ptr_t percpu_base;
+static unsigned percpu_n;
+
+static GC_bool percpu_initialized;
+
+static void
+init_percpu_freelists(void)
+{
+  long n;
+  ptr_t p;
+
+  GC_ASSERT(I_HOLD_LOCK());
+  percpu_initialized = TRUE;
+  if (0 == __rseq_size) {
+    /* The restartable sequences are not registered by `glibc`. */
+    GC_COND_LOG_PRINTF("rseq is unavailable, using thread-local lists\n");
+    return;
+  }
+  n = sysconf(_SC_NPROCESSORS_CONF);
+  if (n <= 0 || (unsigned long)n > GC_SIZE_MAX / PERCPU_STRIDE - 1)
+    return;
+  p = GC_scratch_alloc((size_t)(n + 1) * PERCPU_STRIDE);
+  if (NULL == p) {
+    WARN("Failed to allocate per-CPU free lists\n", 0);
+    return;
+  }
+  p = PTR_ALIGN_UP(p, CACHE_LINE_SIZE);
+  BZERO(p, (size_t)n * PERCPU_STRIDE);
+  percpu_base = p;
+  percpu_n = (unsigned)n;
+  GC_COND_LOG_PRINTF("Using per-CPU free lists for %u CPUs\n", percpu_n);
+}
+
+/* The restartable sequence area of the current thread. */
+#    define RSEQ_AREA() \
+      ((struct rseq *)((ptr_t)__builtin_thread_pointer() + __rseq_offset))
+
+/*
+ * The critical section descriptor (in `__rseq_cs` section) and the abort
+ * handler (preceded by the signature, in `__rseq_failure` section) which
+ * restarts the sequence from label 0 (the descriptor is reinstalled since
+ * the kernel clears `rseq_cs` field on abort).  The critical section is
+ * between labels 1 and 2; the last instruction before label 2 commits.
+ */
+#    define RSEQ_CS_PROLOGUE                    \
+      ".pushsection __rseq_cs, \"aw\"\n\t"      \
+      ".balign 32\n\t"                          \
+      "3:\n\t"                                  \
+      ".long 0, 0\n\t"                          \
+      ".quad 1f, 2f - 1f, 4f\n\t"               \
+      ".popsection\n\t"                         \
+      ".pushsection __rseq_failure, \"ax\"\n\t" \
+      ".byte 0x0f, 0xb9, 0x3d\n\t"              \
+      ".long 0x53053053\n\t"                    \
+      "4:\n\t"                                  \
+      "jmp 0f\n\t"                              \
+      ".popsection\n\t"                         \
+      "0:\n\t"                                  \
+      "leaq 3b(%%rip), %%rax\n\t"               \
+      "movq %%rax, %c[cs_ofs](%[rs])\n\t"       \
+      "1:\n\t"                                  \
+      "movl %c[cpu_ofs](%[rs]), %%eax\n\t"      \
+      "cmpl %k[n], %%eax\n\t"                   \
+      "jae 5f\n\t"                              \
+      "imulq %[stride], %%rax\n\t"              \
+      "addq %[base], %%rax\n\t"
+
+#    define RSEQ_CS_INPUTS                                            \
+      [rs] "r"(RSEQ_AREA()), [n] "r"(percpu_n),                       \
+          [stride] "i"(PERCPU_STRIDE), [base] "r"(percpu_base + ofs), \
+          [cs_ofs] "i"(offsetof(struct rseq, rseq_cs)),               \
+          [cpu_ofs] "i"(offsetof(struct rseq, cpu_id))
+
+/*
+ * Pop an object from the free list located at offset `ofs` of the
+ * per-CPU free lists of the current CPU.  Returns `NULL` if the list is
+ * empty, or `(void *)1` if the current CPU is not covered (e.g. the
+ * thread has no registered restartable sequence area).
+ */
+static void *
+percpu_pop(size_t ofs)
+{
+  void *result;
+
+  __asm__ __volatile__(RSEQ_CS_PROLOGUE
+                       "movq (%%rax), %[result]\n\t"
+                       "testq %[result], %[result]\n\t"
+                       "jz 2f\n\t"
+                       "movq (%[result]), %%rdx\n\t"
+                       "movq %%rdx, (%%rax)\n\t"
+                       "2:\n\t"
+                       "jmp 6f\n\t"
+                       "5:\n\t"
+                       "movl $1, %k[result]\n\t"
+                       "6:\n\t"
+                       : [result] "=&r"(result)
+                       : RSEQ_CS_INPUTS
+                       : "rax", "rdx", "memory", "cc");
+  return result;
+}
+
+/*
+ * Prepend the list of objects from `head` to `tail` to the free list
+ * located at offset `ofs` of the per-CPU free lists of the current CPU.
+ * Returns `FALSE` if the current CPU is not covered.
+ */
+static GC_bool
+percpu_push(size_t ofs, void *head, void *tail)
+{
+  unsigned failed;
+
+  __asm__ __volatile__(RSEQ_CS_PROLOGUE
+                       "movq (%%rax), %%rdx\n\t"
+                       "movq %%rdx, (%[tail])\n\t"
+                       "movq %[head], (%%rax)\n\t"
+                       "2:\n\t"
+                       "xorl %k[failed], %k[failed]\n\t"
+                       "jmp 6f\n\t"
+                       "5:\n\t"
+                       "movl $1, %k[failed]\n\t"
+                       "6:\n\t"
+                       : [failed] "=&r"(failed)
+                       : [head] "r"(head), [tail] "r"(tail), RSEQ_CS_INPUTS
+                       : "rax", "rdx", "memory", "cc");
+  return !failed;
+}
+
+/*
+ * Refill the per-CPU free list (located at offset `ofs`) of the current
+ * CPU with objects of `lg` granules of the given `kind`.  The objects
+ * are obtained to the corresponding (otherwise unused) thread-local free
+ * list of `p` first, so that these are marked if a collection occurs
+ * in between.  If the thread-local free list is not empty (i.e. a batch
+ * was left there by a previous refill, see below), then it is pushed
+ * instead of allocating a new batch.  Returns `FALSE` if out of memory.
+ */
+static GC_bool
+percpu_refill(GC_tlfs p, size_t lg, int kind, size_t ofs)
+{
+  void **my_fl = &p->_freelists[kind][lg];
+  void *tail;
+
+  if (ADDR(*my_fl) <= HBLKSIZE) {
+    *my_fl = NULL;
+    GC_generic_malloc_many(GRANULES_TO_BYTES(0 == lg ? 1 : lg), kind, my_fl);
+    if (UNLIKELY(NULL == *my_fl))
+      return FALSE;
+  }
+  for (tail = *my_fl; obj_link(tail) != NULL; tail = obj_link(tail)) {
+    /* Empty. */
+  }
+
+  /*
+   * No collection could start while we hold the allocator lock, thus
+   * the objects are always reachable by the collector (either from the
+   * thread-local or from the per-CPU free list).
+   */
+  LOCK();
+  if (LIKELY(percpu_push(ofs, *my_fl, tail))) {
+    *my_fl = NULL;
+  } else {
+    /* Leave the objects to the thread-local allocator. */
+  }
+  UNLOCK();
+  return TRUE;
+}
+
+/*
+ * Allocate a tiny object of `lg` granules of the given `kind` from the
+ * per-CPU free lists.  Returns `NULL` if the thread-local free lists
+ * should be used instead.
+ */
+static void *
+percpu_malloc(GC_tlfs p, size_t lg, int kind)
+{
+  size_t ofs = ((size_t)kind * GC_TINY_FREELISTS + lg) * sizeof(void *);
+
+  GC_ASSERT(kind <= NORMAL && lg < GC_TINY_FREELISTS);
+  for (;;) {
+    void *result = percpu_pop(ofs);
+
+    if (LIKELY(ADDR(result) > 1)) {
+      if (kind != PTRFREE) {
+        obj_link(result) = NULL;
+      }
+      GC_ASSERT(GC_size(result) >= GRANULES_TO_BYTES(0 == lg ? 1 : lg));
+      return result;
+    }
+    if (result != NULL)
+      return NULL;
+    if (UNLIKELY(!percpu_refill(p, lg, kind, ofs)))
+      return (*GC_get_oom_fn())(GRANULES_TO_BYTES(0 == lg ? 1 : lg));
+  }
+}
+
+GC_INNER void
+GC_mark_percpu_freelists(void)
+{
+  unsigned cpu;
+
+  for (cpu = 0; cpu < percpu_n; ++cpu) {
+    const struct percpu_freelists *pcfl
+        = (const struct percpu_freelists *)(percpu_base + cpu * PERCPU_STRIDE);
+    int kind, j;
+
+    for (kind = 0; kind <= NORMAL; ++kind) {
+      for (j = 0; j < GC_TINY_FREELISTS; ++j) {
+        ptr_t q = GC_cptr_load((volatile ptr_t *)&pcfl->fl[kind][j]);
+
+        if (q != NULL)
+          GC_set_fl_marks(q);
+      }
+    }
+  }
+}
+#  endif /* PERCPU_ALLOC */
+
 GC_INNER void
 GC_init_thread_local(GC_tlfs p)
 {
@@ -172,6 +461,10 @@ GC_init_thread_local(GC_tlfs p)
       ABORT("Failed to create key for local allocator");
     keys_initialized = TRUE;
   }
+#  endif
+#  ifdef PERCPU_ALLOC
+  if (UNLIKELY(!percpu_initialized))
+    init_percpu_freelists();
 #  endif
   init_freelists(p);
 #  if !defined(USE_COMPILER_TLS) && !defined(USE_WIN32_COMPILER_TLS)
@@ -211,6 +504,34 @@ GC_destroy_thread_local(GC_tlfs p)
   return_freelists_async(p->gcj_freelists, (void **)GC_gcjobjfreelist,
                          is_async);
 #  endif
+#  ifdef MEDIUM_TL_ALLOC
+  if (p->medium_freelists != NULL) {
+#    ifdef HAS_WIN32_THREADS_DISCOVERY
+    /*
+     * The allocator lock is not held in the asynchronous case, thus the
+     * objects are not returned to the global free lists; instead, the
+     * array and the objects of its free lists become unreachable (once
+     * the array is detached from `p`) and are reclaimed during the next
+     * garbage collection.
+     */
+    if (!is_async)
+#    endif
+    {
+      for (kind = 0; kind <= NORMAL; ++kind) {
+        return_medium_freelists(p->medium_freelists[kind], kind);
+      }
+      GC_INTERNAL_FREE(p->medium_freelists);
+    }
+    p->medium_freelists = NULL;
+  }
+#  endif
+#  ifdef BUMP_ALLOC
+  /*
+   * The objects remaining in the bump regions are unmarked now, thus
+   * these will be reclaimed during the next garbage collection.
+   */
+  BZERO(p->bump_regions, sizeof(p->bump_regions));
+#  endif
 }
 
 STATIC void *
@@ -235,6 +556,159 @@ GC_get_tlfs(void)
 #  endif
 }
 
+#  ifdef SAFEPOINT_STOP_WORLD
+GC_INNER void
+GC_safepoint_park(void)
+{
+  void *tsd = GC_get_tlfs();
+
+  /* Only a registered thread could be parked. */
+  if (tsd != NULL)
+    GC_with_callee_saves_pushed(GC_safepoint_park_self, (ptr_t)tsd);
+}
+#  endif
+
+#  ifdef MEDIUM_TL_ALLOC
+/*
+ * Allocate and initialize the medium free lists of `p`.  Returns `FALSE`
+ * if out of memory.
+ */
+static GC_bool
+alloc_medium_freelists(GC_tlfs p)
+{
+  void *(*fls)[MEDIUM_TL_FREELISTS];
+
+  LOCK();
+  fls = (void *(*)[MEDIUM_TL_FREELISTS])GC_INTERNAL_MALLOC(
+      (NORMAL + 1) * sizeof(*fls), NORMAL);
+  if (LIKELY(fls != NULL)) {
+    int kind, j;
+
+    for (kind = 0; kind <= NORMAL; ++kind) {
+      for (j = 0; j < MEDIUM_TL_FREELISTS; ++j) {
+        fls[kind][j] = NUMERIC_TO_VPTR(1);
+      }
+    }
+    p->medium_freelists = fls;
+    GC_dirty(p);
+  }
+  UNLOCK();
+  return fls != NULL;
+}
+
+/*
+ * Allocate a medium `PTRFREE` or `NORMAL` object of `lb` bytes (`lg`
+ * is the requested size in granules) from the thread-local free lists
+ * of `p`.  The logic is the same as that of `GC_FAST_MALLOC_GRANS()`
+ * except for the size class selection.
+ */
+static void *
+medium_malloc(GC_tlfs p, size_t lb, size_t lg, int kind)
+{
+  size_t i;
+  void **my_fl;
+
+  /*
+   * The allocation counter stored in a free-list entry (see below) should
+   * never reach `HBLKSIZE` to be distinguishable from a pointer.
+   */
+  GC_STATIC_ASSERT(DIRECT_GRANULES
+                       + BYTES_TO_GRANULES(MEDIUM_MAX_HBLKS * HBLKSIZE) + 1
+                   < HBLKSIZE);
+  GC_ASSERT(kind <= NORMAL && lg >= GC_TINY_FREELISTS);
+  if (SMALL_OBJ(lb)) {
+    lg = GC_size_map[lb];
+    if (UNLIKELY(0 == lg)) {
+      /* The size map entry is not filled in yet. */
+      return GC_malloc_kind_global(lb, kind);
+    }
+    i = lg - GC_TINY_FREELISTS;
+  } else {
+    size_t n_blocks;
+
+    if (lb > MEDIUM_MAX_HBLKS * HBLKSIZE)
+      return GC_malloc_kind_global(lb, kind);
+    n_blocks = OBJ_SZ_TO_BLOCKS(GRANULES_TO_BYTES(lg));
+    if (n_blocks > MEDIUM_MAX_HBLKS)
+      return GC_malloc_kind_global(lb, kind);
+    lg = BYTES_TO_GRANULES(n_blocks * HBLKSIZE);
+    i = MAXOBJGRANULES - GC_TINY_FREELISTS + n_blocks;
+  }
+  GC_ASSERT(i < (size_t)MEDIUM_TL_FREELISTS);
+  if (UNLIKELY(NULL == p->medium_freelists)
+      && !alloc_medium_freelists(p))
+    return GC_malloc_kind_global(lb, kind);
+  my_fl = &p->medium_freelists[kind][i];
+  for (;;) {
+    void *entry = *my_fl;
+
+    if (LIKELY(ADDR(entry) >= HBLKSIZE)) {
+      void *next = obj_link(entry);
+
+      GC_FAST_M_AO_STORE(my_fl, next);
+      if (kind != PTRFREE) {
+        obj_link(entry) = NULL;
+        GC_end_stubborn_change(my_fl);
+        GC_reachable_here(next);
+      }
+      GC_ASSERT(GC_size(entry) >= lb);
+      return entry;
+    }
+    if (entry != NULL && ADDR(entry) <= DIRECT_GRANULES) {
+      /* Too few objects of this size have been allocated yet. */
+      GC_FAST_M_AO_STORE(my_fl, (ptr_t)entry + lg + 1);
+      return GC_malloc_kind_global(lb, kind);
+    }
+    GC_generic_malloc_many(GRANULES_TO_BYTES(lg), kind, my_fl);
+    if (UNLIKELY(NULL == *my_fl))
+      return (*GC_get_oom_fn())(lb);
+  }
+}
+#  endif /* MEDIUM_TL_ALLOC */
+
+/*
+ * Return the size of the batch of objects to refill the tiny free list
+ * (or the bump region) of the given `kind` and size `lg` of `p` with.
+ * The size is adapted to the allocation rate of the objects by the
+ * thread relative to the collection frequency: the batch is doubled if
+ * the previous one has been used up within the current collection cycle,
+ * and halved if a whole cycle has passed since the previous refill (thus
+ * a rarely allocating thread does not retain a block of objects per size
+ * for a long time).  The first batch is of `HBLKSIZE` bytes.  A racy
+ * read of `GC_gc_no` is fine here.
+ */
+GC_ATTR_NO_SANITIZE_THREAD
+static size_t
+next_refill_bytes(GC_tlfs p, int kind, size_t lg)
+{
+  unsigned short gc_no = (unsigned short)GC_gc_no;
+  unsigned short last_gc_no = p->refill_gc_no[kind][lg];
+  size_t batch_bytes = p->refill_bytes[kind][lg];
+
+  if (UNLIKELY(0 == batch_bytes)) {
+    batch_bytes = HBLKSIZE;
+  } else if (last_gc_no == gc_no) {
+    if (batch_bytes < MAX_REFILL_HBLKS * HBLKSIZE)
+      batch_bytes *= 2;
+  } else if ((unsigned short)(gc_no - last_gc_no) > 1) {
+    if (batch_bytes / 2 >= MIN_REFILL_BYTES)
+      batch_bytes /= 2;
+  }
+  p->refill_bytes[kind][lg] = (unsigned)batch_bytes;
+  p->refill_gc_no[kind][lg] = gc_no;
+  return batch_bytes;
+}
+
+/*
+ * Check whether the tiny free list entry `fl_entry` requires a refill
+ * (see `GC_FAST_MALLOC_GRANS()`).
+ */
+#  define TINY_FL_NEEDS_REFILL(fl_entry)            \
+    (0 == ADDR(fl_entry)                            \
+     || (ADDR(fl_entry) > DIRECT_GRANULES           \
+         && ADDR(fl_entry)                          \
+                <= DIRECT_GRANULES + GC_TINY_FREELISTS + 1))
+
 GC_API GC_ATTR_MALLOC void *GC_CALL
 GC_malloc_kind(size_t lb, int kind)
 {
@@ -252,7 +726,58 @@ GC_malloc_kind(size_t lb, int kind)
 
   GC_ASSERT(GC_is_initialized);
   GC_ASSERT(GC_is_thread_tsd_valid(tsd));
+  GC_SAFEPOINT_POLL();
   lg = ALLOC_REQUEST_GRANS(lb);
+#  ifdef PERCPU_ALLOC
+  if (percpu_n > 0 && kind <= NORMAL && LIKELY(lg < GC_TINY_FREELISTS)) {
+    result = percpu_malloc((GC_tlfs)tsd, lg, kind);
+    if (LIKELY(result != NULL))
+      return result;
+  }
+#  endif
+#  ifdef BUMP_ALLOC
+  if (kind <= NORMAL && LIKELY(lg < GC_TINY_FREELISTS)) {
+    struct bump_region *r = &((GC_tlfs)tsd)->bump_regions[kind][lg];
+    size_t lb_adjusted = GRANULES_TO_BYTES(0 == lg ? 1 : lg);
+
+    result = r->cur;
+    if (UNLIKELY(ADDR(result) + lb_adjusted > ADDR(r->limit))) {
+      void **my_fl = &((GC_tlfs)tsd)->_freelists[kind][lg];
+
+      /*
+       * Get a fresh block instead of refilling the free list (see
+       * `GC_FAST_MALLOC_GRANS()`), unless there are swept objects.
+       */
+      if (TINY_FL_NEEDS_REFILL(*my_fl)) {
+        GC_generic_malloc_many_bump(
+            lb_adjusted, kind, my_fl,
+            next_refill_bytes((GC_tlfs)tsd, kind, lg), r);
+        result = r->cur;
+      }
+    }
+    if (LIKELY(ADDR(result) + lb_adjusted <= ADDR(r->limit))) {
+      r->cur = (ptr_t)result + lb_adjusted;
+      if (kind != PTRFREE)
+        BZERO(result, lb_adjusted);
+      return result;
+    }
+  }
+#  endif
+#  ifdef MEDIUM_TL_ALLOC
+  if (kind <= NORMAL && lg >= GC_TINY_FREELISTS)
+    return medium_malloc((GC_tlfs)tsd, lb, lg, kind);
+#  endif
+#  ifndef BUMP_ALLOC
+  if (kind <= NORMAL && LIKELY(lg < GC_TINY_FREELISTS)) {
+    void **my_fl = &((GC_tlfs)tsd)->_freelists[kind][lg];
+
+    if (TINY_FL_NEEDS_REFILL(*my_fl)) {
+      GC_generic_malloc_many_batch(GRANULES_TO_BYTES(0 == lg ? 1 : lg), kind,
+                                   my_fl,
+                                   next_refill_bytes((GC_tlfs)tsd, kind, lg));
+    }
+  }
+#  endif
   GC_FAST_MALLOC_GRANS(
       result, lg, ((GC_tlfs)tsd)->_freelists[kind], DIRECT_GRANULES, kind,
       GC_malloc_kind_global(lb, kind),
@@ -339,6 +864,50 @@ GC_gcj_malloc(size_t lb, const void *vtable_ptr)
 
 #  endif /* GC_GCJ_SUPPORT */
 
+#  ifdef BUMP_ALLOC
+/*
+ * Mark all the objects not yet allocated from the given region.
+ * Such objects are cleared on demand, i.e. might contain garbage, while
+ * the mark bits are not cleared by a partial collection and the marked
+ * objects on the dirty pages are scanned by the next one.  Thus the
+ * objects of a non-atomic kind are cleared here before marking them.
+ * An object already marked is skipped: it has been cleared by a previous
+ * collection (and is not written by the owner thread till allocated),
+ * unless it was marked (and traced) by a false pointer.  Note: the owner
+ * thread, stopped in the middle of the allocation, may clear the object
+ * at `cur` once again, which is harmless.
+ */
+static void
+set_bump_region_marks(const struct bump_region *r)
+{
+  ptr_t p = r->cur;
+  ptr_t limit = r->limit;
+  struct hblk *h;
+  hdr *hhdr;
+  size_t sz;
+  GC_bool clear;
+
+  if (NULL == p || ADDR_GE(p, limit))
+    return;
+
+  h = HBLKPTR(p);
+  hhdr = HDR(h);
+  sz = hhdr->hb_sz;
+  clear = !IS_PTRFREE(hhdr);
+  GC_ASSERT(HBLKPTR(limit - 1) == h);
+  for (; ADDR_LT(p, limit); p += sz) {
+    size_t bit_no = MARK_BIT_NO((size_t)(p - (ptr_t)h), sz);
+
+    if (!mark_bit_from_hdr(hhdr, bit_no)) {
+      if (clear)
+        BZERO(p, sz);
+      set_mark_bit_from_hdr(hhdr, bit_no);
+      INCR_MARKS(hhdr);
+    }
+  }
+}
+#  endif
+
 GC_INNER void
 GC_mark_thread_local_fls_for(GC_tlfs p)
 {
@@ -356,6 +925,10 @@ GC_mark_thread_local_fls_for(GC_tlfs p)
 
       if (ADDR(q) > HBLKSIZE)
         GC_set_fl_marks(q);
+#  ifdef BUMP_ALLOC
+      if (kind <= NORMAL)
+        set_bump_region_marks(&p->bump_regions[kind][j]);
+#  endif
     }
 #  ifdef GC_GCJ_SUPPORT
     if (LIKELY(j > 0)) {
@@ -366,6 +939,21 @@ GC_mark_thread_local_fls_for(GC_tlfs p)
     }
 #  endif
   }
+#  ifdef MEDIUM_TL_ALLOC
+  if (p->medium_freelists != NULL) {
+    for (j = 0; j < MEDIUM_TL_FREELISTS; ++j) {
+      int kind;
+
+      for (kind = 0; kind <= NORMAL; ++kind) {
+        ptr_t q
+            = GC_cptr_load((volatile ptr_t *)&p->medium_freelists[kind][j]);
+
+        if (ADDR(q) > HBLKSIZE)
+          GC_set_fl_marks(q);
+      }
+    }
+  }
+#  endif
 }
 
 #  if defined(GC_ASSERTIONS)
@@ -383,7 +971,36 @@ GC_check_tls_for(GC_tlfs p)
     GC_check_fl_marks(&p->gcj_freelists[j]);
 #    endif
   }
+#    ifdef MEDIUM_TL_ALLOC
+  if (p->medium_freelists != NULL) {
+    for (j = 0; j < MEDIUM_TL_FREELISTS; ++j) {
+      for (kind = 0; kind <= NORMAL; ++kind) {
+        GC_check_fl_marks(&p->medium_freelists[kind][j]);
+      }
+    }
+  }
+#    endif
+}
+
+#    ifdef PERCPU_ALLOC
+void
+GC_check_percpu_freelists(void)
+{
+  unsigned cpu;
+
+  for (cpu = 0; cpu < percpu_n; ++cpu) {
+    struct percpu_freelists *pcfl
+        = (struct percpu_freelists *)(percpu_base + cpu * PERCPU_STRIDE);
+    int kind, j;
+
+    for (kind = 0; kind <= NORMAL; ++kind) {
+      for (j = 0; j < GC_TINY_FREELISTS; ++j) {
+        GC_check_fl_marks(&pcfl->fl[kind][j]);
+      }
+    }
+  }
 }
+#    endif
 #  endif
 
 #endif /* THREAD_LOCAL_ALLOC */